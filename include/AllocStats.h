@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// The replacement operator new / delete in main.cpp is a debug hook: on by
+// default in builds without NDEBUG, switched with -DALLOC_TRACKING=0/1. When
+// it is off the counters below stay at zero.
+#ifndef ALLOC_TRACKING
+#ifdef NDEBUG
+#define ALLOC_TRACKING 0
+#else
+#define ALLOC_TRACKING 1
+#endif
+#endif
+
+// Global heap counters, bumped by the replacement operator new / delete in
+// main.cpp (so everything that goes through new, including std containers and
+// Arena blocks, is counted).
+struct AllocCounters {
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> frees{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+};
+
+inline AllocCounters& GetAllocCounters() {
+    static AllocCounters counters;
+    return counters;
+}
+
+struct AllocSnapshot {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+
+    static AllocSnapshot Now() {
+        const AllocCounters& c = GetAllocCounters();
+        return { c.allocations.load(std::memory_order_relaxed), c.bytes.load(std::memory_order_relaxed) };
+    }
+
+    AllocSnapshot Since(const AllocSnapshot& earlier) const {
+        return { allocations - earlier.allocations, bytes - earlier.bytes };
+    }
+};
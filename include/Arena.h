@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+
+// Monotonic bump allocator. Allocations are never freed one by one; Reset()
+// rewinds to the start and keeps the blocks for reuse, the destructor frees them.
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+    ~Arena() {
+        for (const Block& b : blocks) ::operator delete(b.data);
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        while (current < blocks.size()) {
+            Block& b = blocks[current];
+            size_t at = AlignedOffset(b.data, offset, align);
+            if (at + size <= b.size) {
+                offset = at + size;
+                used += size;
+                return b.data + at;
+            }
+            ++current;
+            offset = 0;
+        }
+
+        size_t bytes = std::max(blockSize, size + align);
+        auto* data = static_cast<unsigned char*>(::operator new(bytes));
+        blocks.push_back({ data, bytes });
+        current = blocks.size() - 1;
+        size_t at = AlignedOffset(data, 0, align);
+        offset = at + size;
+        used += size;
+        return data + at;
+    }
+
+    // Uninitialized storage for `count` objects; only for trivially destructible types.
+    template <class T>
+    T* AllocArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena never runs destructors");
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    void Reset() {
+        current = 0;
+        offset = 0;
+        used = 0;
+    }
+
+    size_t BytesUsed() const { return used; }
+    size_t BytesReserved() const {
+        size_t n = 0;
+        for (const Block& b : blocks) n += b.size;
+        return n;
+    }
+
+private:
+    struct Block {
+        unsigned char* data;
+        size_t size;
+    };
+
+    static size_t AlignedOffset(const unsigned char* base, size_t offset, size_t align) {
+        uintptr_t p = (uintptr_t)(base + offset);
+        return offset + (size_t)(((p + align - 1) & ~(uintptr_t)(align - 1)) - p);
+    }
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t offset = 0;
+    size_t used = 0;
+};
@@ -0,0 +1,224 @@
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+enum class RenderPass { Shadow = 0, Main, Debug, Count };
+
+inline const char* RenderPassName(RenderPass p) {
+    switch (p) {
+    case RenderPass::Shadow: return "shadow";
+    case RenderPass::Main: return "main";
+    case RenderPass::Debug: return "debug";
+    default: return "?";
+    }
+}
+
+struct PassStats {
+    uint32_t submitted = 0;
+    uint32_t culled = 0;
+    // Members of LOD groups drawn at another level this frame.
+    uint32_t lodSkipped = 0;
+    uint32_t drawCalls = 0;
+    uint64_t triangles = 0;
+};
+
+struct MemoryStats {
+    uint64_t gpuVertexBytes = 0;
+    uint64_t gpuIndexBytes = 0;
+    uint64_t gpuShadowBytes = 0;
+    uint64_t gpuTargetBytes = 0;
+    uint64_t gpuInstanceBytes = 0;
+    uint64_t gpuImpostorBytes = 0;
+    uint64_t gpuTerrainBytes = 0;
+    // Scene items: component chunks, the transform hierarchy and prefabs.
+    uint64_t cpuItemBytes = 0;
+    // Mesh library copies, LOD groups and the frame arena's blocks.
+    uint64_t cpuOtherBytes = 0;
+
+    uint64_t GpuTotal() const { return gpuVertexBytes + gpuIndexBytes + gpuShadowBytes + gpuTargetBytes + gpuInstanceBytes + gpuImpostorBytes + gpuTerrainBytes; }
+    uint64_t CpuTotal() const { return cpuItemBytes + cpuOtherBytes; }
+};
+
+// Lot streaming (all zero when it is off): lots resident and being built,
+// and how many were merged and dropped this frame.
+struct StreamStats {
+    uint32_t resident = 0;
+    uint32_t loading = 0;
+    uint32_t merged = 0;
+    uint32_t evicted = 0;
+    uint64_t residentBytes = 0;
+};
+
+struct FrameStats {
+    uint64_t frame = 0;
+    double frameMs = 0.0;
+
+    PassStats pass[(int)RenderPass::Count];
+    uint32_t uniformUploads = 0;
+    uint64_t bufferBytesUploaded = 0;
+    uint32_t heapAllocs = 0;
+    uint64_t heapBytes = 0;
+    uint64_t scratchBytes = 0;
+    MemoryStats mem;
+    StreamStats stream;
+
+    PassStats& Pass(RenderPass p) { return pass[(int)p]; }
+    const PassStats& Pass(RenderPass p) const { return pass[(int)p]; }
+
+    uint32_t TotalDrawCalls() const {
+        uint32_t n = 0;
+        for (const auto& p : pass) n += p.drawCalls;
+        return n;
+    }
+    uint64_t TotalTriangles() const {
+        uint64_t n = 0;
+        for (const auto& p : pass) n += p.triangles;
+        return n;
+    }
+};
+
+// Counters for the frame being recorded live in Current(); EndFrame() publishes
+// them to Last(), which is what callers should query.
+class FrameStatsRecorder {
+public:
+    FrameStats& Current() { return cur; }
+    const FrameStats& Last() const { return last; }
+
+    void BeginFrame(uint64_t frame) {
+        MemoryStats mem = cur.mem;
+        cur = FrameStats();
+        cur.frame = frame;
+        cur.mem = mem;
+    }
+
+    void EndFrame(double frameMs) {
+        cur.frameMs = frameMs;
+        last = cur;
+    }
+
+    void Draw(RenderPass p, uint64_t trianglesPerDraw, uint32_t instances = 1) {
+        PassStats& ps = cur.Pass(p);
+        ps.drawCalls++;
+        ps.triangles += trianglesPerDraw * instances;
+    }
+
+    void Uniforms(uint32_t n) { cur.uniformUploads += n; }
+    void Heap(uint32_t allocs, uint64_t bytes) {
+        cur.heapAllocs = allocs;
+        cur.heapBytes = bytes;
+    }
+    void Upload(uint64_t bytes) { cur.bufferBytesUploaded += bytes; }
+
+private:
+    FrameStats cur;
+    FrameStats last;
+};
+
+inline FrameStatsRecorder& GetFrameStats() {
+    static FrameStatsRecorder rec;
+    return rec;
+}
+
+inline void PrintFrameStats(const FrameStats& s) {
+    std::printf("[Stats] frame %llu  %.2f ms  draws %u  tris %llu  uniforms %u  upload %llu B  heap %u (%llu B)  scratch %llu B\n",
+        (unsigned long long)s.frame, s.frameMs, s.TotalDrawCalls(),
+        (unsigned long long)s.TotalTriangles(), s.uniformUploads,
+        (unsigned long long)s.bufferBytesUploaded, s.heapAllocs,
+        (unsigned long long)s.heapBytes, (unsigned long long)s.scratchBytes);
+    for (int i = 0; i < (int)RenderPass::Count; ++i) {
+        const PassStats& p = s.pass[i];
+        if (p.submitted == 0 && p.drawCalls == 0) continue;
+        std::printf("        %-6s submitted %u  culled %u  lod skipped %u  draws %u  tris %llu\n",
+            RenderPassName((RenderPass)i), p.submitted, p.culled, p.lodSkipped, p.drawCalls,
+            (unsigned long long)p.triangles);
+    }
+    if (s.stream.resident > 0 || s.stream.loading > 0) {
+        std::printf("        stream resident %u (%.2f MB)  loading %u  merged %u  evicted %u\n",
+            s.stream.resident, s.stream.residentBytes / (1024.0 * 1024.0), s.stream.loading, s.stream.merged, s.stream.evicted);
+    }
+    std::printf("        gpu %.2f MB (vbo %llu, ebo %llu, shadow %llu, targets %llu, instances %llu, impostors %llu, terrain %llu)  cpu %.2f MB (items %llu, other %llu)\n",
+        s.mem.GpuTotal() / (1024.0 * 1024.0),
+        (unsigned long long)s.mem.gpuVertexBytes, (unsigned long long)s.mem.gpuIndexBytes,
+        (unsigned long long)s.mem.gpuShadowBytes, (unsigned long long)s.mem.gpuTargetBytes,
+        (unsigned long long)s.mem.gpuInstanceBytes, (unsigned long long)s.mem.gpuImpostorBytes,
+        (unsigned long long)s.mem.gpuTerrainBytes,
+        s.mem.CpuTotal() / (1024.0 * 1024.0),
+        (unsigned long long)s.mem.cpuItemBytes, (unsigned long long)s.mem.cpuOtherBytes);
+    std::fflush(stdout);
+}
+
+struct BenchResult {
+    int warmupFrames = 0;
+    // The workload: lot count (--lots) and items in the scene; resident ones
+    // when streaming.
+    uint32_t lots = 1;
+    uint64_t items = 0;
+    std::vector<double> frameMs;
+    FrameStats last;
+
+    // Heap activity in measured frames; anything non-zero fails the bench.
+    // Only counted when the build has the allocation hook (ALLOC_TRACKING).
+    bool allocTracked = true;
+    uint64_t heapAllocs = 0;
+    uint32_t allocatingFrames = 0;
+    uint64_t firstAllocatingFrame = 0;
+
+    void Record(const FrameStats& s) {
+        frameMs.push_back(s.frameMs);
+        if (s.heapAllocs == 0) return;
+        if (allocatingFrames++ == 0) firstAllocatingFrame = s.frame;
+        heapAllocs += s.heapAllocs;
+    }
+
+    bool AllocationFree() const { return heapAllocs == 0; }
+};
+
+inline bool WriteBenchJson(const char* path, const BenchResult& r) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+
+    std::vector<double> sorted = r.frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (double v : sorted) sum += v;
+    size_t n = sorted.size();
+    double avg = n ? sum / (double)n : 0.0;
+    double p50 = n ? sorted[n / 2] : 0.0;
+    double p95 = n ? sorted[std::min(n - 1, (size_t)((double)n * 0.95))] : 0.0;
+    double mn = n ? sorted.front() : 0.0;
+    double mx = n ? sorted.back() : 0.0;
+
+    const FrameStats& s = r.last;
+    std::fprintf(f, "{\n");
+    std::fprintf(f, "  \"frames\": %zu,\n  \"warmupFrames\": %d,\n", n, r.warmupFrames);
+    std::fprintf(f, "  \"lots\": %u,\n  \"items\": %llu,\n", r.lots, (unsigned long long)r.items);
+    std::fprintf(f, "  \"frameMs\": { \"avg\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"max\": %.4f },\n",
+        avg, mn, p50, p95, mx);
+    std::fprintf(f, "  \"allocationTracked\": %s,\n", r.allocTracked ? "true" : "false");
+    std::fprintf(f, "  \"heapAllocations\": %llu,\n  \"allocatingFrames\": %u,\n  \"allocationFree\": %s,\n",
+        (unsigned long long)r.heapAllocs, r.allocatingFrames, r.AllocationFree() ? "true" : "false");
+    std::fprintf(f, "  \"drawCalls\": %u,\n  \"triangles\": %llu,\n  \"uniformUploads\": %u,\n  \"bufferBytesUploaded\": %llu,\n",
+        s.TotalDrawCalls(), (unsigned long long)s.TotalTriangles(), s.uniformUploads,
+        (unsigned long long)s.bufferBytesUploaded);
+    std::fprintf(f, "  \"stream\": { \"resident\": %u, \"loading\": %u, \"residentBytes\": %llu },\n",
+        s.stream.resident, s.stream.loading, (unsigned long long)s.stream.residentBytes);
+    std::fprintf(f, "  \"passes\": {\n");
+    for (int i = 0; i < (int)RenderPass::Count; ++i) {
+        const PassStats& p = s.pass[i];
+        std::fprintf(f, "    \"%s\": { \"submitted\": %u, \"culled\": %u, \"lodSkipped\": %u, \"drawCalls\": %u, \"triangles\": %llu }%s\n",
+            RenderPassName((RenderPass)i), p.submitted, p.culled, p.lodSkipped, p.drawCalls,
+            (unsigned long long)p.triangles, (i + 1 < (int)RenderPass::Count) ? "," : "");
+    }
+    std::fprintf(f, "  },\n");
+    std::fprintf(f, "  \"memory\": { \"gpuVertexBytes\": %llu, \"gpuIndexBytes\": %llu, \"gpuShadowBytes\": %llu, \"gpuTargetBytes\": %llu, \"gpuInstanceBytes\": %llu, \"gpuImpostorBytes\": %llu, \"gpuTerrainBytes\": %llu, \"cpuItemBytes\": %llu, \"cpuOtherBytes\": %llu }\n",
+        (unsigned long long)s.mem.gpuVertexBytes, (unsigned long long)s.mem.gpuIndexBytes,
+        (unsigned long long)s.mem.gpuShadowBytes, (unsigned long long)s.mem.gpuTargetBytes,
+        (unsigned long long)s.mem.gpuInstanceBytes, (unsigned long long)s.mem.gpuImpostorBytes,
+        (unsigned long long)s.mem.gpuTerrainBytes, (unsigned long long)s.mem.cpuItemBytes, (unsigned long long)s.mem.cpuOtherBytes);
+    std::fprintf(f, "}\n");
+    std::fclose(f);
+    return true;
+}
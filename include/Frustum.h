@@ -0,0 +1,42 @@
+#pragma once
+#include <cmath>
+#include <glm/glm.hpp>
+
+// Six planes (ax + by + cz + d >= 0 inside) pulled out of a view-projection
+// matrix (Gribb/Hartmann). Works for both perspective and orthographic.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& m) {
+        glm::vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        Frustum f;
+        f.planes[0] = r3 + r0;
+        f.planes[1] = r3 - r0;
+        f.planes[2] = r3 + r1;
+        f.planes[3] = r3 - r1;
+        f.planes[4] = r3 + r2;
+        f.planes[5] = r3 - r2;
+        return f;
+    }
+
+    bool IntersectsAabb(const glm::vec3& mn, const glm::vec3& mx) const {
+        for (const glm::vec4& p : planes) {
+            // Corner furthest along the plane normal.
+            glm::vec3 v(p.x >= 0.0f ? mx.x : mn.x, p.y >= 0.0f ? mx.y : mn.y, p.z >= 0.0f ? mx.z : mn.z);
+            if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f) return false;
+        }
+        return true;
+    }
+
+    bool IntersectsSphere(const glm::vec3& c, float r) const {
+        for (const glm::vec4& p : planes) {
+            glm::vec3 n(p);
+            if (glm::dot(n, c) + p.w < -r * glm::length(n)) return false;
+        }
+        return true;
+    }
+};
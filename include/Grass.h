@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+// Blade field over the terrain, generated in the vertex shader: a chunk is a
+// `chunkSize` square at (x, z) * chunkSize, its blades scattered from a hash
+// of the chunk and `seed`. Nothing per blade exists on the CPU.
+struct GrassParams {
+    float chunkSize = 16.0f;
+    // Blades in a chunk at full density.
+    int bladesPerChunk = 8192;
+    // Full density up to fadeStart from the eye, none past fadeEnd.
+    float fadeStart = 60.0f;
+    float fadeEnd = 160.0f;
+    // Blade base width and height; each blade scales the height.
+    glm::vec2 bladeSize{ 0.10f, 0.55f };
+    uint32_t seed = 0;
+};
+
+// A chunk to draw. Matches the per-instance vertex attribute.
+struct GrassChunk {
+    int32_t x;
+    int32_t z;
+};
+
+// Picks the chunks to draw each frame: O(chunks in range), whatever the blade
+// count. Blade b of a chunk is kept where Density(distance) > (b + 0.5) /
+// bladesPerChunk, so a chunk only needs its first few blades once it is far
+// away. Chunks are drawn in BANDS, each with a quarter of the blades of the
+// one before; a chunk goes in the sparsest band that still holds all the
+// blades it keeps. The blade vertex shader has Density too; keep them in sync.
+class GrassField {
+public:
+    static constexpr int BANDS = 3;
+
+    GrassField(const GrassParams& p, float minY, float maxY) : p(p), minY(minY), maxY(maxY) {}
+
+    const GrassParams& Params() const { return p; }
+
+    float Density(float d) const {
+        return std::min(std::max((p.fadeEnd - d) / (p.fadeEnd - p.fadeStart), 0.0f), 1.0f);
+    }
+
+    int BandBlades(int band) const { return std::max(1, p.bladesPerChunk >> (2 * band)); }
+
+    // Chunks overlapping the fadeEnd square around any eye.
+    size_t MaxChunks() const {
+        size_t side = (size_t)std::ceil(2.0f * p.fadeEnd / p.chunkSize) + 1;
+        return side * side;
+    }
+
+    // Fills `out` (BANDS * MaxChunks() entries) with the visible chunks from
+    // `eye`, band by band from the start; `counts[b]` is how many are in band b.
+    void Select(const glm::vec3& eye, const Frustum& frustum, GrassChunk* out, size_t counts[BANDS]) const {
+        for (int b = 0; b < BANDS; ++b) counts[b] = 0;
+        if (p.bladesPerChunk <= 0) return;
+        const size_t capacity = MaxChunks();
+        int x0 = (int)std::floor((eye.x - p.fadeEnd) / p.chunkSize);
+        int x1 = (int)std::floor((eye.x + p.fadeEnd) / p.chunkSize);
+        int z0 = (int)std::floor((eye.z - p.fadeEnd) / p.chunkSize);
+        int z1 = (int)std::floor((eye.z + p.fadeEnd) / p.chunkSize);
+        for (int z = z0; z <= z1; ++z) {
+            for (int x = x0; x <= x1; ++x) {
+                glm::vec3 bmin((float)x * p.chunkSize, minY, (float)z * p.chunkSize);
+                glm::vec3 bmax(bmin.x + p.chunkSize, maxY + p.bladeSize.y * 1.5f, bmin.z + p.chunkSize);
+                float density = Density(glm::length(glm::max(glm::max(bmin - eye, eye - bmax), glm::vec3(0.0f))));
+                if (density <= 0.0f || !frustum.IntersectsAabb(bmin, bmax)) continue;
+                int needed = (int)std::ceil(density * (float)p.bladesPerChunk);
+                int band = 0;
+                while (band + 1 < BANDS && BandBlades(band + 1) >= needed) ++band;
+                out[band * capacity + counts[band]++] = { x, z };
+            }
+        }
+        size_t at = counts[0];
+        for (int b = 1; b < BANDS; ++b) {
+            std::copy(out + b * capacity, out + b * capacity + counts[b], out + at);
+            at += counts[b];
+        }
+    }
+
+private:
+    GrassParams p;
+    float minY, maxY;
+};
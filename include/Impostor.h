@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Octahedral impostors: an object is captured from IMPOSTOR_FRAMES^2 view
+// directions over the upper hemisphere, each frame an orthographic view of its
+// bounding sphere, into one atlas of color (alpha = coverage) and depth. At
+// distance it draws as one camera-facing quad that blends the three frames
+// nearest the view direction.
+constexpr int IMPOSTOR_FRAMES = 8;
+constexpr int IMPOSTOR_FRAME_SIZE = 64;
+constexpr int IMPOSTOR_ATLAS_SIZE = IMPOSTOR_FRAMES * IMPOSTOR_FRAME_SIZE;
+
+// Hemi-octahedral map between directions with y >= 0 and [0,1]^2. The shader
+// has the same pair; keep them in sync.
+inline glm::vec2 HemiOctEncode(glm::vec3 d) {
+    d.y = std::max(d.y, 0.0f);
+    float s = std::fabs(d.x) + std::fabs(d.y) + std::fabs(d.z);
+    float x = d.x / s, z = d.z / s;
+    return glm::vec2(x + z, x - z) * 0.5f + 0.5f;
+}
+
+inline glm::vec3 HemiOctDecode(const glm::vec2& uv) {
+    glm::vec2 p = uv * 2.0f - 1.0f;
+    glm::vec3 d(0.5f * (p.x + p.y), 0.0f, 0.5f * (p.x - p.y));
+    d.y = 1.0f - std::fabs(d.x) - std::fabs(d.z);
+    return glm::normalize(d);
+}
+
+// Direction of atlas frame (x, y); frames sit on a grid that includes the
+// horizon, so the corners and edges are exact views.
+inline glm::vec3 ImpostorFrameDir(int x, int y) {
+    return HemiOctDecode(glm::vec2((float)x, (float)y) / (float)(IMPOSTOR_FRAMES - 1));
+}
+
+// Up vector a frame is captured with (the shader picks the same one).
+inline glm::vec3 ImpostorFrameUp(const glm::vec3& dir) {
+    return std::fabs(dir.y) > 0.999f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+// Capture camera of a frame: looking at `center` from `dir`, the sphere
+// exactly filling the frame, depth linear from the near side (0) to the far
+// side (1) of the sphere.
+inline glm::mat4 ImpostorFrameView(const glm::vec3& center, float radius, const glm::vec3& dir) {
+    return glm::lookAt(center + dir * (2.0f * radius), center, ImpostorFrameUp(dir));
+}
+
+inline glm::mat4 ImpostorFrameProjection(float radius) {
+    return glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+}
+
+// Something that may draw as an impostor: the LOD groups it replaces and the
+// atlas layer holding its frames (shared by impostors with the same key).
+struct Impostor {
+    // The lot it belongs to; captures are lit relative to this point.
+    glm::vec3 origin{ 0.0f };
+    glm::vec3 center{ 0.0f };
+    float radius = 0.0f;
+    uint32_t layer = 0;
+    uint64_t key = 0;
+    std::vector<uint32_t> groups;
+};
+
+// FNV-1a, for cache keys over captured content.
+inline uint64_t HashBytes(uint64_t h, const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+
+// On-disk atlas: a small header, then RGBA8 color and 16-bit depth, both
+// IMPOSTOR_ATLAS_SIZE^2 texels in GL row order.
+struct ImpostorFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t frames;
+    uint32_t frameSize;
+    uint64_t key;
+};
+
+constexpr uint32_t IMPOSTOR_FILE_VERSION = 1;
+constexpr size_t IMPOSTOR_COLOR_BYTES = (size_t)IMPOSTOR_ATLAS_SIZE * IMPOSTOR_ATLAS_SIZE * 4;
+constexpr size_t IMPOSTOR_DEPTH_BYTES = (size_t)IMPOSTOR_ATLAS_SIZE * IMPOSTOR_ATLAS_SIZE * 2;
+
+inline ImpostorFileHeader MakeImpostorHeader(uint64_t key) {
+    ImpostorFileHeader h;
+    std::memcpy(h.magic, "OIMP", 4);
+    h.version = IMPOSTOR_FILE_VERSION;
+    h.frames = IMPOSTOR_FRAMES;
+    h.frameSize = IMPOSTOR_FRAME_SIZE;
+    h.key = key;
+    return h;
+}
+
+// Fills `color` and `depth` when `path` holds an atlas for `key`.
+inline bool LoadImpostorAtlas(const char* path, uint64_t key, std::vector<unsigned char>& color, std::vector<unsigned char>& depth) {
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    ImpostorFileHeader want = MakeImpostorHeader(key);
+    ImpostorFileHeader h;
+    bool ok = std::fread(&h, sizeof(h), 1, f) == 1 && std::memcmp(&h, &want, sizeof(h)) == 0;
+    if (ok) {
+        color.resize(IMPOSTOR_COLOR_BYTES);
+        depth.resize(IMPOSTOR_DEPTH_BYTES);
+        ok = std::fread(color.data(), 1, color.size(), f) == color.size() &&
+            std::fread(depth.data(), 1, depth.size(), f) == depth.size();
+    }
+    std::fclose(f);
+    return ok;
+}
+
+inline bool SaveImpostorAtlas(const char* path, uint64_t key, const std::vector<unsigned char>& color, const std::vector<unsigned char>& depth) {
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    ImpostorFileHeader h = MakeImpostorHeader(key);
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+        std::fwrite(color.data(), 1, color.size(), f) == color.size() &&
+        std::fwrite(depth.data(), 1, depth.size(), f) == depth.size();
+    return std::fclose(f) == 0 && ok;
+}
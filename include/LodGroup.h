@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// Level 0 is the group's own items; levels 1.. are simplified proxies.
+constexpr uint32_t LOD_LEVELS = 4;
+// A level no entity has: selecting it hides the whole group.
+constexpr uint32_t LOD_HIDDEN = LOD_LEVELS;
+// Simplification budget of levels 1.., as a fraction of the group's radius.
+constexpr float LOD_ERROR_FRACTIONS[LOD_LEVELS - 1] = { 0.01f, 0.03f, 0.08f };
+
+// A set of items (a house body, a carport, ...) that can be swapped as a whole for
+// a coarser proxy. `error` is the world-space error bound of each level.
+struct LodGroup {
+    glm::vec3 center{ 0.0f };
+    float radius = 0.0f;
+    uint32_t levelCount = 1;
+    float error[LOD_LEVELS] = {};
+    uint32_t triangles[LOD_LEVELS] = {};
+
+    // Coarsest level whose error projects to at most `pixelError` pixels, with
+    // `pixelsPerUnit` = viewport height / (2 tan(fovY / 2)). Distance is taken
+    // to the bounding sphere, so the bound holds for every point of the group.
+    uint32_t Select(const glm::vec3& eye, float pixelsPerUnit, float pixelError) const {
+        float dist = std::max(glm::length(eye - center) - radius, 1e-3f);
+        uint32_t level = 0;
+        for (uint32_t k = 1; k < levelCount; ++k) {
+            if (error[k] * pixelsPerUnit <= pixelError * dist) level = k;
+        }
+        return level;
+    }
+};
@@ -0,0 +1,408 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "MeshOptimize.h"
+#include "VertexFormat.h"
+#include "Meshlet.h"
+
+struct MeshVertex {
+    glm::vec3 pos;
+    glm::vec3 normal;
+};
+
+// Where a mesh lives in the shared buffers. Indices are absolute (already
+// offset by the mesh's first vertex), so draws need no base vertex.
+struct MeshRange {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
+
+    uint32_t Triangles() const { return indexCount / 3; }
+};
+
+// Built-in primitives. All fit the unit cube (-0.5..0.5), so they share the
+// box conventions: pivots, scale and UnitCubeBounds all work unchanged.
+enum MeshId : uint32_t {
+    MESH_CUBE = 0,
+    MESH_CYLINDER,  // axis +Y, radius 0.5
+    MESH_CONE,      // base at y = -0.5, apex at y = +0.5
+    MESH_SPHERE,    // radius 0.5
+    MESH_PRISM,     // triangle in YZ (base at y = -0.5, apex at y = +0.5, z = 0), extruded along X
+    MESH_PRIMITIVE_COUNT
+};
+
+// One mesh under construction, with local (0-based) indices.
+struct MeshBuilder {
+    std::vector<MeshVertex> v;
+    std::vector<uint32_t> i;
+
+    uint32_t Vertex(const glm::vec3& p, const glm::vec3& n) {
+        v.push_back({ p, n });
+        return (uint32_t)v.size() - 1;
+    }
+    void Tri(uint32_t a, uint32_t b, uint32_t c) {
+        i.push_back(a);
+        i.push_back(b);
+        i.push_back(c);
+    }
+    void Quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        Tri(a, b, c);
+        Tri(c, d, a);
+    }
+    // Flat quad from four corners in counter-clockwise order seen from outside.
+    void FlatQuad(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d) {
+        glm::vec3 n = glm::normalize(glm::cross(b - a, c - a));
+        uint32_t base = (uint32_t)v.size();
+        Vertex(a, n);
+        Vertex(b, n);
+        Vertex(c, n);
+        Vertex(d, n);
+        Quad(base, base + 1, base + 2, base + 3);
+    }
+    // Flat convex (or star-shaped around p[0]) polygon, counter-clockwise seen
+    // from outside, fanned from p[0].
+    void FlatPolygon(const glm::vec3* p, int count) {
+        glm::vec3 n = glm::normalize(glm::cross(p[1] - p[0], p[2] - p[0]));
+        uint32_t base = (uint32_t)v.size();
+        for (int k = 0; k < count; ++k) Vertex(p[k], n);
+        for (int k = 1; k + 1 < count; ++k) Tri(base, base + (uint32_t)k, base + (uint32_t)k + 1);
+    }
+    void FlatTri(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        glm::vec3 n = glm::normalize(glm::cross(b - a, c - a));
+        uint32_t base = (uint32_t)v.size();
+        Vertex(a, n);
+        Vertex(b, n);
+        Vertex(c, n);
+        Tri(base, base + 1, base + 2);
+    }
+    // Disc at height y facing up (+1) or down (-1).
+    void Cap(int segments, float y, float facing) {
+        glm::vec3 n(0.0f, facing, 0.0f);
+        uint32_t center = Vertex(glm::vec3(0.0f, y, 0.0f), n);
+        uint32_t first = (uint32_t)v.size();
+        for (int s = 0; s < segments; ++s) {
+            float a = (float)s / (float)segments * 6.2831853f;
+            Vertex(glm::vec3(0.5f * std::cos(a), y, 0.5f * std::sin(a)), n);
+        }
+        for (int s = 0; s < segments; ++s) {
+            uint32_t a = first + (uint32_t)s;
+            uint32_t b = first + (uint32_t)((s + 1) % segments);
+            if (facing > 0.0f) Tri(center, b, a);
+            else Tri(center, a, b);
+        }
+    }
+
+    // Rescales the vertices in place into the unit cube and returns the model
+    // matrix that puts them back. Normals are pre-scaled so the shader's
+    // inverse-transpose restores them.
+    glm::mat4 FitUnitCube() {
+        glm::vec3 mn(1e30f), mx(-1e30f);
+        for (const MeshVertex& p : v) {
+            mn = glm::min(mn, p.pos);
+            mx = glm::max(mx, p.pos);
+        }
+        glm::vec3 c = 0.5f * (mn + mx);
+        glm::vec3 e = glm::max(mx - mn, glm::vec3(1e-5f));
+        for (MeshVertex& p : v) {
+            p.pos = (p.pos - c) / e;
+            p.normal = glm::normalize(p.normal * e);
+        }
+        glm::mat4 m(1.0f);
+        m[0][0] = e.x;
+        m[1][1] = e.y;
+        m[2][2] = e.z;
+        m[3] = glm::vec4(c, 1.0f);
+        return m;
+    }
+};
+
+
+// Every mesh in one vertex/index buffer pair with a range per mesh. Meshes past
+// the primitives are added at build time (roofs, ...).
+class MeshLibrary {
+public:
+    // segments == 0 keeps the primitive ids as empty placeholders: enough for
+    // a per-builder library that only collects built meshes before Append().
+    explicit MeshLibrary(int segments = 16) {
+        if (segments <= 0) {
+            ranges.resize(MESH_PRIMITIVE_COUNT);
+            return;
+        }
+        AddCube();
+        AddCylinder(segments);
+        AddCone(segments);
+        AddSphere(segments, segments / 2);
+        AddPrism();
+    }
+
+    uint32_t Add(const MeshVertex* v, size_t vertexCount, const uint32_t* idx, size_t indexCount) {
+        MeshRange r;
+        r.firstIndex = (uint32_t)indices.size();
+        r.indexCount = (uint32_t)indexCount;
+        r.firstVertex = (uint32_t)vertices.size();
+        r.vertexCount = (uint32_t)vertexCount;
+        vertices.insert(vertices.end(), v, v + vertexCount);
+        for (size_t i = 0; i < indexCount; ++i) indices.push_back(r.firstVertex + idx[i]);
+        ranges.push_back(r);
+        return (uint32_t)ranges.size() - 1;
+    }
+
+    uint32_t Add(const MeshBuilder& b) { return Add(b.v.data(), b.v.size(), b.i.data(), b.i.size()); }
+
+    // Appends the non-primitive meshes of `other`; returns the offset to add to
+    // mesh ids >= MESH_PRIMITIVE_COUNT that referred to `other`.
+    uint32_t Append(const MeshLibrary& other) {
+        uint32_t offset = (uint32_t)ranges.size() - MESH_PRIMITIVE_COUNT;
+        for (size_t m = MESH_PRIMITIVE_COUNT; m < other.ranges.size(); ++m) AppendMesh(other, (uint32_t)m, false);
+        return offset;
+    }
+
+    // Like Append, but a mesh whose vertices and indices equal one appended
+    // here before is reused, and baked meshlets come along. Returns the id
+    // here of every mesh id of `other` (primitives map to themselves).
+    std::vector<uint32_t> AppendShared(const MeshLibrary& other) {
+        std::vector<uint32_t> remap(other.ranges.size());
+        for (uint32_t m = 0; m < MESH_PRIMITIVE_COUNT && m < remap.size(); ++m) remap[m] = m;
+        for (uint32_t m = MESH_PRIMITIVE_COUNT; m < (uint32_t)other.ranges.size(); ++m) {
+            uint64_t h = other.ContentHash(m);
+            remap[m] = ~0u;
+            auto range = shared.equal_range(h);
+            for (auto it = range.first; it != range.second && remap[m] == ~0u; ++it) {
+                if (SameContent(other, m, it->second)) remap[m] = it->second;
+            }
+            if (remap[m] != ~0u) continue;
+            remap[m] = AppendMesh(other, m, true);
+            shared.emplace(h, remap[m]);
+        }
+        return remap;
+    }
+
+    size_t Count() const { return ranges.size(); }
+    const MeshRange& Range(uint32_t id) const { return ranges[id]; }
+    size_t MeshletCount() const { return meshlets.size(); }
+    const Meshlet& GetMeshlet(uint32_t id) const { return meshlets[id]; }
+    uint32_t MaxMeshletsPerMesh() const {
+        uint32_t n = 0;
+        for (const MeshRange& r : ranges) n = std::max(n, r.meshletCount);
+        return n;
+    }
+    const std::vector<MeshVertex>& Vertices() const { return vertices; }
+    const std::vector<uint32_t>& Indices() const { return indices; }
+
+    size_t VertexBytes() const { return vertices.size() * sizeof(MeshVertex); }
+    size_t PackedVertexBytes() const { return vertices.size() * sizeof(PackedVertex); }
+    size_t IndexBytes() const { return indices.size() * sizeof(uint32_t); }
+    // CPU copies kept after upload (bakes and streamed lots append to them).
+    size_t MemoryBytes() const {
+        return vertices.capacity() * sizeof(MeshVertex) + indices.capacity() * sizeof(uint32_t) +
+            ranges.capacity() * sizeof(MeshRange) + meshlets.capacity() * sizeof(Meshlet);
+    }
+
+    std::vector<PackedVertex> PackedVertices(size_t firstVertex = 0) const {
+        std::vector<PackedVertex> packed;
+        packed.reserve(vertices.size() - firstVertex);
+        for (size_t v = firstVertex; v < vertices.size(); ++v) packed.push_back(PackVertex(vertices[v].pos, vertices[v].normal));
+        return packed;
+    }
+
+    struct OptimizeStats {
+        VertexCacheStats before;
+        VertexCacheStats after;
+    };
+
+    // Bake step: reorders every mesh from `firstMesh` on for the vertex cache,
+    // then its clusters for overdraw, then its vertices for fetch order.
+    // Ranges are unchanged.
+    OptimizeStats Optimize(uint32_t cacheSize = 16, uint32_t firstMesh = 0) {
+        OptimizeStats s;
+        std::vector<uint32_t> local;
+        std::vector<MeshVertex> reordered;
+        for (size_t m = firstMesh; m < ranges.size(); ++m) {
+            const MeshRange& r = ranges[m];
+            if (r.indexCount == 0) continue;
+            local.assign(indices.begin() + r.firstIndex, indices.begin() + r.firstIndex + r.indexCount);
+            for (uint32_t& i : local) i -= r.firstVertex;
+
+            s.before += AnalyzeVertexCache(local.data(), local.size(), r.vertexCount, cacheSize);
+            OptimizeVertexCache(local.data(), local.size(), r.vertexCount);
+            OptimizeOverdraw(local.data(), local.size(), &vertices[r.firstVertex].pos.x, r.vertexCount,
+                sizeof(MeshVertex), 1.05f, cacheSize);
+            s.after += AnalyzeVertexCache(local.data(), local.size(), r.vertexCount, cacheSize);
+
+            std::vector<uint32_t> remap = OptimizeVertexFetchRemap(local.data(), local.size(), r.vertexCount);
+            reordered.resize(r.vertexCount);
+            for (uint32_t v = 0; v < r.vertexCount; ++v) reordered[remap[v]] = vertices[r.firstVertex + v];
+            std::copy(reordered.begin(), reordered.end(), vertices.begin() + r.firstVertex);
+            for (uint32_t i = 0; i < r.indexCount; ++i) indices[r.firstIndex + i] = local[i] + r.firstVertex;
+        }
+        return s;
+    }
+
+    // Bake step after Optimize(): splits every mesh from `firstMesh` on, in its
+    // final index order, into meshlets with culling bounds. Meshlets of earlier
+    // meshes are kept, so call it once per batch of meshes, in order.
+    void BakeMeshlets(uint32_t firstMesh = 0) {
+        if (firstMesh == 0) meshlets.clear();
+        std::vector<uint32_t> local;
+        std::vector<glm::vec3> positions;
+        for (size_t m = firstMesh; m < ranges.size(); ++m) {
+            MeshRange& r = ranges[m];
+            r.firstMeshlet = (uint32_t)meshlets.size();
+            if (r.indexCount > 0) {
+                local.assign(indices.begin() + r.firstIndex, indices.begin() + r.firstIndex + r.indexCount);
+                for (uint32_t& i : local) i -= r.firstVertex;
+                positions.clear();
+                for (uint32_t v = 0; v < r.vertexCount; ++v) positions.push_back(vertices[r.firstVertex + v].pos);
+                BuildMeshlets(meshlets, local.data(), local.size(), positions.data(), positions.size(), r.firstIndex);
+            }
+            r.meshletCount = (uint32_t)meshlets.size() - r.firstMeshlet;
+        }
+    }
+
+private:
+    uint32_t AppendMesh(const MeshLibrary& other, uint32_t m, bool withMeshlets) {
+        const MeshRange& r = other.ranges[m];
+        MeshRange n = r;
+        n.firstIndex = (uint32_t)indices.size();
+        n.firstVertex = (uint32_t)vertices.size();
+        n.firstMeshlet = (uint32_t)meshlets.size();
+        n.meshletCount = withMeshlets ? r.meshletCount : 0;
+        vertices.insert(vertices.end(), other.vertices.begin() + r.firstVertex, other.vertices.begin() + r.firstVertex + r.vertexCount);
+        for (uint32_t i = 0; i < r.indexCount; ++i) indices.push_back(other.indices[r.firstIndex + i] - r.firstVertex + n.firstVertex);
+        for (uint32_t k = 0; k < n.meshletCount; ++k) {
+            Meshlet ml = other.meshlets[r.firstMeshlet + k];
+            ml.firstIndex = ml.firstIndex - r.firstIndex + n.firstIndex;
+            meshlets.push_back(ml);
+        }
+        ranges.push_back(n);
+        return (uint32_t)ranges.size() - 1;
+    }
+
+    // FNV-1a over the vertices and the mesh-local indices.
+    uint64_t ContentHash(uint32_t m) const {
+        const MeshRange& r = ranges[m];
+        uint64_t h = 14695981039346656037ull;
+        auto Mix = [&h](const void* data, size_t size) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i) h = (h ^ p[i]) * 1099511628211ull;
+        };
+        Mix(vertices.data() + r.firstVertex, r.vertexCount * sizeof(MeshVertex));
+        for (uint32_t i = 0; i < r.indexCount; ++i) {
+            uint32_t v = indices[r.firstIndex + i] - r.firstVertex;
+            Mix(&v, sizeof(v));
+        }
+        return h;
+    }
+
+    bool SameContent(const MeshLibrary& other, uint32_t m, uint32_t mine) const {
+        const MeshRange& a = other.ranges[m];
+        const MeshRange& b = ranges[mine];
+        if (a.vertexCount != b.vertexCount || a.indexCount != b.indexCount) return false;
+        if (std::memcmp(other.vertices.data() + a.firstVertex, vertices.data() + b.firstVertex, a.vertexCount * sizeof(MeshVertex)) != 0) return false;
+        for (uint32_t i = 0; i < a.indexCount; ++i) {
+            if (other.indices[a.firstIndex + i] - a.firstVertex != indices[b.firstIndex + i] - b.firstVertex) return false;
+        }
+        return true;
+    }
+
+    void AddCube() {
+        MeshBuilder b;
+        const glm::vec3 p[8] = {
+            { -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+            { -0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { -0.5f, 0.5f, 0.5f },
+        };
+        b.FlatQuad(p[4], p[5], p[6], p[7]);
+        b.FlatQuad(p[1], p[0], p[3], p[2]);
+        b.FlatQuad(p[0], p[4], p[7], p[3]);
+        b.FlatQuad(p[5], p[1], p[2], p[6]);
+        b.FlatQuad(p[7], p[6], p[2], p[3]);
+        b.FlatQuad(p[0], p[1], p[5], p[4]);
+        Add(b);
+    }
+
+    void AddCylinder(int segments) {
+        MeshBuilder b;
+        for (int s = 0; s <= segments; ++s) {
+            float a = (float)s / (float)segments * 6.2831853f;
+            glm::vec3 n(std::cos(a), 0.0f, std::sin(a));
+            b.Vertex(glm::vec3(0.5f * n.x, -0.5f, 0.5f * n.z), n);
+            b.Vertex(glm::vec3(0.5f * n.x, 0.5f, 0.5f * n.z), n);
+        }
+        for (int s = 0; s < segments; ++s) {
+            uint32_t a = (uint32_t)s * 2;
+            b.Quad(a, a + 1, a + 3, a + 2);
+        }
+        b.Cap(segments, 0.5f, 1.0f);
+        b.Cap(segments, -0.5f, -1.0f);
+        Add(b);
+    }
+
+    void AddCone(int segments) {
+        MeshBuilder b;
+        // Side normal of a cone with radius 0.5 and height 1: (cos, 0.5, sin) normalized.
+        float ny = 0.5f / std::sqrt(1.25f);
+        float nr = 1.0f / std::sqrt(1.25f);
+        for (int s = 0; s < segments; ++s) {
+            float a0 = (float)s / (float)segments * 6.2831853f;
+            float a1 = (float)(s + 1) / (float)segments * 6.2831853f;
+            float am = 0.5f * (a0 + a1);
+            uint32_t i0 = b.Vertex(glm::vec3(0.5f * std::cos(a0), -0.5f, 0.5f * std::sin(a0)),
+                glm::vec3(nr * std::cos(a0), ny, nr * std::sin(a0)));
+            uint32_t i1 = b.Vertex(glm::vec3(0.5f * std::cos(a1), -0.5f, 0.5f * std::sin(a1)),
+                glm::vec3(nr * std::cos(a1), ny, nr * std::sin(a1)));
+            uint32_t tip = b.Vertex(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(nr * std::cos(am), ny, nr * std::sin(am)));
+            b.Tri(i0, tip, i1);
+        }
+        b.Cap(segments, -0.5f, -1.0f);
+        Add(b);
+    }
+
+    void AddSphere(int slices, int stacks) {
+        MeshBuilder b;
+        for (int y = 0; y <= stacks; ++y) {
+            float phi = (float)y / (float)stacks * 3.14159265f;
+            for (int x = 0; x <= slices; ++x) {
+                float theta = (float)x / (float)slices * 6.2831853f;
+                glm::vec3 n(std::sin(phi) * std::cos(theta), -std::cos(phi), std::sin(phi) * std::sin(theta));
+                b.Vertex(n * 0.5f, n);
+            }
+        }
+        uint32_t row = (uint32_t)slices + 1;
+        for (int y = 0; y < stacks; ++y) {
+            for (int x = 0; x < slices; ++x) {
+                uint32_t a = (uint32_t)y * row + (uint32_t)x;
+                if (y > 0) b.Tri(a, a + row, a + 1);
+                if (y < stacks - 1) b.Tri(a + 1, a + row, a + row + 1);
+            }
+        }
+        Add(b);
+    }
+
+    void AddPrism() {
+        MeshBuilder b;
+        glm::vec3 l0(-0.5f, -0.5f, -0.5f), l1(-0.5f, -0.5f, 0.5f), lt(-0.5f, 0.5f, 0.0f);
+        glm::vec3 r0(0.5f, -0.5f, -0.5f), r1(0.5f, -0.5f, 0.5f), rt(0.5f, 0.5f, 0.0f);
+        b.FlatTri(l0, l1, lt);
+        b.FlatTri(r1, r0, rt);
+        b.FlatQuad(l1, r1, rt, lt);
+        b.FlatQuad(r0, l0, lt, rt);
+        b.FlatQuad(l0, r0, r1, l1);
+        Add(b);
+    }
+
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshRange> ranges;
+    std::vector<Meshlet> meshlets;
+    // Content hash -> mesh, for the meshes AppendShared added.
+    std::unordered_multimap<uint64_t, uint32_t> shared;
+};
@@ -0,0 +1,247 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// Triangle and vertex reordering for indexed triangle lists. Indices are
+// 0-based into a vertex range of `vertexCount` vertices.
+
+// Post-transform cache behaviour of an index order under a FIFO cache.
+struct VertexCacheStats {
+    uint64_t triangles = 0;
+    uint64_t vertices = 0;
+    uint64_t misses = 0;
+
+    // Average cache miss ratio: transformed vertices per triangle (0.5 is ideal
+    // for large grids, 3 is no reuse at all).
+    float Acmr() const { return triangles ? (float)misses / (float)triangles : 0.0f; }
+    // Average transformed vertex ratio: transforms per vertex (1 is ideal).
+    float Atvr() const { return vertices ? (float)misses / (float)vertices : 0.0f; }
+
+    VertexCacheStats& operator+=(const VertexCacheStats& o) {
+        triangles += o.triangles;
+        vertices += o.vertices;
+        misses += o.misses;
+        return *this;
+    }
+};
+
+inline VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16) {
+    VertexCacheStats s;
+    s.triangles = indexCount / 3;
+    s.vertices = vertexCount;
+
+    // A vertex is cached while fewer than cacheSize misses happened since its own.
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = indices[i];
+        if (time - stamp[v] > cacheSize) {
+            stamp[v] = time++;
+            s.misses++;
+        }
+    }
+    return s;
+}
+
+namespace MeshOptimizeDetail {
+    constexpr int CACHE_SIZE = 32;
+
+    // Forsyth's vertex score: recently used vertices score high (the last
+    // triangle's three a fixed 0.75), and vertices with few triangles left get
+    // a boost so they are finished off rather than left stranded.
+    inline float VertexScore(int cachePos, uint32_t liveTriangles) {
+        if (liveTriangles == 0) return -1.0f;
+        float score = 0.0f;
+        if (cachePos >= 0) {
+            if (cachePos < 3) score = 0.75f;
+            else score = std::pow(1.0f - (float)(cachePos - 3) / (float)(CACHE_SIZE - 3), 1.5f);
+        }
+        return score + 2.0f / std::sqrt((float)liveTriangles);
+    }
+}
+
+// Greedy triangle reorder for vertex cache reuse (Forsyth's linear-speed
+// algorithm): always emit the best-scoring triangle touching the cache.
+inline void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    using namespace MeshOptimizeDetail;
+    size_t triCount = indexCount / 3;
+    if (triCount == 0) return;
+
+    // Triangles adjacent to each vertex; the first live[v] entries are still unemitted.
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; ++i) offsets[indices[i] + 1]++;
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> adjacency(indexCount);
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = indices[i];
+        adjacency[offsets[v] + live[v]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) vertexScore[v] = VertexScore(-1, live[v]);
+    std::vector<float> triScore(triCount);
+    std::vector<char> emitted(triCount, 0);
+    int best = 0;
+    for (size_t t = 0; t < triCount; ++t) {
+        const uint32_t* tri = indices + t * 3;
+        triScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+        if (triScore[t] > triScore[best]) best = (int)t;
+    }
+
+    std::vector<uint32_t> out;
+    out.reserve(triCount * 3);
+    uint32_t cache[CACHE_SIZE + 3];
+    int cacheCount = 0;
+    size_t cursor = 0;
+
+    while (best >= 0) {
+        const uint32_t* tri = indices + (size_t)best * 3;
+        emitted[best] = 1;
+        out.insert(out.end(), tri, tri + 3);
+
+        // The triangle's vertices move to the front; the rest shift back.
+        uint32_t next[CACHE_SIZE + 3];
+        int nextCount = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (std::find(next, next + nextCount, tri[k]) == next + nextCount) next[nextCount++] = tri[k];
+        }
+        for (int c = 0; c < cacheCount; ++c) {
+            if (std::find(next, next + nextCount, cache[c]) == next + nextCount) next[nextCount++] = cache[c];
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            uint32_t* adj = adjacency.data() + offsets[v];
+            uint32_t* it = std::find(adj, adj + live[v], (uint32_t)best);
+            *it = adj[--live[v]];
+        }
+
+        for (int c = 0; c < nextCount; ++c) {
+            uint32_t v = next[c];
+            cachePos[v] = c < CACHE_SIZE ? c : -1;
+            float score = VertexScore(cachePos[v], live[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            const uint32_t* adj = adjacency.data() + offsets[v];
+            for (uint32_t a = 0; a < live[v]; ++a) triScore[adj[a]] += delta;
+        }
+        cacheCount = std::min(nextCount, CACHE_SIZE);
+        std::memcpy(cache, next, sizeof(uint32_t) * cacheCount);
+
+        best = -1;
+        float bestScore = -1e30f;
+        for (int c = 0; c < cacheCount; ++c) {
+            uint32_t v = cache[c];
+            const uint32_t* adj = adjacency.data() + offsets[v];
+            for (uint32_t a = 0; a < live[v]; ++a) {
+                if (triScore[adj[a]] > bestScore) {
+                    bestScore = triScore[adj[a]];
+                    best = (int)adj[a];
+                }
+            }
+        }
+        if (best < 0) {
+            while (cursor < triCount && emitted[cursor]) ++cursor;
+            if (cursor < triCount) best = (int)cursor;
+        }
+    }
+    std::copy(out.begin(), out.end(), indices);
+}
+
+// Reorders clusters of a cache-optimized order so outward-facing clusters
+// (the ones most likely to occlude the rest of the mesh) come first, in the
+// spirit of Sander et al.'s view-independent overdraw sort. Clusters break
+// where the cache restarts (a triangle with three misses). The new order is
+// kept only if its ACMR stays within `threshold` of the input's.
+inline void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+    size_t positionStride, float threshold = 1.05f, uint32_t cacheSize = 16)
+{
+    size_t triCount = indexCount / 3;
+    if (triCount < 2) return;
+    auto Pos = [&](uint32_t v) {
+        const float* p = (const float*)((const unsigned char*)positions + (size_t)v * positionStride);
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    std::vector<uint32_t> clusterStart;
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    for (size_t t = 0; t < triCount; ++t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = indices[t * 3 + k];
+            if (time - stamp[v] > cacheSize) {
+                stamp[v] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) clusterStart.push_back((uint32_t)t);
+    }
+    size_t clusterCount = clusterStart.size();
+    if (clusterCount < 2) return;
+    clusterStart.push_back((uint32_t)triCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centroid(clusterCount), normal(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        glm::vec3 sum(0.0f), n(0.0f);
+        float area = 0.0f;
+        for (uint32_t t = clusterStart[c]; t < clusterStart[c + 1]; ++t) {
+            glm::vec3 a = Pos(indices[t * 3]), b = Pos(indices[t * 3 + 1]), d = Pos(indices[t * 3 + 2]);
+            glm::vec3 cr = glm::cross(b - a, d - a);
+            float w = glm::length(cr);
+            sum += (a + b + d) * (w / 3.0f);
+            n += cr;
+            area += w;
+        }
+        centroid[c] = area > 0.0f ? sum / area : Pos(indices[clusterStart[c] * 3]);
+        float len = glm::length(n);
+        normal[c] = len > 0.0f ? n / len : glm::vec3(0.0f);
+        meshCentroid += sum;
+        meshArea += area;
+    }
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+    std::vector<float> key(clusterCount);
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        key[c] = glm::dot(centroid[c] - meshCentroid, normal[c]);
+        order[c] = (uint32_t)c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(indexCount);
+    for (uint32_t c : order) {
+        sorted.insert(sorted.end(), indices + (size_t)clusterStart[c] * 3, indices + (size_t)clusterStart[c + 1] * 3);
+    }
+
+    float before = AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize).Acmr();
+    float after = AnalyzeVertexCache(sorted.data(), sorted.size(), vertexCount, cacheSize).Acmr();
+    if (after <= before * threshold) std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+// Vertex order matching first use in the index buffer, so vertex fetch walks
+// memory forward. Returns remap[old] = new and rewrites the indices; unused
+// vertices keep their relative order at the end.
+inline std::vector<uint32_t> OptimizeVertexFetchRemap(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    std::vector<uint32_t> remap(vertexCount, ~0u);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& r = remap[indices[i]];
+        if (r == ~0u) r = next++;
+        indices[i] = r;
+    }
+    for (uint32_t& r : remap) {
+        if (r == ~0u) r = next++;
+    }
+    return remap;
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// Garland-Heckbert quadric: sum of squared distances to a set of planes.
+struct Quadric {
+    float a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    float b0 = 0, b1 = 0, b2 = 0;
+    float c = 0;
+
+    // Plane n.p + d = 0 with unit n, scaled by `weight`.
+    static Quadric FromPlane(const glm::vec3& n, float d, float weight = 1.0f) {
+        Quadric q;
+        q.a00 = weight * n.x * n.x;
+        q.a01 = weight * n.x * n.y;
+        q.a02 = weight * n.x * n.z;
+        q.a11 = weight * n.y * n.y;
+        q.a12 = weight * n.y * n.z;
+        q.a22 = weight * n.z * n.z;
+        q.b0 = weight * n.x * d;
+        q.b1 = weight * n.y * d;
+        q.b2 = weight * n.z * d;
+        q.c = weight * d * d;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& o) {
+        a00 += o.a00; a01 += o.a01; a02 += o.a02;
+        a11 += o.a11; a12 += o.a12; a22 += o.a22;
+        b0 += o.b0; b1 += o.b1; b2 += o.b2;
+        c += o.c;
+        return *this;
+    }
+
+    float Eval(const glm::vec3& p) const {
+        float x = p.x, y = p.y, z = p.z;
+        float r = a00 * x * x + a11 * y * y + a22 * z * z +
+            2.0f * (a01 * x * y + a02 * x * z + a12 * y * z) +
+            2.0f * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(0.0f, r);
+    }
+};
+
+// Offline simplifier for an indexed triangle list whose vertices are welded
+// (one index per position; keep vertices apart where they must not merge,
+// e.g. different materials). Each Simplify() call continues from the previous
+// result, so increasing budgets give a chain of coarser levels.
+//
+// Two reductions, both bounded by the budget:
+//  - half-edge collapses ordered by quadric error. The quadrics are unweighted
+//    plane sums, so sqrt(error) bounds the distance to every plane merged
+//    into a vertex;
+//  - removal of whole connected pieces too small to matter. A piece whose box
+//    overlaps a bigger piece is taken to sit on it (a window on a wall), so
+//    removing it moves the surface by about its thickness; a free-standing
+//    piece costs its diagonal. Attached pieces wider than ATTACHED_SPAN
+//    budgets stay regardless, so large thin panels do not drop out.
+class MeshSimplifier {
+public:
+    static constexpr float ATTACHED_SPAN = 8.0f;
+
+    MeshSimplifier(const glm::vec3* positions, size_t vertexCount, const uint32_t* indices, size_t indexCount)
+        : pos(positions, positions + vertexCount), tris(indices, indices + indexCount - indexCount % 3),
+          quadrics(vertexCount)
+    {
+        size_t triCount = tris.size() / 3;
+        for (size_t t = 0; t < triCount; ++t) {
+            const uint32_t* tri = &tris[t * 3];
+            glm::vec3 n = glm::cross(pos[tri[1]] - pos[tri[0]], pos[tri[2]] - pos[tri[0]]);
+            float len = glm::length(n);
+            if (len <= 0.0f) continue;
+            n /= len;
+            Quadric q = Quadric::FromPlane(n, -glm::dot(n, pos[tri[0]]));
+            for (int k = 0; k < 3; ++k) quadrics[tri[k]] += q;
+        }
+        AddBorderQuadrics();
+        RemoveDegenerate();
+    }
+
+    // Reduces the mesh while the error stays within `maxError` (model units);
+    // returns the error bound of the result.
+    float Simplify(float maxError) {
+        RemoveSmallPieces(maxError);
+        while (CollapsePass(maxError * maxError)) {}
+        return error;
+    }
+
+    const std::vector<uint32_t>& Indices() const { return tris; }
+    size_t TriangleCount() const { return tris.size() / 3; }
+    float Error() const { return error; }
+
+private:
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        float cost;
+    };
+
+    // Open edges get a plane through the edge, perpendicular to its face, so
+    // borders keep their shape instead of sliding.
+    void AddBorderQuadrics() {
+        std::vector<uint64_t> edges;
+        size_t triCount = tris.size() / 3;
+        edges.reserve(tris.size());
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = tris[t * 3 + k], b = tris[t * 3 + (k + 1) % 3];
+                edges.push_back((uint64_t)std::min(a, b) << 32 | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t t = 0; t < triCount; ++t) {
+            const uint32_t* tri = &tris[t * 3];
+            glm::vec3 fn = glm::cross(pos[tri[1]] - pos[tri[0]], pos[tri[2]] - pos[tri[0]]);
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = tri[k], b = tri[(k + 1) % 3];
+                uint64_t key = (uint64_t)std::min(a, b) << 32 | std::max(a, b);
+                auto range = std::equal_range(edges.begin(), edges.end(), key);
+                if (range.second - range.first != 1) continue;
+                glm::vec3 n = glm::cross(pos[b] - pos[a], fn);
+                float len = glm::length(n);
+                if (len <= 0.0f) continue;
+                n /= len;
+                Quadric q = Quadric::FromPlane(n, -glm::dot(n, pos[a]));
+                quadrics[a] += q;
+                quadrics[b] += q;
+            }
+        }
+    }
+
+    void RemoveDegenerate() {
+        size_t out = 0;
+        for (size_t t = 0; t + 2 < tris.size(); t += 3) {
+            uint32_t a = tris[t], b = tris[t + 1], c = tris[t + 2];
+            if (a == b || b == c || a == c) continue;
+            tris[out++] = a;
+            tris[out++] = b;
+            tris[out++] = c;
+        }
+        tris.resize(out);
+    }
+
+    void RemoveSmallPieces(float maxError) {
+        size_t triCount = tris.size() / 3;
+        if (triCount == 0) return;
+
+        std::vector<uint32_t> parent(pos.size());
+        for (uint32_t v = 0; v < (uint32_t)parent.size(); ++v) parent[v] = v;
+        auto Find = [&](uint32_t v) {
+            while (parent[v] != v) v = parent[v] = parent[parent[v]];
+            return v;
+        };
+        for (size_t t = 0; t < triCount; ++t) {
+            uint32_t r0 = Find(tris[t * 3]);
+            for (int k = 1; k < 3; ++k) {
+                uint32_t r = Find(tris[t * 3 + k]);
+                if (r != r0) parent[r] = r0;
+            }
+        }
+
+        std::vector<uint32_t> piece(pos.size(), ~0u);
+        std::vector<glm::vec3> mn, mx;
+        for (size_t i = 0; i < tris.size(); ++i) {
+            uint32_t r = Find(tris[i]);
+            if (piece[r] == ~0u) {
+                piece[r] = (uint32_t)mn.size();
+                mn.push_back(pos[tris[i]]);
+                mx.push_back(pos[tris[i]]);
+            }
+            uint32_t p = piece[r];
+            mn[p] = glm::min(mn[p], pos[tris[i]]);
+            mx[p] = glm::max(mx[p], pos[tris[i]]);
+        }
+
+        size_t pieceCount = mn.size();
+        std::vector<float> cost(pieceCount);
+        for (size_t p = 0; p < pieceCount; ++p) {
+            glm::vec3 e = mx[p] - mn[p];
+            float diag = glm::length(e);
+            cost[p] = diag;
+            if (diag > maxError * ATTACHED_SPAN) continue;
+            float eps = 1e-3f * diag;
+            auto Overlaps = [&](size_t o) {
+                for (int k = 0; k < 3; ++k) {
+                    if (mn[p][k] > mx[o][k] + eps || mn[o][k] - eps > mx[p][k]) return false;
+                }
+                return true;
+            };
+            for (size_t o = 0; o < pieceCount; ++o) {
+                if (o == p || glm::length(mx[o] - mn[o]) <= diag) continue;
+                if (Overlaps(o)) {
+                    cost[p] = std::min(e.x, std::min(e.y, e.z));
+                    break;
+                }
+            }
+        }
+
+        size_t out = 0;
+        for (size_t t = 0; t < triCount; ++t) {
+            uint32_t p = piece[Find(tris[t * 3])];
+            if (cost[p] <= maxError) {
+                error = std::max(error, cost[p]);
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) tris[out++] = tris[t * 3 + k];
+        }
+        tris.resize(out);
+    }
+
+    // One round of independent collapses, cheapest first; false when nothing
+    // within the budget was left.
+    bool CollapsePass(float maxCost) {
+        size_t triCount = tris.size() / 3;
+        std::vector<uint32_t> offsets(pos.size() + 1, 0);
+        for (uint32_t v : tris) offsets[v + 1]++;
+        for (size_t v = 0; v < pos.size(); ++v) offsets[v + 1] += offsets[v];
+        std::vector<uint32_t> adjacency(tris.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < tris.size(); ++i) adjacency[fill[tris[i]]++] = (uint32_t)(i / 3);
+
+        std::vector<Collapse> candidates;
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = tris[t * 3 + k], b = tris[t * 3 + (k + 1) % 3];
+                for (int dir = 0; dir < 2; ++dir) {
+                    Quadric q = quadrics[a];
+                    q += quadrics[b];
+                    float cost = q.Eval(pos[b]);
+                    if (cost <= maxCost) candidates.push_back({ a, b, cost });
+                    std::swap(a, b);
+                }
+            }
+        }
+        if (candidates.empty()) return false;
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        std::vector<char> locked(pos.size(), 0);
+        std::vector<char> dead(triCount, 0);
+        size_t applied = 0;
+        for (const Collapse& c : candidates) {
+            if (locked[c.from] || locked[c.to]) continue;
+            if (!CollapseValid(c, adjacency.data() + offsets[c.from], offsets[c.from + 1] - offsets[c.from], dead)) continue;
+
+            for (uint32_t a = offsets[c.from]; a < offsets[c.from + 1]; ++a) {
+                uint32_t t = adjacency[a];
+                if (dead[t]) continue;
+                uint32_t* tri = &tris[(size_t)t * 3];
+                for (int k = 0; k < 3; ++k) locked[tri[k]] = 1;
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) dead[t] = 1;
+                for (int k = 0; k < 3; ++k) {
+                    if (tri[k] == c.from) tri[k] = c.to;
+                }
+            }
+            quadrics[c.to] += quadrics[c.from];
+            error = std::max(error, std::sqrt(c.cost));
+            ++applied;
+        }
+
+        size_t out = 0;
+        for (size_t t = 0; t < triCount; ++t) {
+            if (dead[t]) continue;
+            for (int k = 0; k < 3; ++k) tris[out++] = tris[t * 3 + k];
+        }
+        tris.resize(out);
+        return applied > 0;
+    }
+
+    // Rejects collapses that flip or squash a surviving triangle.
+    bool CollapseValid(const Collapse& c, const uint32_t* adj, uint32_t adjCount, const std::vector<char>& dead) const {
+        for (uint32_t a = 0; a < adjCount; ++a) {
+            if (dead[adj[a]]) continue;
+            const uint32_t* tri = &tris[(size_t)adj[a] * 3];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) continue;
+            glm::vec3 p[3], q[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = pos[tri[k]];
+                q[k] = tri[k] == c.from ? pos[c.to] : p[k];
+            }
+            glm::vec3 n0 = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 n1 = glm::cross(q[1] - q[0], q[2] - q[0]);
+            float l0 = glm::length(n0), l1 = glm::length(n1);
+            if (l1 <= 1e-6f * l0 || glm::dot(n0, n1) < 0.25f * l0 * l1) return false;
+        }
+        return true;
+    }
+
+    std::vector<glm::vec3> pos;
+    std::vector<uint32_t> tris;
+    std::vector<Quadric> quadrics;
+    float error = 0.0f;
+};
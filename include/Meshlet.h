@@ -0,0 +1,116 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// A run of consecutive triangles in a mesh's index range, small enough to cull
+// on its own: a bounding sphere for the frustum and a normal cone for
+// back-facing clusters. Everything is in mesh space.
+struct Meshlet {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t vertexCount = 0;
+    glm::vec3 center{ 0.0f };
+    float radius = 0.0f;
+    glm::vec3 coneApex{ 0.0f };
+    glm::vec3 coneAxis{ 0.0f };
+    // sin of the cone's half angle; >= 1 means the normals spread too far to cull.
+    float coneCutoff = 1.0f;
+
+    // True when every triangle faces away from `eye` (mesh space).
+    bool BackFacing(const glm::vec3& eye) const {
+        if (coneCutoff >= 1.0f) return false;
+        glm::vec3 d = coneApex - eye;
+        float len = glm::length(d);
+        return len > 0.0f && glm::dot(d, coneAxis) >= coneCutoff * len;
+    }
+};
+
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// `idx` points at the meshlet's own first index.
+inline void ComputeMeshletBounds(Meshlet& m, const uint32_t* idx, const glm::vec3* positions) {
+    size_t triCount = m.indexCount / 3;
+
+    glm::vec3 mn(1e30f), mx(-1e30f);
+    for (uint32_t i = 0; i < m.indexCount; ++i) {
+        mn = glm::min(mn, positions[idx[i]]);
+        mx = glm::max(mx, positions[idx[i]]);
+    }
+    m.center = 0.5f * (mn + mx);
+    m.radius = 0.0f;
+    for (uint32_t i = 0; i < m.indexCount; ++i) m.radius = std::max(m.radius, glm::length(positions[idx[i]] - m.center));
+
+    // Cone around the mean normal. The apex sits on the axis behind every
+    // triangle plane, so a camera inside the mirrored cone sees only backs.
+    glm::vec3 sum(0.0f);
+    for (size_t t = 0; t < triCount; ++t) {
+        glm::vec3 n = glm::cross(positions[idx[t * 3 + 1]] - positions[idx[t * 3]], positions[idx[t * 3 + 2]] - positions[idx[t * 3]]);
+        float len = glm::length(n);
+        if (len > 0.0f) sum += n / len;
+    }
+    m.coneCutoff = 1.0f;
+    float sumLen = glm::length(sum);
+    if (sumLen <= 0.0f) return;
+    m.coneAxis = sum / sumLen;
+
+    float minDot = 1.0f;
+    float maxT = 0.0f;
+    for (size_t t = 0; t < triCount; ++t) {
+        const glm::vec3& p0 = positions[idx[t * 3]];
+        glm::vec3 n = glm::cross(positions[idx[t * 3 + 1]] - p0, positions[idx[t * 3 + 2]] - p0);
+        float len = glm::length(n);
+        if (len <= 0.0f) continue;
+        n /= len;
+        float dn = glm::dot(m.coneAxis, n);
+        minDot = std::min(minDot, dn);
+        if (dn > 0.0f) maxT = std::max(maxT, glm::dot(m.center - p0, n) / dn);
+    }
+    // Nearly flat-out spreads cull almost nothing and make the apex run off.
+    if (minDot <= 0.1f) return;
+    m.coneApex = m.center - m.coneAxis * maxT;
+    m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+// Greedy split of a triangle list (ideally already in vertex cache order) into
+// consecutive meshlets; `firstIndex` offsets the resulting ranges.
+inline void BuildMeshlets(std::vector<Meshlet>& out, const uint32_t* indices, size_t indexCount, const glm::vec3* positions,
+    size_t vertexCount, uint32_t firstIndex = 0,
+    uint32_t maxVertices = MESHLET_MAX_VERTICES, uint32_t maxTriangles = MESHLET_MAX_TRIANGLES)
+{
+    std::vector<uint32_t> seen(vertexCount, ~0u);
+    Meshlet cur;
+    uint32_t id = 0;
+    auto Flush = [&] {
+        if (cur.indexCount == 0) return;
+        ComputeMeshletBounds(cur, indices + (cur.firstIndex - firstIndex), positions);
+        out.push_back(cur);
+        cur = Meshlet();
+        ++id;
+    };
+
+    cur.firstIndex = firstIndex;
+    for (size_t t = 0; t + 2 < indexCount; t += 3) {
+        const uint32_t* tri = indices + t;
+        uint32_t added = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (seen[tri[k]] != id && (k < 1 || tri[k] != tri[0]) && (k < 2 || tri[k] != tri[1])) added++;
+        }
+        if (cur.vertexCount + added > maxVertices || cur.indexCount / 3 + 1 > maxTriangles) {
+            Flush();
+            cur.firstIndex = firstIndex + (uint32_t)t;
+        }
+        for (int k = 0; k < 3; ++k) {
+            if (seen[tri[k]] != id) {
+                seen[tri[k]] = id;
+                cur.vertexCount++;
+            }
+        }
+        cur.indexCount += 3;
+    }
+    Flush();
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "MeshLibrary.h"
+
+// One part of a prefab, in prefab-local space: mesh `mesh` (a MeshLibrary id,
+// fitting the unit cube) under `local`.
+struct PrefabBox {
+    glm::mat4 local;
+    glm::vec3 color;
+    uint32_t mesh = 0;
+};
+
+// Consecutive boxes of one prefab that share a mesh; drawn with one call.
+struct PrefabRun {
+    uint32_t firstBox = 0;
+    uint32_t boxCount = 0;
+    uint32_t mesh = 0;
+};
+
+struct Prefab {
+    uint32_t firstBox = 0;
+    uint32_t boxCount = 0;
+    uint32_t firstRun = 0;
+    uint32_t runCount = 0;
+    glm::vec3 boundsMin{ 0.0f };
+    glm::vec3 boundsMax{ 0.0f };
+};
+
+// Identifies a prefab by its kind plus whatever parameters change its local
+// boxes (sizes, colors); everything else goes in the instance transform.
+struct PrefabKey {
+    uint32_t kind = 0;
+    float params[4] = {};
+
+    bool operator==(const PrefabKey& o) const {
+        return kind == o.kind && std::memcmp(params, o.params, sizeof(params)) == 0;
+    }
+
+    uint64_t Hash() const {
+        uint64_t h = 14695981039346656037ull ^ kind;
+        for (float p : params) {
+            uint32_t bits;
+            std::memcpy(&bits, &p, sizeof(bits));
+            h = (h ^ bits) * 1099511628211ull;
+        }
+        return h;
+    }
+};
+
+// Box clusters that repeat with a different parent transform (windows, lamps,
+// trees, ...). Local boxes are stored once; the scene holds only instances.
+class PrefabLibrary {
+public:
+    // GPU layout: every box is TEXELS_PER_BOX RGBA32F texels, the four model
+    // columns followed by the color.
+    static constexpr int TEXELS_PER_BOX = 5;
+
+    uint32_t Find(const PrefabKey& key) const {
+        auto range = index.equal_range(key.Hash());
+        for (auto it = range.first; it != range.second; ++it) {
+            if (keys[it->second] == key) return it->second;
+        }
+        return ~0u;
+    }
+
+    // Boxes are regrouped by mesh (stable within a mesh) so each mesh is one run.
+    uint32_t Add(const PrefabKey& key, const PrefabBox* src, size_t count) {
+        Prefab p;
+        p.firstBox = (uint32_t)boxes.size();
+        p.boxCount = (uint32_t)count;
+        p.firstRun = (uint32_t)runs.size();
+        p.boundsMin = glm::vec3(1e30f);
+        p.boundsMax = glm::vec3(-1e30f);
+        for (size_t i = 0; i < count; ++i) {
+            const glm::mat4& m = src[i].local;
+            glm::vec3 c(m[3]);
+            glm::vec3 e = 0.5f * (glm::abs(glm::vec3(m[0])) + glm::abs(glm::vec3(m[1])) + glm::abs(glm::vec3(m[2])));
+            p.boundsMin = glm::min(p.boundsMin, c - e);
+            p.boundsMax = glm::max(p.boundsMax, c + e);
+        }
+
+        boxes.insert(boxes.end(), src, src + count);
+        std::stable_sort(boxes.begin() + p.firstBox, boxes.end(),
+            [](const PrefabBox& a, const PrefabBox& b) { return a.mesh < b.mesh; });
+        for (uint32_t i = p.firstBox; i < (uint32_t)boxes.size(); ++i) {
+            if (i == p.firstBox || boxes[i].mesh != boxes[i - 1].mesh) runs.push_back({ i, 0, boxes[i].mesh });
+            runs.back().boxCount++;
+        }
+        p.runCount = (uint32_t)runs.size() - p.firstRun;
+
+        prefabs.push_back(p);
+        keys.push_back(key);
+        index.emplace(key.Hash(), (uint32_t)prefabs.size() - 1);
+        return (uint32_t)prefabs.size() - 1;
+    }
+
+    // Appends the prefabs of `other` this library has no key for; returns the
+    // id here of every prefab id of `other`. Equal keys mean equal boxes, so
+    // lots built from the same builders share their prefabs. Built meshes (ids
+    // past the primitives) are shifted by `meshOffset`, see MeshLibrary::Append.
+    std::vector<uint32_t> Append(const PrefabLibrary& other, uint32_t meshOffset = 0) {
+        return AppendMapped(other, [meshOffset](uint32_t mesh) { return mesh >= MESH_PRIMITIVE_COUNT ? mesh + meshOffset : mesh; });
+    }
+
+    // Same, with mesh ids mapped through `meshRemap` (MeshLibrary::AppendShared).
+    // Bare prefabs of `other` become the bare prefabs here of their meshes.
+    std::vector<uint32_t> Append(const PrefabLibrary& other, const std::vector<uint32_t>& meshRemap) {
+        return AppendMapped(other, [&meshRemap](uint32_t mesh) { return meshRemap[mesh]; });
+    }
+
+    // Prefabs 0..meshCount-1 become one bare, white, untransformed mesh each,
+    // so a plain item of mesh m draws as an instance of prefab m. Call on an
+    // empty library.
+    void AddBareMeshes(uint32_t meshCount) {
+        for (uint32_t m = 0; m < meshCount; ++m) AddBareMesh(m);
+    }
+
+    // The bare prefab of `mesh`, added on first use. Meshes that arrive after
+    // the scene build (streamed lots) get theirs past the other prefabs.
+    uint32_t AddBareMesh(uint32_t mesh) {
+        if (mesh < bare.size() && bare[mesh] != ~0u) return bare[mesh];
+        PrefabBox box{ glm::mat4(1.0f), glm::vec3(1.0f), mesh };
+        PrefabKey key;
+        key.kind = BARE_KIND;
+        key.params[0] = (float)mesh;
+        if (mesh >= bare.size()) bare.resize(mesh + 1, ~0u);
+        bare[mesh] = Add(key, &box, 1);
+        return bare[mesh];
+    }
+
+    size_t Count() const { return prefabs.size(); }
+    // The prefab a plain item of `mesh` draws as. Meshes added after the scene
+    // build without AddBareMesh (LOD proxies) have none; they only appear
+    // inside other prefabs.
+    uint32_t BarePrefab(uint32_t mesh) const { return bare[mesh]; }
+    // The mesh of a bare prefab, ~0u for every other prefab.
+    uint32_t BareMesh(uint32_t prefab) const { return keys[prefab].kind == BARE_KIND ? (uint32_t)keys[prefab].params[0] : ~0u; }
+    const Prefab& Get(uint32_t id) const { return prefabs[id]; }
+    const PrefabRun& Run(uint32_t id) const { return runs[id]; }
+    const PrefabBox& Box(uint32_t id) const { return boxes[id]; }
+    size_t BoxCount() const { return boxes.size(); }
+    size_t RunCount() const { return runs.size(); }
+
+    std::vector<glm::vec4> PackTexels(size_t firstBox = 0) const {
+        std::vector<glm::vec4> texels;
+        texels.reserve((boxes.size() - firstBox) * TEXELS_PER_BOX);
+        for (size_t i = firstBox; i < boxes.size(); ++i) {
+            const PrefabBox& b = boxes[i];
+            for (int c = 0; c < 4; ++c) texels.push_back(b.local[c]);
+            texels.push_back(glm::vec4(b.color, 1.0f));
+        }
+        return texels;
+    }
+
+    size_t MemoryBytes() const {
+        return boxes.capacity() * sizeof(PrefabBox) + runs.capacity() * sizeof(PrefabRun) +
+            prefabs.capacity() * sizeof(Prefab) + keys.capacity() * sizeof(PrefabKey) + bare.capacity() * sizeof(uint32_t) +
+            index.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*));
+    }
+
+private:
+    template <class F>
+    std::vector<uint32_t> AppendMapped(const PrefabLibrary& other, F&& meshOf) {
+        std::vector<uint32_t> remap(other.prefabs.size());
+        for (size_t i = 0; i < other.prefabs.size(); ++i) {
+            uint32_t bareMesh = other.BareMesh((uint32_t)i);
+            if (bareMesh != ~0u) {
+                remap[i] = AddBareMesh(meshOf(bareMesh));
+                continue;
+            }
+            remap[i] = Find(other.keys[i]);
+            if (remap[i] != ~0u) continue;
+
+            const Prefab& src = other.prefabs[i];
+            Prefab p = src;
+            p.firstBox = (uint32_t)boxes.size();
+            p.firstRun = (uint32_t)runs.size();
+            for (uint32_t r = 0; r < src.runCount; ++r) {
+                PrefabRun run = other.runs[src.firstRun + r];
+                run.firstBox = run.firstBox - src.firstBox + p.firstBox;
+                run.mesh = meshOf(run.mesh);
+                runs.push_back(run);
+            }
+            for (uint32_t b = 0; b < src.boxCount; ++b) {
+                PrefabBox box = other.boxes[src.firstBox + b];
+                box.mesh = meshOf(box.mesh);
+                boxes.push_back(box);
+            }
+            prefabs.push_back(p);
+            keys.push_back(other.keys[i]);
+            index.emplace(other.keys[i].Hash(), (uint32_t)prefabs.size() - 1);
+            remap[i] = (uint32_t)prefabs.size() - 1;
+        }
+        return remap;
+    }
+
+    static constexpr uint32_t BARE_KIND = ~0u;
+
+    std::vector<PrefabBox> boxes;
+    std::vector<PrefabRun> runs;
+    std::vector<Prefab> prefabs;
+    std::vector<PrefabKey> keys;
+    std::unordered_multimap<uint64_t, uint32_t> index;
+    // Mesh -> its bare prefab (~0u: none).
+    std::vector<uint32_t> bare;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+
+// PCG32 (O'Neill, pcg-random.org): 64-bit state, 32-bit output, and a
+// selectable stream so each scatter subsystem gets an independent sequence
+// from the same scene seed.
+struct Pcg32 {
+    uint64_t state = 0;
+    uint64_t inc = 1;
+
+    Pcg32() { Seed(0, 0); }
+    Pcg32(uint64_t seed, uint64_t stream) { Seed(seed, stream); }
+
+    void Seed(uint64_t seed, uint64_t stream) {
+        state = 0u;
+        inc = (stream << 1u) | 1u;
+        NextU32();
+        state += seed;
+        NextU32();
+    }
+
+    uint32_t NextU32() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    // Unbiased integer in [0, n) (Lemire's multiply-shift with rejection).
+    uint32_t Below(uint32_t n) {
+        if (n == 0) return 0;
+        uint64_t m = (uint64_t)NextU32() * n;
+        uint32_t l = (uint32_t)m;
+        if (l < n) {
+            uint32_t t = (0u - n) % n;
+            while (l < t) {
+                m = (uint64_t)NextU32() * n;
+                l = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    int Int(int n) { return n > 0 ? (int)Below((uint32_t)n) : 0; }
+
+    // [0, 1) with 24 bits of mantissa.
+    float Uniform() { return (float)(NextU32() >> 8) * (1.0f / 16777216.0f); }
+    float Uniform(float a, float b) { return a + (b - a) * Uniform(); }
+
+    bool Coin() { return (NextU32() & 0x80000000u) != 0; }
+};
+
+enum class RngStream : uint64_t {
+    Pines = 1,
+    Clouds,
+    Grass,
+    Flowers,
+    LotStyle,
+    Terrain,
+};
+
+inline Pcg32 MakeRng(uint64_t seed, RngStream stream) {
+    return Pcg32(seed, (uint64_t)stream);
+}
+
+// SplitMix64 finalizer over (seed, n): independent seeds for numbered
+// sub-scenes (lots of a grid) from one scene seed.
+inline uint64_t MixSeed(uint64_t seed, uint64_t n) {
+    uint64_t z = seed + (n + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
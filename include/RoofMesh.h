@@ -0,0 +1,79 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "MeshLibrary.h"
+
+// Closed roof solids, built in world space. Faces are flat-shaded but meet
+// exactly along every edge: no gaps, no overlapping slabs, no ridge caps.
+
+// Extrudes `profile` (x along `span`, y = world height), counter-clockwise
+// seen from +`ridge`, along `ridge` over -halfLen..halfLen from `origin`.
+// span x up must equal ridge. Caps are fanned from profile[0].
+inline void ExtrudeProfile(MeshBuilder& b, const glm::vec3& origin, const glm::vec3& span, const glm::vec3& ridge,
+    const glm::vec2* profile, int count, float halfLen)
+{
+    auto At = [&](const glm::vec2& p, float along) {
+        return origin + span * p.x + glm::vec3(0.0f, p.y, 0.0f) + ridge * along;
+    };
+    for (int k = 0; k < count; ++k) {
+        const glm::vec2& p0 = profile[k];
+        const glm::vec2& p1 = profile[(k + 1) % count];
+        b.FlatQuad(At(p0, -halfLen), At(p1, -halfLen), At(p1, halfLen), At(p0, halfLen));
+    }
+
+    glm::vec3 capFront[8], capBack[8];
+    for (int k = 0; k < count; ++k) {
+        capFront[k] = At(profile[k], halfLen);
+        capBack[k] = At(profile[(count - k) % count], -halfLen);
+    }
+    b.FlatPolygon(capFront, count);
+    b.FlatPolygon(capBack, count);
+}
+
+// Gable roof centered on `center` (x, z) with its ridge along X or Z. The
+// underside rises `rise` from the eaves (eaveY, halfSpan out) to the ridge;
+// `thk` is measured square to the slope. Returns the top of the ridge.
+inline float BuildGableRoofMesh(MeshBuilder& b, const glm::vec3& center, bool ridgeAlongX,
+    float halfSpan, float halfLen, float eaveY, float rise, float thk)
+{
+    float t = thk / std::cos(std::atan2(rise, halfSpan));
+    glm::vec2 profile[6] = {
+        { 0.0f, eaveY + rise + t },
+        { -halfSpan, eaveY + t },
+        { -halfSpan, eaveY },
+        { 0.0f, eaveY + rise },
+        { halfSpan, eaveY },
+        { halfSpan, eaveY + t },
+    };
+    glm::vec3 origin(center.x, 0.0f, center.z);
+    if (ridgeAlongX) ExtrudeProfile(b, origin, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, 0.0f), profile, 6, halfLen);
+    else ExtrudeProfile(b, origin, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), profile, 6, halfLen);
+    return eaveY + rise + t;
+}
+
+// Hipped ring sloping up from an outer rectangle to an inner one (half sizes
+// in x, z), e.g. a skirt roof around a flat deck. The top surface runs from
+// outerTopY to innerTopY; the underside is `thk` below it.
+inline void BuildSkirtRoofMesh(MeshBuilder& b, const glm::vec3& center, const glm::vec2& halfOuter, const glm::vec2& halfInner,
+    float outerTopY, float innerTopY, float thk)
+{
+    // Corners counter-clockwise seen from above.
+    const glm::vec2 corner[4] = { { 1.0f, 1.0f }, { 1.0f, -1.0f }, { -1.0f, -1.0f }, { -1.0f, 1.0f } };
+    glm::vec3 ot[4], ob[4], it[4], ib[4];
+    for (int k = 0; k < 4; ++k) {
+        glm::vec3 o(center.x + corner[k].x * halfOuter.x, 0.0f, center.z + corner[k].y * halfOuter.y);
+        glm::vec3 in(center.x + corner[k].x * halfInner.x, 0.0f, center.z + corner[k].y * halfInner.y);
+        ot[k] = o + glm::vec3(0.0f, outerTopY, 0.0f);
+        ob[k] = o + glm::vec3(0.0f, outerTopY - thk, 0.0f);
+        it[k] = in + glm::vec3(0.0f, innerTopY, 0.0f);
+        ib[k] = in + glm::vec3(0.0f, innerTopY - thk, 0.0f);
+    }
+    for (int k = 0; k < 4; ++k) {
+        int n = (k + 1) % 4;
+        b.FlatQuad(ot[k], ot[n], it[n], it[k]);
+        b.FlatQuad(ob[n], ob[k], ib[k], ib[n]);
+        b.FlatQuad(ob[k], ob[n], ot[n], ot[k]);
+        b.FlatQuad(ib[n], ib[k], it[k], it[n]);
+    }
+}
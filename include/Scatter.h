@@ -0,0 +1,228 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <climits>
+
+#include "Random.h"
+
+struct ScatterRect {
+    float minX = 0.0f, minZ = 0.0f, maxX = 0.0f, maxZ = 0.0f;
+
+    static ScatterRect FromCenter(float cx, float cz, float halfX, float halfZ) {
+        return { cx - halfX, cz - halfZ, cx + halfX, cz + halfZ };
+    }
+
+    bool Contains(float x, float z) const { return x >= minX && x <= maxX && z >= minZ && z <= maxZ; }
+    float Area() const { return std::max(0.0f, maxX - minX) * std::max(0.0f, maxZ - minZ); }
+
+    ScatterRect Intersect(const ScatterRect& o) const {
+        return { std::max(minX, o.minX), std::max(minZ, o.minZ), std::min(maxX, o.maxX), std::min(maxZ, o.maxZ) };
+    }
+};
+
+struct ScatterSpecies {
+    int id = 0;
+    float minSpacing = 1.0f;
+    float density = 0.0f;       // instances per square unit of allowed area
+    int maxCount = INT_MAX;
+    uint32_t mask = 1u;         // which exclusions apply (ScatterField::AddExclusion)
+};
+
+struct ScatterPoint {
+    float x, z;
+    float radius;
+    int species;
+};
+
+// Blue-noise placement (Bridson's Poisson-disk sampling) over a rectangular
+// field. All accepted points, from every species and any fixed obstacles, live
+// in one grid spatial hash, so later species keep their distance from earlier
+// ones: two points stay at least (ra + rb) / 2 apart.
+class ScatterField {
+public:
+    ScatterField(const ScatterRect& bounds, float cellSize)
+        : bounds(bounds), cell(std::max(0.05f, cellSize)) {
+        gw = std::max(1, (int)std::ceil((bounds.maxX - bounds.minX) / cell));
+        gh = std::max(1, (int)std::ceil((bounds.maxZ - bounds.minZ) / cell));
+        head.assign((size_t)gw * gh, -1);
+    }
+
+    void AddExclusion(const ScatterRect& r, uint32_t mask = ~0u) { exclusions.push_back({ r, mask }); }
+
+    bool IsExcluded(float x, float z, uint32_t mask) const {
+        if (!bounds.Contains(x, z)) return true;
+        for (const auto& e : exclusions) {
+            if ((e.mask & mask) && e.rect.Contains(x, z)) return true;
+        }
+        return false;
+    }
+
+    bool IsFree(float x, float z, float r) const {
+        float reach = (r + maxRadius) * 0.5f;
+        int cx = CellX(x), cz = CellZ(z);
+        int span = (int)std::ceil(reach / cell);
+        int x0 = std::max(0, cx - span), x1 = std::min(gw - 1, cx + span);
+        int z0 = std::max(0, cz - span), z1 = std::min(gh - 1, cz + span);
+        for (int gz = z0; gz <= z1; ++gz) {
+            for (int gx = x0; gx <= x1; ++gx) {
+                for (int i = head[(size_t)gz * gw + gx]; i >= 0; i = nodes[i].next) {
+                    const Node& p = nodes[i];
+                    float need = (r + p.radius) * 0.5f;
+                    float dx = p.x - x, dz = p.z - z;
+                    if (dx * dx + dz * dz < need * need) return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void Insert(float x, float z, float r) {
+        int idx = (int)nodes.size();
+        size_t c = (size_t)CellZ(z) * gw + CellX(x);
+        nodes.push_back({ x, z, r, head[c] });
+        head[c] = idx;
+        maxRadius = std::max(maxRadius, r);
+    }
+
+    // A maximal Poisson-disk set of radius r holds about 0.7 / r^2 points per
+    // unit area, so darts this many 1 / sqrt(density) apart land a little over
+    // the target and the thinning has only a few to drop.
+    static constexpr float DENSITY_SPACING = 0.75f;
+
+    // Fills the allowed part of `area` with Poisson-disk samples for `sp`, then
+    // thins them uniformly to density * allowedArea (capped by maxCount). The
+    // samples are spaced for the density (never closer than minSpacing), so the
+    // work follows the number placed rather than area / minSpacing^2. Kept
+    // points enter the field at minSpacing. Returns the number of placements
+    // appended to `out`.
+    size_t Scatter(const ScatterSpecies& sp, const ScatterRect& area, Pcg32& rng,
+        std::vector<ScatterPoint>& out, int k = 16) {
+        ScatterRect a = area.Intersect(bounds);
+        if (a.Area() <= 0.0f) return 0;
+
+        float r = sp.minSpacing;
+        if (sp.density > 0.0f) r = std::max(r, DENSITY_SPACING / std::sqrt(sp.density));
+        float stepCos = std::cos(6.2831853f / (float)k);
+        float stepSin = std::sin(6.2831853f / (float)k);
+        // Points r apart pack no denser than a hexagonal lattice, so this bounds
+        // the number of samples and the buffers are sized once.
+        size_t bound = (size_t)(a.Area() / (0.866f * r * r)) + 2 * (size_t)((a.maxX - a.minX + a.maxZ - a.minZ) / r) + 4;
+        std::vector<ScatterPoint> found;
+        std::vector<int> active;
+        found.reserve(bound);
+        active.reserve(bound);
+
+        // This species' own samples, at most one per cell of diagonal r, so
+        // a candidate only looks two cells around it.
+        float lc = r * 0.70710678f;
+        int lw = std::max(1, (int)std::ceil((a.maxX - a.minX) / lc));
+        int lh = std::max(1, (int)std::ceil((a.maxZ - a.minZ) / lc));
+        std::vector<int> own((size_t)lw * lh, -1);
+
+        auto tryAccept = [&](float x, float z) {
+            if (!a.Contains(x, z) || IsExcluded(x, z, sp.mask) || !IsFree(x, z, sp.minSpacing)) return false;
+            int cx = std::min(lw - 1, (int)((x - a.minX) / lc));
+            int cz = std::min(lh - 1, (int)((z - a.minZ) / lc));
+            for (int gz = std::max(0, cz - 2); gz <= std::min(lh - 1, cz + 2); ++gz) {
+                for (int gx = std::max(0, cx - 2); gx <= std::min(lw - 1, cx + 2); ++gx) {
+                    int i = own[(size_t)gz * lw + gx];
+                    if (i < 0) continue;
+                    float dx = found[i].x - x, dz = found[i].z - z;
+                    if (dx * dx + dz * dz < r * r) return false;
+                }
+            }
+            own[(size_t)cz * lw + cx] = (int)found.size();
+            found.push_back({ x, z, sp.minSpacing, sp.id });
+            active.push_back((int)found.size() - 1);
+            return true;
+        };
+
+        // Exclusions can cut the area into islands that a single front never
+        // reaches, so keep re-seeding with random darts until they stop landing.
+        int missedDarts = 0;
+        while (missedDarts < 32) {
+            if (!tryAccept(rng.Uniform(a.minX, a.maxX), rng.Uniform(a.minZ, a.maxZ))) {
+                ++missedDarts;
+                continue;
+            }
+            missedDarts = 0;
+
+            while (!active.empty()) {
+                size_t slot = rng.Below((uint32_t)active.size());
+                const ScatterPoint src = found[active[slot]];
+
+                // Candidates sit just outside the spacing radius at k evenly
+                // rotated angles from one random start (Roberts' variant):
+                // tighter packing, and one sin/cos per attempt instead of per candidate.
+                float ang = rng.Uniform() * 6.2831853f;
+                float dx = std::cos(ang) * r * 1.0001f, dz = std::sin(ang) * r * 1.0001f;
+                bool spawned = false;
+                for (int t = 0; t < k; ++t) {
+                    if (tryAccept(src.x + dx, src.z + dz)) {
+                        spawned = true;
+                        break;
+                    }
+                    float ndx = dx * stepCos - dz * stepSin;
+                    dz = dx * stepSin + dz * stepCos;
+                    dx = ndx;
+                }
+                if (!spawned) {
+                    active[slot] = active.back();
+                    active.pop_back();
+                }
+            }
+        }
+
+        size_t target = found.size();
+        if (sp.density > 0.0f) {
+            target = std::min(target, (size_t)std::lround(sp.density * AllowedArea(a, sp.mask)));
+        }
+        target = std::min(target, (size_t)std::max(0, sp.maxCount));
+
+        // Partial Fisher-Yates: a uniform random subset keeps the blue-noise spacing.
+        for (size_t i = 0; i < target; ++i) {
+            size_t j = i + rng.Below((uint32_t)(found.size() - i));
+            std::swap(found[i], found[j]);
+        }
+        nodes.reserve(nodes.size() + target);
+        for (size_t i = 0; i < target; ++i) Insert(found[i].x, found[i].z, sp.minSpacing);
+
+        out.insert(out.end(), found.begin(), found.begin() + target);
+        return target;
+    }
+
+    float AllowedArea(const ScatterRect& area, uint32_t mask) const {
+        ScatterRect a = area.Intersect(bounds);
+        float total = a.Area();
+        for (const auto& e : exclusions) {
+            if (e.mask & mask) total -= e.rect.Intersect(a).Area();
+        }
+        return std::max(0.0f, total);
+    }
+
+private:
+    struct Exclusion {
+        ScatterRect rect;
+        uint32_t mask;
+    };
+
+    struct Node {
+        float x, z;
+        float radius;
+        int next;
+    };
+
+    int CellX(float x) const { return std::min(gw - 1, std::max(0, (int)((x - bounds.minX) / cell))); }
+    int CellZ(float z) const { return std::min(gh - 1, std::max(0, (int)((z - bounds.minZ) / cell))); }
+
+    ScatterRect bounds;
+    float cell;
+    int gw = 1, gh = 1;
+    float maxRadius = 0.0f;
+
+    std::vector<int> head;
+    std::vector<Node> nodes;
+    std::vector<Exclusion> exclusions;
+};
@@ -0,0 +1,502 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <glm/glm.hpp>
+
+#include "Arena.h"
+#include "TransformHierarchy.h"
+
+// Components. Each one is a plain struct with a unique bit; an archetype is the
+// set of bits an entity carries.
+struct Transform {
+    static constexpr uint32_t Bit = 1u << 0;
+    glm::mat4 model;
+};
+
+struct Bounds {
+    static constexpr uint32_t Bit = 1u << 1;
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct Material {
+    static constexpr uint32_t Bit = 1u << 2;
+    glm::vec3 color;
+};
+
+enum : uint32_t { LAYER_STATIC = 1u, LAYER_DYNAMIC = 2u, LAYER_CAST_SHADOW = 4u };
+
+struct Layer {
+    static constexpr uint32_t Bit = 1u << 3;
+    uint32_t flags;
+};
+
+// Member of LOD group `group`, drawn only while that group's selected level
+// is `level`: 0 for the full-detail items, 1.. for the simplified proxies.
+struct Lod {
+    static constexpr uint32_t Bit = 1u << 4;
+    uint32_t group;
+    uint32_t level;
+};
+
+enum : uint32_t { MOTION_DRIFT = 0u, MOTION_SHUTTLE = 1u, MOTION_PARENT = 2u };
+
+// Makes an item dynamic (LAYER_DYNAMIC): each frame its Transform is moved
+// along `axis` from `rest`, its translation at build time (see AnimOffset).
+// MOTION_DRIFT runs at `speed` m/s and wraps every `range` meters, `phase`
+// meters into the span; MOTION_SHUTTLE eases out `range` meters and back,
+// `speed` radians per second from angle `phase`. MOTION_PARENT items do not
+// move by themselves but with their Parent node. With a Pivot, the Anim moves
+// that node's local translation instead.
+struct Anim {
+    static constexpr uint32_t Bit = 1u << 5;
+    float phase;
+    float speed;
+    uint32_t motion;
+    float range;
+    glm::vec3 axis;
+    glm::vec3 rest;
+};
+
+// Marks an instance of a PrefabLibrary entry; its Transform is the parent
+// transform and its Bounds cover the whole prefab.
+struct PrefabRef {
+    static constexpr uint32_t Bit = 1u << 6;
+    uint32_t prefab;
+};
+
+// Which MeshLibrary mesh a plain item draws (it still fits the unit cube).
+struct MeshRef {
+    static constexpr uint32_t Bit = 1u << 7;
+    uint32_t mesh;
+};
+
+// Sways in the wind: bends fully `stiffness` meters above `baseY`, swinging
+// on `phase` (radians). Only the vertex shader moves it; the Transform stays.
+struct Wind {
+    static constexpr uint32_t Bit = 1u << 8;
+    float phase;
+    float stiffness;
+    float baseY;
+};
+
+// Child of node `node` of the world's hierarchy (SceneWorld::Nodes): its
+// Transform is World(node) * local, refreshed whenever the node moves.
+struct Parent {
+    static constexpr uint32_t Bit = 1u << 9;
+    uint32_t node;
+    glm::mat4 local;
+};
+
+// An entity of its own that moves hierarchy node `node` by its Anim.
+struct Pivot {
+    static constexpr uint32_t Bit = 1u << 10;
+    uint32_t node;
+};
+
+constexpr int COMPONENT_COUNT = 11;
+
+struct Entity {
+    uint32_t index = ~0u;
+    uint32_t generation = 0;
+};
+
+namespace SceneWorldDetail {
+struct ComponentInfo {
+    size_t size;
+    size_t align;
+};
+
+inline const ComponentInfo& Info(int bitIndex) {
+    static const ComponentInfo table[COMPONENT_COUNT] = {
+        { sizeof(Transform), alignof(Transform) },
+        { sizeof(Bounds), alignof(Bounds) },
+        { sizeof(Material), alignof(Material) },
+        { sizeof(Layer), alignof(Layer) },
+        { sizeof(Lod), alignof(Lod) },
+        { sizeof(Anim), alignof(Anim) },
+        { sizeof(PrefabRef), alignof(PrefabRef) },
+        { sizeof(MeshRef), alignof(MeshRef) },
+        { sizeof(Wind), alignof(Wind) },
+        { sizeof(Parent), alignof(Parent) },
+        { sizeof(Pivot), alignof(Pivot) },
+    };
+    return table[bitIndex];
+}
+
+template <class T>
+constexpr int BitIndex() {
+    int i = 0;
+    while ((1u << i) != T::Bit) ++i;
+    return i;
+}
+} // namespace SceneWorldDetail
+
+// Entity-component store. Entities with the same component set share an
+// archetype whose storage is a list of fixed-size chunks; inside a chunk every
+// component is its own contiguous column, so a system touches only the columns
+// it asks for. Chunk memory comes from `arena` when one is given (build-time
+// staging worlds), otherwise from the heap. The world also owns the transform
+// hierarchy its Parent and Pivot components point into.
+class SceneWorld {
+public:
+    static constexpr uint32_t CHUNK_CAPACITY = 128;
+
+    struct Chunk {
+        uint32_t count = 0;
+        unsigned char* data = nullptr;
+        Entity* entities = nullptr;
+        void* columns[COMPONENT_COUNT] = {};
+    };
+
+    class ChunkView {
+    public:
+        ChunkView(const Chunk& c, uint32_t mask) : chunk(&c), mask(mask) {}
+
+        uint32_t Count() const { return chunk->count; }
+        uint32_t Mask() const { return mask; }
+        bool Has(uint32_t bits) const { return (mask & bits) == bits; }
+        const Entity* Entities() const { return chunk->entities; }
+
+        template <class T>
+        T* Column() const {
+            return static_cast<T*>(chunk->columns[SceneWorldDetail::BitIndex<T>()]);
+        }
+
+    private:
+        const Chunk* chunk;
+        uint32_t mask;
+    };
+
+    explicit SceneWorld(Arena* arena = nullptr) : arena(arena) {}
+    ~SceneWorld() {
+        if (arena) return;
+        for (const Archetype& a : archetypes) {
+            for (const Chunk& c : a.chunks) delete[] c.data;
+        }
+    }
+
+    SceneWorld(const SceneWorld&) = delete;
+    SceneWorld& operator=(const SceneWorld&) = delete;
+    SceneWorld(SceneWorld&&) = default;
+
+    Entity Create(uint32_t mask) {
+        if (mask & Parent::Bit) childrenStale = true;
+        Archetype& a = FindOrAddArchetype(mask);
+        Chunk& c = OpenChunk(a);
+        Entity e = NewSlot((uint32_t)(&a - archetypes.data()), a.used - 1, c.count);
+        c.entities[c.count] = e;
+        for (int i = 0; i < COMPONENT_COUNT; ++i) {
+            if (c.columns[i]) {
+                size_t sz = SceneWorldDetail::Info(i).size;
+                std::memset(static_cast<unsigned char*>(c.columns[i]) + sz * c.count, 0, sz);
+            }
+        }
+        ++c.count;
+        return e;
+    }
+
+    bool IsAlive(Entity e) const {
+        return e.index < slots.size() && slots[e.index].alive && slots[e.index].generation == e.generation;
+    }
+
+    template <class T>
+    T* Get(Entity e) {
+        if (!IsAlive(e)) return nullptr;
+        const Slot& s = slots[e.index];
+        Chunk& c = archetypes[s.archetype].chunks[s.chunk];
+        T* col = static_cast<T*>(c.columns[SceneWorldDetail::BitIndex<T>()]);
+        return col ? col + s.row : nullptr;
+    }
+
+    // Moves the archetype's last row into the hole, so chunks stay dense.
+    void Destroy(Entity e) {
+        if (!IsAlive(e)) return;
+        Slot& s = slots[e.index];
+        Archetype& a = archetypes[s.archetype];
+        if (a.mask & Parent::Bit) childrenStale = true;
+        Chunk& dst = a.chunks[s.chunk];
+        Chunk& src = a.chunks[a.used - 1];
+        uint32_t last = src.count - 1;
+
+        if (&dst != &src || s.row != last) {
+            CopyRows(dst, s.row, src, last, 1);
+            Entity moved = src.entities[last];
+            dst.entities[s.row] = moved;
+            slots[moved.index].chunk = s.chunk;
+            slots[moved.index].row = s.row;
+        }
+        if (--src.count == 0) --a.used;
+
+        s.alive = false;
+        s.generation++;
+        freeSlots.push_back(e.index);
+        --alive;
+    }
+
+    // Allocates chunks up front so the next `count` entities of `mask` need no
+    // further chunk allocations.
+    void Reserve(uint32_t mask, size_t count) {
+        Archetype& a = FindOrAddArchetype(mask);
+        size_t room = (a.chunks.size() - a.used) * CHUNK_CAPACITY;
+        if (a.used) room += CHUNK_CAPACITY - a.chunks[a.used - 1].count;
+        while (room < count) {
+            a.chunks.push_back(NewChunk(a));
+            room += CHUNK_CAPACITY;
+        }
+        slots.reserve(slots.size() + count);
+    }
+
+    template <class F>
+    void ForEachChunk(uint32_t required, F&& fn) {
+        for (const Archetype& a : archetypes) {
+            if ((a.mask & required) != required) continue;
+            for (uint32_t i = 0; i < a.used; ++i) fn(ChunkView(a.chunks[i], a.mask));
+        }
+    }
+
+    // fn(mask, count) for every archetype, in creation order.
+    template <class F>
+    void ForEachArchetype(F&& fn) const {
+        for (const Archetype& a : archetypes) {
+            size_t n = 0;
+            for (uint32_t i = 0; i < a.used; ++i) n += a.chunks[i].count;
+            fn(a.mask, n);
+        }
+    }
+
+    TransformHierarchy& Nodes() { return nodes; }
+    const TransformHierarchy& Nodes() const { return nodes; }
+
+    // fn(view, row) for every entity whose Parent node is in `nodeRange`, node
+    // by node. Parent nodes are read into an index on the first call after an
+    // entity with a Parent was created or destroyed, so set them right after
+    // Create.
+    template <class F>
+    void ForEachChild(const TransformHierarchy::Range& nodeRange, F&& fn) {
+        if (childrenStale || childStart.size() != nodes.Count() + 1) IndexChildren();
+        for (uint32_t k = childStart[nodeRange.begin]; k < childStart[nodeRange.end]; ++k) {
+            const Slot& s = slots[children[k]];
+            const Archetype& a = archetypes[s.archetype];
+            fn(ChunkView(a.chunks[s.chunk], a.mask), s.row);
+        }
+    }
+
+    // Copies every entity of `other` into this world, archetype by archetype in
+    // the order they were created there, one column range at a time. Its
+    // hierarchy nodes come along, with the Parent and Pivot ids shifted.
+    void Append(const SceneWorld& other) {
+        uint32_t nodeOffset = nodes.Append(other.nodes);
+        for (const Archetype& oa : other.archetypes) {
+            if (oa.mask & Parent::Bit) childrenStale = true;
+            Archetype* a = &FindOrAddArchetype(oa.mask);
+            uint32_t archetypeIndex = (uint32_t)(a - archetypes.data());
+            for (uint32_t ci = 0; ci < oa.used; ++ci) {
+                const Chunk& oc = oa.chunks[ci];
+                uint32_t done = 0;
+                while (done < oc.count) {
+                    Chunk& c = OpenChunk(*a);
+                    uint32_t n = std::min(oc.count - done, CHUNK_CAPACITY - c.count);
+                    CopyRows(c, c.count, oc, done, n);
+                    if (nodeOffset) OffsetNodes(c, c.count, n, nodeOffset);
+                    for (uint32_t r = 0; r < n; ++r) c.entities[c.count + r] = NewSlot(archetypeIndex, a->used - 1, c.count + r);
+                    c.count += n;
+                    done += n;
+                }
+            }
+        }
+    }
+
+    size_t Count() const { return alive; }
+
+    size_t MemoryBytes() const {
+        size_t bytes = slots.capacity() * sizeof(Slot) + freeSlots.capacity() * sizeof(uint32_t);
+        for (const Archetype& a : archetypes) bytes += a.chunks.size() * (a.chunkBytes + sizeof(Chunk));
+        bytes += (children.capacity() + childStart.capacity()) * sizeof(uint32_t);
+        return bytes + nodes.MemoryBytes();
+    }
+
+private:
+    // chunks[0, used) hold entities, all full except possibly the last one;
+    // chunks past `used` are empty reserves.
+    struct Archetype {
+        uint32_t mask = 0;
+        uint32_t used = 0;
+        size_t chunkBytes = 0;
+        size_t offsets[COMPONENT_COUNT] = {};
+        std::vector<Chunk> chunks;
+    };
+
+    struct Slot {
+        uint32_t archetype = 0;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+        bool alive = false;
+    };
+
+    static size_t AlignUp(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+
+    static void CopyRows(Chunk& dst, uint32_t dstRow, const Chunk& src, uint32_t srcRow, uint32_t rows) {
+        for (int i = 0; i < COMPONENT_COUNT; ++i) {
+            if (!dst.columns[i]) continue;
+            size_t sz = SceneWorldDetail::Info(i).size;
+            std::memcpy(static_cast<unsigned char*>(dst.columns[i]) + sz * dstRow,
+                static_cast<const unsigned char*>(src.columns[i]) + sz * srcRow, sz * rows);
+        }
+    }
+
+    // Counting sort of the Parent entities by node into children/childStart.
+    void IndexChildren() {
+        childStart.assign(nodes.Count() + 1, 0);
+        for (const Archetype& a : archetypes) {
+            if (!(a.mask & Parent::Bit)) continue;
+            for (uint32_t ci = 0; ci < a.used; ++ci) {
+                const Chunk& c = a.chunks[ci];
+                const Parent* p = static_cast<const Parent*>(c.columns[SceneWorldDetail::BitIndex<Parent>()]);
+                for (uint32_t r = 0; r < c.count; ++r) childStart[p[r].node + 1]++;
+            }
+        }
+        for (size_t i = 1; i < childStart.size(); ++i) childStart[i] += childStart[i - 1];
+        children.resize(childStart.back());
+        std::vector<uint32_t> cursor(childStart.begin(), childStart.end() - 1);
+        for (const Archetype& a : archetypes) {
+            if (!(a.mask & Parent::Bit)) continue;
+            for (uint32_t ci = 0; ci < a.used; ++ci) {
+                const Chunk& c = a.chunks[ci];
+                const Parent* p = static_cast<const Parent*>(c.columns[SceneWorldDetail::BitIndex<Parent>()]);
+                for (uint32_t r = 0; r < c.count; ++r) children[cursor[p[r].node]++] = c.entities[r].index;
+            }
+        }
+        childrenStale = false;
+    }
+
+    static void OffsetNodes(Chunk& c, uint32_t row, uint32_t rows, uint32_t offset) {
+        if (Parent* p = static_cast<Parent*>(c.columns[SceneWorldDetail::BitIndex<Parent>()])) {
+            for (uint32_t r = 0; r < rows; ++r) p[row + r].node += offset;
+        }
+        if (Pivot* p = static_cast<Pivot*>(c.columns[SceneWorldDetail::BitIndex<Pivot>()])) {
+            for (uint32_t r = 0; r < rows; ++r) p[row + r].node += offset;
+        }
+    }
+
+    Archetype& FindOrAddArchetype(uint32_t mask) {
+        for (Archetype& a : archetypes) {
+            if (a.mask == mask) return a;
+        }
+        Archetype a;
+        a.mask = mask;
+        size_t off = sizeof(Entity) * CHUNK_CAPACITY;
+        for (int i = 0; i < COMPONENT_COUNT; ++i) {
+            if (!(mask & (1u << i))) continue;
+            const SceneWorldDetail::ComponentInfo& info = SceneWorldDetail::Info(i);
+            off = AlignUp(off, std::max<size_t>(info.align, 16));
+            a.offsets[i] = off;
+            off += info.size * CHUNK_CAPACITY;
+        }
+        a.chunkBytes = off;
+        archetypes.push_back(std::move(a));
+        return archetypes.back();
+    }
+
+    Chunk NewChunk(const Archetype& a) {
+        Chunk c;
+        c.data = arena ? static_cast<unsigned char*>(arena->Allocate(a.chunkBytes, 16)) : new unsigned char[a.chunkBytes];
+        c.entities = reinterpret_cast<Entity*>(c.data);
+        for (int i = 0; i < COMPONENT_COUNT; ++i) {
+            if (a.mask & (1u << i)) c.columns[i] = c.data + a.offsets[i];
+        }
+        return c;
+    }
+
+    // The chunk new rows go into, opening a reserve or a new chunk when the
+    // current one is full.
+    Chunk& OpenChunk(Archetype& a) {
+        if (a.used == 0 || a.chunks[a.used - 1].count == CHUNK_CAPACITY) {
+            if (a.used == a.chunks.size()) a.chunks.push_back(NewChunk(a));
+            ++a.used;
+        }
+        return a.chunks[a.used - 1];
+    }
+
+    Entity NewSlot(uint32_t archetype, uint32_t chunk, uint32_t row) {
+        Entity e;
+        if (!freeSlots.empty()) {
+            e.index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            e.index = (uint32_t)slots.size();
+            slots.push_back(Slot());
+        }
+        Slot& s = slots[e.index];
+        e.generation = s.generation;
+        s.archetype = archetype;
+        s.chunk = chunk;
+        s.row = row;
+        s.alive = true;
+        ++alive;
+        return e;
+    }
+
+    Arena* arena = nullptr;
+    std::vector<Archetype> archetypes;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    size_t alive = 0;
+    TransformHierarchy nodes;
+    // Slot indices of the Parent entities, sorted by node; node n's are
+    // [childStart[n], childStart[n + 1]).
+    std::vector<uint32_t> children;
+    std::vector<uint32_t> childStart;
+    bool childrenStale = false;
+};
+
+static_assert(std::is_trivially_copyable<Transform>::value && std::is_trivially_copyable<Bounds>::value &&
+    std::is_trivially_copyable<Material>::value && std::is_trivially_copyable<Layer>::value &&
+    std::is_trivially_copyable<Lod>::value && std::is_trivially_copyable<Anim>::value &&
+    std::is_trivially_copyable<PrefabRef>::value && std::is_trivially_copyable<MeshRef>::value &&
+    std::is_trivially_copyable<Wind>::value && std::is_trivially_copyable<Parent>::value &&
+    std::is_trivially_copyable<Pivot>::value,
+    "SceneWorld stores components as raw bytes");
+
+// World-space box of the unit cube (-0.5..0.5) under `model`.
+inline Bounds UnitCubeBounds(const glm::mat4& model) {
+    glm::vec3 c(model[3]);
+    glm::vec3 e(0.0f);
+    for (int j = 0; j < 3; ++j) {
+        e.x += std::fabs(model[j][0]);
+        e.y += std::fabs(model[j][1]);
+        e.z += std::fabs(model[j][2]);
+    }
+    e *= 0.5f;
+    return { c - e, c + e };
+}
+
+// How far an Anim has moved its item from rest at time `t` (seconds).
+inline glm::vec3 AnimOffset(const Anim& a, float t) {
+    if (a.motion == MOTION_PARENT) return glm::vec3(0.0f);
+    if (a.motion == MOTION_SHUTTLE) return a.axis * (a.range * 0.5f * (1.0f - std::cos(a.phase + a.speed * t)));
+    float d = std::fmod(a.phase + a.speed * t, a.range);
+    if (d < 0.0f) d += a.range;
+    return a.axis * (d - a.phase);
+}
+
+// World-space box of the local box [mn, mx] under `model`.
+inline Bounds TransformBounds(const glm::mat4& model, const glm::vec3& mn, const glm::vec3& mx) {
+    glm::vec3 lc = (mn + mx) * 0.5f;
+    glm::vec3 le = (mx - mn) * 0.5f;
+    glm::vec3 c = glm::vec3(model[3]) + glm::vec3(model[0]) * lc.x + glm::vec3(model[1]) * lc.y + glm::vec3(model[2]) * lc.z;
+    glm::vec3 e(0.0f);
+    for (int j = 0; j < 3; ++j) {
+        e.x += std::fabs(model[j][0]) * le[j];
+        e.y += std::fabs(model[j][1]) * le[j];
+        e.z += std::fabs(model[j][2]) * le[j];
+    }
+    return { c - e, c + e };
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+enum class CellState : uint8_t { Absent, Loading, Resident };
+
+// Residency of a grid of square cells (lots) around a moving focus, on the XZ
+// plane. The streamer only decides which cells to load and evict, nearest
+// first, within a radius and a memory budget; the owner does the loading and
+// reports back with Loaded() or Dropped().
+class CellStreamer {
+public:
+    // `origin` is the center of cell (0, 0); cell (x, z) is x + z * countX.
+    CellStreamer(int countX, int countZ, float cellSize, const glm::vec2& origin, float radius, uint64_t budgetBytes)
+        : countX(countX), countZ(countZ), cellSize(cellSize), origin(origin), radius(radius), budget(budgetBytes),
+          states((size_t)countX * countZ, CellState::Absent) {}
+
+    // One step. `evict` gets the resident cells past the radius (with half a
+    // cell of slack, so a focus on a border doesn't thrash) and, while the
+    // budget is short, far cells making room for nearer ones; they are Absent
+    // from here on. `load` gets up to `maxLoads` absent cells inside the
+    // radius, nearest first, that fit the budget; they become Loading. Until a
+    // cell has loaded, the average resident cell stands in for its size.
+    void Plan(const glm::vec3& focus, size_t maxLoads, std::vector<uint32_t>& load, std::vector<uint32_t>& evict) {
+        load.clear();
+        evict.clear();
+        for (size_t i = residents.size(); i-- > 0;) {
+            if (Distance(residents[i].cell, focus) > radius + cellSize * 0.5f) Evict(i, evict);
+        }
+
+        candidates.clear();
+        int x0 = std::max(0, (int)std::floor((focus.x - radius - origin.x) / cellSize));
+        int x1 = std::min(countX - 1, (int)std::ceil((focus.x + radius - origin.x) / cellSize));
+        int z0 = std::max(0, (int)std::floor((focus.z - radius - origin.y) / cellSize));
+        int z1 = std::min(countZ - 1, (int)std::ceil((focus.z + radius - origin.y) / cellSize));
+        for (int z = z0; z <= z1; ++z) {
+            for (int x = x0; x <= x1; ++x) {
+                uint32_t cell = (uint32_t)(x + z * countX);
+                if (states[cell] != CellState::Absent) continue;
+                float d = Distance(cell, focus);
+                if (d <= radius) candidates.push_back({ d, cell });
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.distance < b.distance || (a.distance == b.distance && a.cell < b.cell); });
+
+        uint64_t estimate = residents.empty() ? 0 : residentBytes / residents.size();
+        uint64_t committed = residentBytes + loading * estimate;
+        for (const Candidate& c : candidates) {
+            if (load.size() >= maxLoads) break;
+            while (committed + estimate > budget) {
+                size_t far = residents.size();
+                float farD = c.distance;
+                for (size_t i = 0; i < residents.size(); ++i) {
+                    float d = Distance(residents[i].cell, focus);
+                    if (d > farD) {
+                        farD = d;
+                        far = i;
+                    }
+                }
+                if (far == residents.size()) return;
+                committed -= residents[far].bytes;
+                Evict(far, evict);
+            }
+            states[c.cell] = CellState::Loading;
+            ++loading;
+            committed += estimate;
+            load.push_back(c.cell);
+        }
+    }
+
+    // A Loading cell is now resident and takes `bytes` of the budget.
+    void Loaded(uint32_t cell, uint64_t bytes) {
+        states[cell] = CellState::Resident;
+        --loading;
+        residents.push_back({ cell, bytes });
+        residentBytes += bytes;
+    }
+
+    // A Loading cell was thrown away (the focus moved on while it loaded).
+    void Dropped(uint32_t cell) {
+        states[cell] = CellState::Absent;
+        --loading;
+    }
+
+    // Whether a cell finishing now should still be kept.
+    bool Wanted(uint32_t cell, const glm::vec3& focus) const { return Distance(cell, focus) <= radius + cellSize * 0.5f; }
+
+    // Distance from `focus` to the cell's square (0 inside it).
+    float Distance(uint32_t cell, const glm::vec3& focus) const {
+        glm::vec2 d = glm::abs(glm::vec2(focus.x, focus.z) - Center(cell)) - glm::vec2(cellSize * 0.5f);
+        return glm::length(glm::max(d, glm::vec2(0.0f)));
+    }
+
+    glm::vec2 Center(uint32_t cell) const { return origin + glm::vec2((float)X(cell), (float)Z(cell)) * cellSize; }
+    int X(uint32_t cell) const { return (int)(cell % (uint32_t)countX); }
+    int Z(uint32_t cell) const { return (int)(cell / (uint32_t)countX); }
+    CellState State(uint32_t cell) const { return states[cell]; }
+
+    size_t ResidentCount() const { return residents.size(); }
+    size_t LoadingCount() const { return loading; }
+    uint64_t ResidentBytes() const { return residentBytes; }
+    uint64_t Budget() const { return budget; }
+
+private:
+    struct Resident {
+        uint32_t cell;
+        uint64_t bytes;
+    };
+
+    struct Candidate {
+        float distance;
+        uint32_t cell;
+    };
+
+    void Evict(size_t i, std::vector<uint32_t>& evict) {
+        evict.push_back(residents[i].cell);
+        states[residents[i].cell] = CellState::Absent;
+        residentBytes -= residents[i].bytes;
+        residents[i] = residents.back();
+        residents.pop_back();
+    }
+
+    int countX, countZ;
+    float cellSize;
+    glm::vec2 origin;
+    float radius;
+    uint64_t budget;
+    std::vector<CellState> states;
+    std::vector<Resident> residents;
+    std::vector<Candidate> candidates;
+    uint64_t residentBytes = 0;
+    size_t loading = 0;
+};
@@ -0,0 +1,204 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+// Rolling ground: value-noise fBm, flattened to `groundY` over a pad in every
+// lot tile (the yard with its lamps, and a corridor along z for the road) and
+// blended back to full height over `blend` meters. Tiles past the grid have no
+// pads, so the hills carry on outside it.
+struct TerrainParams {
+    // Center of lot tile (0, 0); tile (x, z) is `tileSize` further per step.
+    glm::vec2 origin{ 0.0f };
+    float tileSize = 240.0f;
+    int tilesX = 1;
+    int tilesZ = 1;
+    float groundY = 0.0f;
+    // Flat rectangle around each tile center, and the corridor (centered
+    // `roadX` off the tile center) running the tile's length.
+    glm::vec2 padHalf{ 40.0f, 36.0f };
+    float roadX = 4.0f;
+    float roadHalfW = 12.0f;
+    float blend = 24.0f;
+    float amplitude = 7.0f;
+    float wavelength = 110.0f;
+    uint32_t seed = 0;
+};
+
+// Height queries are closed-form and O(1) anywhere, so builders can snap to
+// the ground and the terrain can grow without baking anything. The terrain
+// vertex shader has the same functions; keep them in sync.
+class Terrain {
+public:
+    static constexpr int OCTAVES = 4;
+
+    explicit Terrain(const TerrainParams& p = TerrainParams()) : p(p) {}
+
+    const TerrainParams& Params() const { return p; }
+
+    float Height(float x, float z) const {
+        float pad = Flatness(x, z);
+        if (pad >= 1.0f) return p.groundY;
+        return p.groundY + p.amplitude * Fbm(x / p.wavelength, z / p.wavelength) * (1.0f - pad);
+    }
+
+    // Lowest ground under a disc of `radius`: where a trunk or post goes in,
+    // so nothing floats on the downhill side.
+    float MinHeight(float x, float z, float radius) const {
+        float h = Height(x, z);
+        h = std::min(h, Height(x - radius, z));
+        h = std::min(h, Height(x + radius, z));
+        h = std::min(h, Height(x, z - radius));
+        return std::min(h, Height(x, z + radius));
+    }
+
+    glm::vec3 Normal(float x, float z) const {
+        const float e = 0.5f;
+        return glm::normalize(glm::vec3(Height(x - e, z) - Height(x + e, z), 2.0f * e, Height(x, z - e) - Height(x, z + e)));
+    }
+
+    // 1 on a pad, falling smoothly to 0 `blend` meters out.
+    float Flatness(float x, float z) const {
+        glm::vec2 tile = glm::clamp(glm::floor((glm::vec2(x, z) - p.origin) / p.tileSize + 0.5f),
+            glm::vec2(0.0f), glm::vec2((float)(p.tilesX - 1), (float)(p.tilesZ - 1)));
+        glm::vec2 l = glm::vec2(x, z) - (p.origin + tile * p.tileSize);
+        float dPad = glm::length(glm::max(glm::abs(l) - p.padHalf, glm::vec2(0.0f)));
+        glm::vec2 r = glm::abs(l - glm::vec2(p.roadX, 0.0f)) - glm::vec2(p.roadHalfW, p.tileSize * 0.5f);
+        float dRoad = glm::length(glm::max(r, glm::vec2(0.0f)));
+        float t = std::min(std::min(dPad, dRoad) / p.blend, 1.0f);
+        return 1.0f - t * t * (3.0f - 2.0f * t);
+    }
+
+    // The most the surface leaves groundY by, either way.
+    float MaxOffset() const { return p.amplitude; }
+
+private:
+    static uint32_t Hash(int x, int z, uint32_t seed) {
+        uint32_t h = ((uint32_t)x * 0x8da6b343u) ^ ((uint32_t)z * 0xd8163841u) ^ seed;
+        h = (h ^ (h >> 16)) * 0x7feb352du;
+        h = (h ^ (h >> 15)) * 0x846ca68bu;
+        return h ^ (h >> 16);
+    }
+
+    // Lattice values in [-1, 1], smoothstep-interpolated.
+    static float Noise(float x, float z, uint32_t seed) {
+        float fx = std::floor(x), fz = std::floor(z);
+        int ix = (int)fx, iz = (int)fz;
+        float tx = x - fx, tz = z - fz;
+        tx = tx * tx * (3.0f - 2.0f * tx);
+        tz = tz * tz * (3.0f - 2.0f * tz);
+        auto v = [seed](int i, int k) { return (float)(Hash(i, k, seed) >> 8) * (2.0f / 16777215.0f) - 1.0f; };
+        float a = v(ix, iz) + (v(ix + 1, iz) - v(ix, iz)) * tx;
+        float b = v(ix, iz + 1) + (v(ix + 1, iz + 1) - v(ix, iz + 1)) * tx;
+        return a + (b - a) * tz;
+    }
+
+    float Fbm(float x, float z) const {
+        float sum = 0.0f, weight = 1.0f, total = 0.0f;
+        for (int o = 0; o < OCTAVES; ++o) {
+            sum += weight * Noise(x, z, p.seed + (uint32_t)o * 0x9e3779b9u);
+            total += weight;
+            x *= 2.0f;
+            z *= 2.0f;
+            weight *= 0.5f;
+        }
+        return sum / total;
+    }
+
+    TerrainParams p;
+};
+
+// A terrain patch to draw: one instance of the grid patch mesh, laid over the
+// square at `min` of side `size`. Matches the per-instance vertex attribute.
+struct TerrainNode {
+    glm::vec2 min;
+    float size;
+    float level;
+};
+
+// Continuous distance-dependent LOD (CDLOD) over a square: a quadtree whose
+// leaves are `leafSize` wide, level 0 the finest. A node of level L is drawn
+// within `lodRange * 2^L` of the eye; past `MORPH_START` of the way from the
+// previous level's range, its odd grid vertices slide onto their even
+// neighbours, so by the range it matches the coarser level and the switch
+// does not pop. Selection visits O(levels) nodes whatever the extent.
+class CdlodTree {
+public:
+    static constexpr int MAX_LEVELS = 16;
+    static constexpr float MORPH_START = 0.75f;
+
+    // lodRange / leafSize of 4 or more keeps a node's children within one
+    // level of their neighbours, which the morph needs to close every seam.
+    CdlodTree(const glm::vec2& center, float extent, float leafSize, float lodRange, float minY, float maxY)
+        : minY(minY), maxY(maxY) {
+        rootSize = leafSize;
+        levels = 1;
+        while (rootSize < extent && levels < MAX_LEVELS) {
+            rootSize *= 2.0f;
+            ++levels;
+        }
+        rootMin = center - glm::vec2(rootSize * 0.5f);
+        for (int l = 0; l < levels; ++l) ranges[l] = lodRange * std::ldexp(1.0f, l);
+        // Nothing coarser to hand over to: the root level never fades out.
+        ranges[levels - 1] = 1e30f;
+    }
+
+    // Fills `out` with the patches to draw from `eye` inside `frustum`, coarse
+    // to fine; stops at `capacity` (see MaxNodes).
+    size_t Select(const glm::vec3& eye, const Frustum& frustum, TerrainNode* out, size_t capacity) const {
+        size_t count = 0;
+        SelectNode(rootMin, rootSize, levels - 1, eye, frustum, out, capacity, count);
+        return count;
+    }
+
+    // Per level: a node meets its range sphere over at most a (2 * 4 + 2)^2
+    // block of its siblings' squares.
+    size_t MaxNodes() const { return (size_t)levels * 100; }
+
+    int Levels() const { return levels; }
+    float RootSize() const { return rootSize; }
+
+    // Distances over which level `l` morphs toward level l + 1.
+    glm::vec2 MorphRange(int l) const {
+        float prev = l > 0 ? ranges[l - 1] : 0.0f;
+        return glm::vec2(prev + (ranges[l] - prev) * MORPH_START, ranges[l]);
+    }
+
+private:
+    float Distance(const glm::vec2& mn, float size, const glm::vec3& eye) const {
+        glm::vec3 bmin(mn.x, minY, mn.y), bmax(mn.x + size, maxY, mn.y + size);
+        return glm::length(glm::max(glm::max(bmin - eye, eye - bmax), glm::vec3(0.0f)));
+    }
+
+    // False when the node is past its level's range: the parent draws there.
+    bool SelectNode(const glm::vec2& mn, float size, int level, const glm::vec3& eye, const Frustum& frustum,
+        TerrainNode* out, size_t capacity, size_t& count) const {
+        float d = Distance(mn, size, eye);
+        if (d > ranges[level]) return false;
+        if (!frustum.IntersectsAabb(glm::vec3(mn.x, minY, mn.y), glm::vec3(mn.x + size, maxY, mn.y + size))) return true;
+
+        if (level == 0 || d > ranges[level - 1]) {
+            if (count < capacity) out[count++] = { mn, size, (float)level };
+            return true;
+        }
+        float half = size * 0.5f;
+        for (int c = 0; c < 4; ++c) {
+            glm::vec2 cmn = mn + glm::vec2((float)(c & 1), (float)(c >> 1)) * half;
+            // A child out of its own range is still drawn at the child's size,
+            // fully morphed, which is the parent's grid over that quarter.
+            if (!SelectNode(cmn, half, level - 1, eye, frustum, out, capacity, count) && count < capacity) {
+                out[count++] = { cmn, half, (float)(level - 1) };
+            }
+        }
+        return true;
+    }
+
+    glm::vec2 rootMin{ 0.0f };
+    float rootSize = 0.0f;
+    int levels = 1;
+    float ranges[MAX_LEVELS] = {};
+    float minY, maxY;
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Parent/child transforms for parts built as one group (the car and its
+// wheels, the mailbox, the drying rack): node i sits at World(parent) *
+// Local(i). Nodes are stored in preorder, so a node's subtree is the range
+// [i, SubtreeEnd(i)) and every parent comes before its children. SetLocal only
+// marks a node dirty; Update recomputes the dirty subtrees front to back and
+// leaves everything else alone.
+class TransformHierarchy {
+public:
+    static constexpr uint32_t NONE = ~0u;
+
+    // Nodes [begin, end): one whole subtree.
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // A node under `parent` (NONE: a root), its world matrix computed now.
+    // `parent` must be the newest node or one of its ancestors, which is what
+    // nested builder scopes give; any other parent would break the preorder,
+    // so the node becomes a root instead, keeping its world placement.
+    uint32_t Add(uint32_t parent, const glm::mat4& local) {
+        uint32_t id = (uint32_t)locals.size();
+        glm::mat4 world = parent == NONE ? local : worlds[parent] * local;
+        if (parent != NONE && ends[parent] != id) parent = NONE;
+        parents.push_back(parent);
+        locals.push_back(parent == NONE ? world : local);
+        worlds.push_back(world);
+        ends.push_back(id + 1);
+        dirty.push_back(0);
+        for (uint32_t p = parent; p != NONE; p = parents[p]) ends[p] = id + 1;
+        return id;
+    }
+
+    void SetLocal(uint32_t i, const glm::mat4& local) {
+        locals[i] = local;
+        if (dirty[i]) return;
+        dirty[i] = 1;
+        pending.push_back(i);
+    }
+
+    // Recomputes the world matrix of every dirty node and of everything under
+    // it, each node at most once; false when nothing was dirty. The subtrees
+    // it went over are Updated() until the next call, in node order.
+    bool Update() {
+        updated.clear();
+        if (pending.empty()) return false;
+        std::sort(pending.begin(), pending.end());
+        uint32_t done = 0;
+        for (uint32_t i : pending) {
+            if (i < done) continue;
+            for (uint32_t j = i; j < ends[i]; ++j) {
+                worlds[j] = parents[j] == NONE ? locals[j] : worlds[parents[j]] * locals[j];
+                dirty[j] = 0;
+            }
+            updated.push_back({ i, ends[i] });
+            done = ends[i];
+        }
+        pending.clear();
+        return true;
+    }
+
+    // Moves every tree by `offset`: root locals and all world matrices. The
+    // dirty marks stay as they are.
+    void Translate(const glm::vec3& offset) {
+        glm::vec4 shift(offset, 0.0f);
+        for (size_t i = 0; i < locals.size(); ++i) {
+            if (parents[i] == NONE) locals[i][3] += shift;
+            worlds[i][3] += shift;
+        }
+    }
+
+    // Appends the nodes of `other` as new trees; returns what their ids were
+    // shifted by.
+    uint32_t Append(const TransformHierarchy& other) {
+        uint32_t offset = (uint32_t)locals.size();
+        for (size_t i = 0; i < other.locals.size(); ++i) {
+            parents.push_back(other.parents[i] == NONE ? NONE : other.parents[i] + offset);
+            ends.push_back(other.ends[i] + offset);
+        }
+        locals.insert(locals.end(), other.locals.begin(), other.locals.end());
+        worlds.insert(worlds.end(), other.worlds.begin(), other.worlds.end());
+        dirty.insert(dirty.end(), other.dirty.begin(), other.dirty.end());
+        for (uint32_t i : other.pending) pending.push_back(i + offset);
+        return offset;
+    }
+
+    size_t Count() const { return locals.size(); }
+    uint32_t ParentOf(uint32_t i) const { return parents[i]; }
+    uint32_t SubtreeEnd(uint32_t i) const { return ends[i]; }
+    const glm::mat4& Local(uint32_t i) const { return locals[i]; }
+    const glm::mat4& World(uint32_t i) const { return worlds[i]; }
+    const std::vector<Range>& Updated() const { return updated; }
+
+    size_t MemoryBytes() const {
+        return (locals.capacity() + worlds.capacity()) * sizeof(glm::mat4) +
+            (parents.capacity() + ends.capacity() + pending.capacity()) * sizeof(uint32_t) +
+            updated.capacity() * sizeof(Range) + dirty.capacity();
+    }
+
+private:
+    std::vector<uint32_t> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    // One past the last node of each subtree.
+    std::vector<uint32_t> ends;
+    std::vector<uint8_t> dirty;
+    // Nodes set dirty since the last Update, in the order they were.
+    std::vector<uint32_t> pending;
+    // Subtrees the last Update recomputed.
+    std::vector<Range> updated;
+};
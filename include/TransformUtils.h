@@ -1,24 +1,245 @@
 #pragma once
+#include <cmath>
+#include <cstddef>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-inline glm::mat4 MakeModel_CenterPivot(const glm::vec3& pos, const glm::vec3& eulerRad, const glm::vec3& scale) {
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TRANSFORM_SIMD_AVX2 1
+#endif
+
+// translate(pos) * Rz * Ry * Rx * scale written out directly, which is what the
+// glm::translate / glm::rotate / glm::scale chain used to compute.
+inline glm::mat4 MakeModel_TRS(const glm::vec3& pos, const glm::vec3& eulerRad, const glm::vec3& scale) {
     glm::mat4 M(1.0f);
-    M = glm::translate(M, pos);
-    M = glm::rotate(M, eulerRad.z, glm::vec3(0.0f, 0.0f, 1.0f));
-    M = glm::rotate(M, eulerRad.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    M = glm::rotate(M, eulerRad.x, glm::vec3(1.0f, 0.0f, 0.0f));
-    M = glm::scale(M, scale);
+    if (eulerRad.x == 0.0f && eulerRad.y == 0.0f && eulerRad.z == 0.0f) {
+        M[0][0] = scale.x;
+        M[1][1] = scale.y;
+        M[2][2] = scale.z;
+    }
+    else {
+        float cx = std::cos(eulerRad.x), sx = std::sin(eulerRad.x);
+        float cy = std::cos(eulerRad.y), sy = std::sin(eulerRad.y);
+        float cz = std::cos(eulerRad.z), sz = std::sin(eulerRad.z);
+        float czsy = cz * sy, szsy = sz * sy;
+
+        M[0] = glm::vec4(cz * cy, sz * cy, -sy, 0.0f) * scale.x;
+        M[1] = glm::vec4(czsy * sx - sz * cx, szsy * sx + cz * cx, cy * sx, 0.0f) * scale.y;
+        M[2] = glm::vec4(czsy * cx + sz * sx, szsy * cx - cz * sx, cy * cx, 0.0f) * scale.z;
+    }
+    M[3] = glm::vec4(pos, 1.0f);
     return M;
 }
 
+inline glm::mat4 MakeModel_CenterPivot(const glm::vec3& pos, const glm::vec3& eulerRad, const glm::vec3& scale) {
+    return MakeModel_TRS(pos, eulerRad, scale);
+}
+
 inline glm::mat4 MakeModel_BottomPivot(const glm::vec3& pos, const glm::vec3& eulerRad, const glm::vec3& scale) {
-    glm::mat4 M(1.0f);
-    M = glm::translate(M, pos);
-    M = glm::translate(M, glm::vec3(0.0f, scale.y * 0.5f, 0.0f));
-    M = glm::rotate(M, eulerRad.z, glm::vec3(0.0f, 0.0f, 1.0f));
-    M = glm::rotate(M, eulerRad.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    M = glm::rotate(M, eulerRad.x, glm::vec3(1.0f, 0.0f, 0.0f));
-    M = glm::scale(M, scale);
-    return M;
+    return MakeModel_TRS(pos + glm::vec3(0.0f, scale.y * 0.5f, 0.0f), eulerRad, scale);
+}
+
+enum class TransformPivot { Center, Bottom };
+
+// Structure-of-arrays input for the batch builders; every array holds `count` floats.
+struct TransformSoA {
+    const float* posX;
+    const float* posY;
+    const float* posZ;
+    const float* rotX;
+    const float* rotY;
+    const float* rotZ;
+    const float* sclX;
+    const float* sclY;
+    const float* sclZ;
+    size_t count;
+};
+
+namespace TransformSimd {
+
+#if defined(TRANSFORM_SIMD_AVX2)
+struct Lanes {
+    static constexpr int N = 8;
+    using V = __m256;
+
+    static V Load(const float* p) { return _mm256_loadu_ps(p); }
+    static V Set(float v) { return _mm256_set1_ps(v); }
+    static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V Round(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V Floor(V a) { return _mm256_floor_ps(a); }
+    static V Eq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static V Ge(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static V Select(V mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); }
+    static bool AllZero(V a) {
+        return _mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_NEQ_UQ)) == 0;
+    }
+
+    // e[k] holds element k of N column-major matrices; writes them out as N mat4s.
+    static void Store(const V (&e)[16], float* out) {
+        for (int half = 0; half < 2; ++half) {
+            const V* r = e + half * 8;
+            V t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+            V t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+            V t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+            V t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+            V u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            V u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            V u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            V u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+            V u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+            V u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+            V u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+            V u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+            float* o = out + half * 8;
+            _mm256_storeu_ps(o + 0 * 16, _mm256_permute2f128_ps(u0, u4, 0x20));
+            _mm256_storeu_ps(o + 1 * 16, _mm256_permute2f128_ps(u1, u5, 0x20));
+            _mm256_storeu_ps(o + 2 * 16, _mm256_permute2f128_ps(u2, u6, 0x20));
+            _mm256_storeu_ps(o + 3 * 16, _mm256_permute2f128_ps(u3, u7, 0x20));
+            _mm256_storeu_ps(o + 4 * 16, _mm256_permute2f128_ps(u0, u4, 0x31));
+            _mm256_storeu_ps(o + 5 * 16, _mm256_permute2f128_ps(u1, u5, 0x31));
+            _mm256_storeu_ps(o + 6 * 16, _mm256_permute2f128_ps(u2, u6, 0x31));
+            _mm256_storeu_ps(o + 7 * 16, _mm256_permute2f128_ps(u3, u7, 0x31));
+        }
+    }
+};
+#endif
+
+#if defined(TRANSFORM_SIMD_AVX2)
+// Cephes-style sinf/cosf: reduce by pi/2 in three parts, evaluate both
+// polynomials on [-pi/4, pi/4] and swap/negate by quadrant.
+inline void SinCos(Lanes::V x, Lanes::V& s, Lanes::V& c) {
+    using L = Lanes;
+    L::V q = L::Round(L::Mul(x, L::Set(0.636619772f)));
+    L::V r = L::Sub(x, L::Mul(q, L::Set(1.5703125f)));
+    r = L::Sub(r, L::Mul(q, L::Set(4.837512969970703125e-4f)));
+    r = L::Sub(r, L::Mul(q, L::Set(7.54978995489188216e-8f)));
+    L::V r2 = L::Mul(r, r);
+
+    L::V ps = L::Add(L::Mul(L::Set(-1.9515295891e-4f), r2), L::Set(8.3321608736e-3f));
+    ps = L::Add(L::Mul(ps, r2), L::Set(-1.6666654611e-1f));
+    ps = L::Add(L::Mul(L::Mul(ps, r2), r), r);
+
+    L::V pc = L::Add(L::Mul(L::Set(2.443315711809948e-5f), r2), L::Set(-1.388731625493765e-3f));
+    pc = L::Add(L::Mul(pc, r2), L::Set(4.166664568298827e-2f));
+    pc = L::Add(L::Sub(L::Mul(L::Mul(pc, r2), r2), L::Mul(r2, L::Set(0.5f))), L::Set(1.0f));
+
+    L::V quad = L::Sub(q, L::Mul(L::Floor(L::Mul(q, L::Set(0.25f))), L::Set(4.0f)));
+    L::V odd = L::Eq(L::Sub(quad, L::Mul(L::Floor(L::Mul(quad, L::Set(0.5f))), L::Set(2.0f))), L::Set(1.0f));
+    L::V sinR = L::Select(odd, pc, ps);
+    L::V cosR = L::Select(odd, ps, pc);
+
+    // cos(x) = sin(x + pi/2): its sign follows the next quadrant.
+    L::V zero = L::Set(0.0f);
+    L::V quadC = L::Select(L::Eq(quad, L::Set(3.0f)), zero, L::Add(quad, L::Set(1.0f)));
+    L::V sinNeg = L::Ge(quad, L::Set(2.0f));
+    L::V cosNeg = L::Ge(quadC, L::Set(2.0f));
+    s = L::Select(sinNeg, L::Sub(zero, sinR), sinR);
+    c = L::Select(cosNeg, L::Sub(zero, cosR), cosR);
 }
+
+// Builds Lanes::N matrices starting at element `i` of `in`.
+inline void MakeModelsBlock(const TransformSoA& in, size_t i, bool bottomPivot, float* out) {
+    using L = Lanes;
+    L::V rx = L::Load(in.rotX + i), ry = L::Load(in.rotY + i), rz = L::Load(in.rotZ + i);
+    L::V scx = L::Load(in.sclX + i), scy = L::Load(in.sclY + i), scz = L::Load(in.sclZ + i);
+    L::V zero = L::Set(0.0f), one = L::Set(1.0f);
+
+    L::V e[16];
+    if (L::AllZero(rx) && L::AllZero(ry) && L::AllZero(rz)) {
+        e[0] = scx; e[1] = zero; e[2] = zero;
+        e[4] = zero; e[5] = scy; e[6] = zero;
+        e[8] = zero; e[9] = zero; e[10] = scz;
+    }
+    else {
+        L::V sx, cx, sy, cy, sz, cz;
+        SinCos(rx, sx, cx);
+        SinCos(ry, sy, cy);
+        SinCos(rz, sz, cz);
+        L::V czsy = L::Mul(cz, sy), szsy = L::Mul(sz, sy);
+
+        e[0] = L::Mul(L::Mul(cz, cy), scx);
+        e[1] = L::Mul(L::Mul(sz, cy), scx);
+        e[2] = L::Mul(L::Sub(zero, sy), scx);
+        e[4] = L::Mul(L::Sub(L::Mul(czsy, sx), L::Mul(sz, cx)), scy);
+        e[5] = L::Mul(L::Add(L::Mul(szsy, sx), L::Mul(cz, cx)), scy);
+        e[6] = L::Mul(L::Mul(cy, sx), scy);
+        e[8] = L::Mul(L::Add(L::Mul(czsy, cx), L::Mul(sz, sx)), scz);
+        e[9] = L::Mul(L::Sub(L::Mul(szsy, cx), L::Mul(cz, sx)), scz);
+        e[10] = L::Mul(L::Mul(cy, cx), scz);
+    }
+    e[3] = zero; e[7] = zero; e[11] = zero;
+
+    e[12] = L::Load(in.posX + i);
+    e[13] = L::Load(in.posY + i);
+    if (bottomPivot) e[13] = L::Add(e[13], L::Mul(scy, L::Set(0.5f)));
+    e[14] = L::Load(in.posZ + i);
+    e[15] = one;
+
+    L::Store(e, out);
+}
+#endif
+
+} // namespace TransformSimd
+
+// Batch form of MakeModel_CenterPivot / MakeModel_BottomPivot: fills out[0..count).
+// Uses AVX2 when the build enables it; results match the scalar builders to
+// within float rounding (the --check-transforms run measures it).
+inline void MakeModels(const TransformSoA& in, TransformPivot pivot, glm::mat4* out) {
+    bool bottom = (pivot == TransformPivot::Bottom);
+    size_t i = 0;
+#if defined(TRANSFORM_SIMD_AVX2)
+    constexpr size_t N = (size_t)TransformSimd::Lanes::N;
+    for (; i + N <= in.count; i += N) {
+        TransformSimd::MakeModelsBlock(in, i, bottom, &out[i][0][0]);
+    }
+#endif
+    for (; i < in.count; ++i) {
+        glm::vec3 pos(in.posX[i], in.posY[i], in.posZ[i]);
+        glm::vec3 rot(in.rotX[i], in.rotY[i], in.rotZ[i]);
+        glm::vec3 scl(in.sclX[i], in.sclY[i], in.sclZ[i]);
+        out[i] = bottom ? MakeModel_BottomPivot(pos, rot, scl) : MakeModel_CenterPivot(pos, rot, scl);
+    }
+}
+
+inline void MakeModels_CenterPivot(const TransformSoA& in, glm::mat4* out) {
+    MakeModels(in, TransformPivot::Center, out);
+}
+
+inline void MakeModels_BottomPivot(const TransformSoA& in, glm::mat4* out) {
+    MakeModels(in, TransformPivot::Bottom, out);
+}
+
+// Which path MakeModels takes in this build.
+inline const char* TransformSimdName() {
+#if defined(TRANSFORM_SIMD_AVX2)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+// Owns the arrays of a TransformSoA, filled one transform at a time.
+struct TransformBatch {
+    std::vector<float> posX, posY, posZ, rotX, rotY, rotZ, sclX, sclY, sclZ;
+
+    void Reserve(size_t n) {
+        for (std::vector<float>* v : { &posX, &posY, &posZ, &rotX, &rotY, &rotZ, &sclX, &sclY, &sclZ }) v->reserve(n);
+    }
+
+    void Add(const glm::vec3& pos, const glm::vec3& eulerRad, const glm::vec3& scale) {
+        posX.push_back(pos.x); posY.push_back(pos.y); posZ.push_back(pos.z);
+        rotX.push_back(eulerRad.x); rotY.push_back(eulerRad.y); rotZ.push_back(eulerRad.z);
+        sclX.push_back(scale.x); sclY.push_back(scale.y); sclZ.push_back(scale.z);
+    }
+
+    size_t Size() const { return posX.size(); }
+
+    TransformSoA View() const {
+        return { posX.data(), posY.data(), posZ.data(), rotX.data(), rotY.data(), rotZ.data(),
+            sclX.data(), sclY.data(), sclZ.data(), posX.size() };
+    }
+};
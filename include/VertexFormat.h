@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+// Compact vertex and instance encodings; the shaders get them back through
+// normalized vertex attributes.
+
+// Mesh vertex in 12 bytes instead of 24. Meshes live in the unit cube, so the
+// position is a 16-bit signed normalized value of 2 * pos (the shader scales by
+// 0.5); w is padding. The normal is GL_INT_2_10_10_10_REV, signed normalized.
+struct PackedVertex {
+    int16_t pos[4];
+    uint32_t normal;
+};
+static_assert(sizeof(PackedVertex) == 12, "PackedVertex must stay 12 bytes");
+
+enum class VertexFormat { Float, Packed };
+
+inline int16_t PackSnorm16(float v) {
+    return (int16_t)std::lround(std::max(-1.0f, std::min(1.0f, v)) * 32767.0f);
+}
+
+inline uint32_t PackSnorm10x3(const glm::vec3& n) {
+    auto Pack = [](float v) {
+        return (uint32_t)((int32_t)std::lround(std::max(-1.0f, std::min(1.0f, v)) * 511.0f) & 0x3FF);
+    };
+    return Pack(n.x) | (Pack(n.y) << 10) | (Pack(n.z) << 20);
+}
+
+// RGBA8 in memory order r, g, b, a, for GL_UNSIGNED_BYTE normalized attributes.
+inline uint32_t PackUnorm8x4(const glm::vec4& c) {
+    auto Pack = [](float v) {
+        return (uint32_t)std::lround(std::max(0.0f, std::min(1.0f, v)) * 255.0f);
+    };
+    return Pack(c.x) | (Pack(c.y) << 8) | (Pack(c.z) << 16) | (Pack(c.w) << 24);
+}
+
+inline PackedVertex PackVertex(const glm::vec3& pos, const glm::vec3& normal) {
+    PackedVertex v;
+    v.pos[0] = PackSnorm16(pos.x * 2.0f);
+    v.pos[1] = PackSnorm16(pos.y * 2.0f);
+    v.pos[2] = PackSnorm16(pos.z * 2.0f);
+    v.pos[3] = 0;
+    v.normal = PackSnorm10x3(normal);
+    return v;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <glm/glm.hpp>
+#include <cstdint>
 
 namespace WC {
 
@@ -11,15 +12,31 @@ namespace WC {
 	inline constexpr float CAM_SPEED = 1.6f;
 
 	inline constexpr float ZOOM_SPEED = 2.2f;
+	inline constexpr float PAN_SPEED = 40.0f;
 	inline constexpr float R_MIN = 25.0f;
 	inline constexpr float R_MAX = 160.0f;
 
+	inline constexpr uint64_t SCENE_SEED = 20251221u;
+
 	inline constexpr float GROUND_Y = 0.0f;
 	inline constexpr float GROUND_SIZE = 240.0f;
-	inline constexpr float GROUND_THK = 0.12f;
 
 	inline constexpr float OVERLAY_Y = GROUND_Y + 0.001f;
 
+	// Hills around the lots; the flat pad covers every lot style's yard and
+	// lamps, the corridor its road and lamp rows (see TerrainParams).
+	inline constexpr float TERRAIN_AMPLITUDE = 7.0f;
+	inline constexpr float TERRAIN_WAVELENGTH = 110.0f;
+	inline constexpr float TERRAIN_PAD_HALF_W = 40.0f;
+	inline constexpr float TERRAIN_PAD_HALF_L = 36.0f;
+	inline constexpr float TERRAIN_ROAD_X = 4.0f;
+	inline constexpr float TERRAIN_ROAD_HALF_W = 12.0f;
+	inline constexpr float TERRAIN_BLEND = 24.0f;
+	// CDLOD: grid cells per patch side, finest patch size, finest LOD range.
+	inline constexpr int TERRAIN_GRID = 16;
+	inline constexpr float TERRAIN_LEAF_SIZE = 32.0f;
+	inline constexpr float TERRAIN_LOD_RANGE = 128.0f;
+
 	inline const glm::vec3 SHIN_CENTER = glm::vec3(0.0f, 0.0f, 0.0f);
 
 	inline constexpr float YARD_W = 42.0f;
@@ -32,7 +49,20 @@ namespace WC {
 	inline constexpr float FENCE_H = 2.15f;
 	inline constexpr float FENCE_MARGIN = 1.10f;
 
+	// Wind: the direction it blows (xz) and the most it moves any vertex,
+	// which pads the bounds of what sways. Stiffness is the height in meters
+	// at which a plant bends fully.
+	inline const glm::vec2 WIND_DIR = glm::vec2(0.8f, 0.6f);
+	inline constexpr float WIND_MAX_SWAY = 0.6f;
+	inline constexpr float WIND_STIFFNESS_PINE = 14.0f;
+	inline constexpr float WIND_STIFFNESS_HEDGE = 3.0f;
+	inline constexpr float WIND_STIFFNESS_FLOWER = 1.2f;
+
 	inline const glm::vec3 COL_GRASS = glm::vec3(0.18f, 0.50f, 0.20f);
+	inline const glm::vec3 COL_GRASS_TIP = glm::vec3(0.42f, 0.66f, 0.24f);
 	inline const glm::vec3 COL_YARD = glm::vec3(0.82f, 0.79f, 0.68f);
+	inline const glm::vec3 COL_FLOWER_STEM = glm::vec3(0.10f, 0.55f, 0.12f);
+	inline const glm::vec3 COL_FLOWER_RED = glm::vec3(0.95f, 0.20f, 0.18f);
+	inline const glm::vec3 COL_FLOWER_YELLOW = glm::vec3(0.98f, 0.92f, 0.22f);
 
 } // namespace WC
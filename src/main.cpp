@@ -8,12 +8,85 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
-#include <ctime>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #include <algorithm>
+#include <new>
+#include <unordered_map>
+#include <filesystem>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <string>
 
 #include "WorldConfig.h"
 #include "TransformUtils.h"
+#include "FrameStats.h"
+#include "Random.h"
+#include "Scatter.h"
+#include "ThreadPool.h"
+#include "SceneWorld.h"
+#include "Frustum.h"
+#include "Arena.h"
+#include "AllocStats.h"
+#include "Prefab.h"
+#include "MeshLibrary.h"
+#include "RoofMesh.h"
+#include "VertexFormat.h"
+#include "MeshSimplify.h"
+#include "LodGroup.h"
+#include "Impostor.h"
+#include "Streaming.h"
+#include "Terrain.h"
+#include "Grass.h"
+
+#if ALLOC_TRACKING
+// Replacement global allocation functions: every heap allocation goes through
+// here so AllocStats can count it. Array and nothrow forms forward to these,
+// aligned ones included.
+void* operator new(std::size_t size) {
+    AllocCounters& c = GetAllocCounters();
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    GetAllocCounters().frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    AllocCounters& c = GetAllocCounters();
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+    std::size_t a = (std::size_t)align;
+#if defined(_WIN32)
+    if (void* p = _aligned_malloc(size ? size : 1, a)) return p;
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    if (void* p = std::aligned_alloc(a, ((size ? size : 1) + a - 1) / a * a)) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    if (!p) return;
+    GetAllocCounters().frees.fetch_add(1, std::memory_order_relaxed);
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t align) noexcept { operator delete(p, align); }
+#endif
 
 float yaw = 0.0f;
 float pitch = glm::radians(WC::CAM_PITCH_DEG);
@@ -23,6 +96,157 @@ float angularSpeed = WC::CAM_SPEED;
 float zoomSpeed = WC::ZOOM_SPEED;
 float radiusMin = WC::R_MIN;
 float radiusMax = WC::R_MAX;
+// What the camera orbits; the arrow keys move it over the ground.
+glm::vec3 focus = WC::SHIN_CENTER;
+float panSpeed = WC::PAN_SPEED;
+
+enum class DebugView { None = 0, Overdraw, ShadowTexel, TriDensity };
+DebugView debugView = DebugView::None;
+
+const char* DebugViewName(DebugView v) {
+    switch (v) {
+    case DebugView::Overdraw: return "overdraw";
+    case DebugView::ShadowTexel: return "shadow";
+    case DebugView::TriDensity: return "tris";
+    default: return "none";
+    }
+}
+
+bool ParseDebugView(const char* name, DebugView& out) {
+    for (int i = 0; i <= (int)DebugView::TriDensity; ++i) {
+        if (std::strcmp(name, DebugViewName((DebugView)i)) == 0) {
+            out = (DebugView)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct AppOptions {
+    DebugView debugView = DebugView::None;
+    const char* capturePath = nullptr;
+    int captureFrames = 4;
+    int statsEvery = 0;
+    int benchFrames = 0;
+    int benchWarmup = 60;
+    const char* benchOut = "bench_stats.json";
+    uint64_t seed = WC::SCENE_SEED;
+    unsigned buildThreads = 0;
+    VertexFormat vertexFormat = VertexFormat::Packed;
+    // Screen-space error, in pixels, a LOD group's proxy may show.
+    float lodPixelError = 1.0f;
+    // Lots farther than this (meters) draw as impostors; 0 turns them off.
+    float impostorDistance = 140.0f;
+    const char* impostorCache = "impostor_cache";
+    // Lot grid for scaling runs; 0 keeps the single hand-tuned lot.
+    int lotsX = 0;
+    int lotsZ = 0;
+    // Streams the lot grid around the focus instead of building it up front:
+    // lots within this radius (meters) are kept resident; 0 builds them all.
+    float streamRadius = 0.0f;
+    // Memory the resident lots may take, and the data one frame may merge.
+    uint64_t streamBudgetBytes = 256ull << 20;
+    uint64_t streamUploadBytes = 512ull << 10;
+    // Grass blades per 16 m chunk at full density; 0 turns the field off.
+    int grassBlades = 8192;
+    // Scattered pines and flowers from the GPU at this many times the
+    // builders' density; 0 leaves them to the builders.
+    float gpuScatter = 0.0f;
+    // How far (meters) the wind bends pines, hedges and flowers at their
+    // tops; 0 holds them still.
+    float wind = 0.35f;
+};
+
+bool ParseArgs(int argc, char** argv, AppOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        bool hasNext = (i + 1 < argc);
+        if (std::strcmp(a, "--debug-view") == 0 && hasNext) {
+            if (!ParseDebugView(argv[++i], opt.debugView)) {
+                std::cerr << "Unknown debug view: " << argv[i] << " (none|overdraw|shadow|tris)\n";
+                return false;
+            }
+        }
+        else if (std::strcmp(a, "--capture") == 0 && hasNext) {
+            opt.capturePath = argv[++i];
+        }
+        else if (std::strcmp(a, "--capture-frames") == 0 && hasNext) {
+            opt.captureFrames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(a, "--seed") == 0 && hasNext) {
+            opt.seed = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if (std::strcmp(a, "--build-threads") == 0 && hasNext) {
+            opt.buildThreads = (unsigned)std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(a, "--vertex-format") == 0 && hasNext) {
+            const char* f = argv[++i];
+            if (std::strcmp(f, "float") == 0) opt.vertexFormat = VertexFormat::Float;
+            else if (std::strcmp(f, "packed") == 0) opt.vertexFormat = VertexFormat::Packed;
+            else {
+                std::cerr << "Unknown vertex format: " << f << " (float|packed)\n";
+                return false;
+            }
+        }
+        else if (std::strcmp(a, "--lod-error") == 0 && hasNext) {
+            opt.lodPixelError = std::max(0.0f, (float)std::atof(argv[++i]));
+        }
+        else if (std::strcmp(a, "--impostor-distance") == 0 && hasNext) {
+            opt.impostorDistance = std::max(0.0f, (float)std::atof(argv[++i]));
+        }
+        else if (std::strcmp(a, "--impostor-cache") == 0 && hasNext) {
+            opt.impostorCache = argv[++i];
+        }
+        else if (std::strcmp(a, "--lots") == 0 && hasNext) {
+            const char* g = argv[++i];
+            int n = std::sscanf(g, "%dx%d", &opt.lotsX, &opt.lotsZ);
+            if (n == 1) opt.lotsZ = opt.lotsX;
+            if (n < 1 || opt.lotsX < 1 || opt.lotsZ < 1) {
+                std::cerr << "Bad lot grid: " << g << " (NxM)\n";
+                return false;
+            }
+        }
+        else if (std::strcmp(a, "--stream-radius") == 0 && hasNext) {
+            opt.streamRadius = std::max(0.0f, (float)std::atof(argv[++i]));
+        }
+        else if (std::strcmp(a, "--stream-budget") == 0 && hasNext) {
+            opt.streamBudgetBytes = (uint64_t)std::max(1, std::atoi(argv[++i])) << 20;
+        }
+        else if (std::strcmp(a, "--stream-upload") == 0 && hasNext) {
+            opt.streamUploadBytes = (uint64_t)std::max(1, std::atoi(argv[++i])) << 10;
+        }
+        else if (std::strcmp(a, "--grass") == 0 && hasNext) {
+            opt.grassBlades = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(a, "--gpu-scatter") == 0 && hasNext) {
+            opt.gpuScatter = std::max(0.0f, (float)std::atof(argv[++i]));
+        }
+        else if (std::strcmp(a, "--wind") == 0 && hasNext) {
+            opt.wind = std::min(std::max(0.0f, (float)std::atof(argv[++i])), WC::WIND_MAX_SWAY);
+        }
+        else if (std::strcmp(a, "--stats-every") == 0 && hasNext) {
+            opt.statsEvery = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(a, "--bench") == 0 && hasNext) {
+            opt.benchFrames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(a, "--bench-warmup") == 0 && hasNext) {
+            opt.benchWarmup = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(a, "--bench-out") == 0 && hasNext) {
+            opt.benchOut = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown option: " << a << "\n";
+            return false;
+        }
+    }
+    if (opt.streamRadius > 0.0f && opt.lotsX == 0) {
+        std::cerr << "--stream-radius needs a lot grid (--lots NxM)\n";
+        return false;
+    }
+    return true;
+}
 
 static void glfw_error_callback(int code, const char* desc) {
     std::cerr << "[GLFW ERROR] " << code << " : " << (desc ? desc : "") << "\n";
@@ -38,6 +262,36 @@ void scroll_callback(GLFWwindow*, double, double yoffset) {
     if (radius > radiusMax) radius = radiusMax;
 }
 
+void key_callback(GLFWwindow*, int key, int, int action, int) {
+    if (action != GLFW_PRESS) return;
+
+    DebugView next = debugView;
+    if (key == GLFW_KEY_F1) next = DebugView::None;
+    if (key == GLFW_KEY_F2) next = DebugView::Overdraw;
+    if (key == GLFW_KEY_F3) next = DebugView::ShadowTexel;
+    if (key == GLFW_KEY_F4) next = DebugView::TriDensity;
+
+    if (next != debugView) {
+        debugView = next;
+        std::cout << "[DebugView] " << DebugViewName(debugView) << "\n";
+    }
+}
+
+bool WriteFramebufferPPM(const char* path, int w, int h) {
+    std::vector<unsigned char> px((size_t)w * h * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, w, h, GL_RGB, GL_UNSIGNED_BYTE, px.data());
+
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%d %d\n255\n", w, h);
+    for (int y = h - 1; y >= 0; --y) {
+        std::fwrite(px.data() + (size_t)y * w * 3, 1, (size_t)w * 3, f);
+    }
+    std::fclose(f);
+    return true;
+}
+
 void processInput(GLFWwindow* window, float deltaTime) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
 
@@ -47,14 +301,33 @@ void processInput(GLFWwindow* window, float deltaTime) {
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) pitch += angularSpeed * deltaTime;
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) pitch -= angularSpeed * deltaTime;
 
+    // Pans along the ground, forward being away from the camera.
+    glm::vec3 forward(-std::sin(yaw), 0.0f, -std::cos(yaw));
+    glm::vec3 right(-forward.z, 0.0f, forward.x);
+    float step = panSpeed * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) focus += forward * step;
+    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) focus -= forward * step;
+    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) focus += right * step;
+    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) focus -= right * step;
+
     constexpr float limit = glm::radians(89.0f);
     if (pitch > limit) pitch = limit;
     if (pitch < -limit) pitch = -limit;
 }
 
-GLuint compileShader(GLenum type, const char* src) {
+// `library` (GLSL functions several shaders share) goes in right after the
+// #version line of `src`.
+GLuint compileShader(GLenum type, const char* src, const char* library = nullptr) {
     GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &src, nullptr);
+    if (library) {
+        const char* body = std::strchr(src + 1, '\n') + 1;
+        const char* parts[3] = { src, library, body };
+        GLint lengths[3] = { (GLint)(body - src), -1, -1 };
+        glShaderSource(shader, 3, parts, lengths);
+    }
+    else {
+        glShaderSource(shader, 1, &src, nullptr);
+    }
     glCompileShader(shader);
 
     int success = 0;
@@ -67,6 +340,25 @@ GLuint compileShader(GLenum type, const char* src) {
     return shader;
 }
 
+// A vertex + geometry shader program whose geometry shader output is
+// captured, interleaved in the order of `varyings`, by transform feedback.
+GLuint linkFeedbackProgram(GLuint vs, GLuint gs, const char* const* varyings, int varyingCount) {
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, vs);
+    glAttachShader(prog, gs);
+    glTransformFeedbackVaryings(prog, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(prog);
+
+    int ok = 0;
+    char infoLog[1024];
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        glGetProgramInfoLog(prog, 1024, nullptr, infoLog);
+        std::cerr << "Program link error:\n" << infoLog << "\n";
+    }
+    return prog;
+}
+
 GLuint linkProgram(GLuint vs, GLuint fs) {
     GLuint prog = glCreateProgram();
     glAttachShader(prog, vs);
@@ -83,20 +375,48 @@ GLuint linkProgram(GLuint vs, GLuint fs) {
     return prog;
 }
 
-struct RenderItem {
-    glm::mat4 model;
-    glm::vec3 color;
-};
+// Wind sway, shared by the scene's vertex shaders so shadows move with what
+// casts them. A vertex h meters over its instance's anchor bends downwind by
+// wind.z * min(h / stiffness, 1)^2, swinging on the instance's phase. `w` is
+// the per-instance attribute (see PackWind); stiffness 0 is rigid.
+const char* windGlsl = R"(
+uniform vec4 wind; // xz direction, sway at full bend (m), time (radians)
+
+vec3 WindOffset(vec3 worldPos, float originY, vec4 w) {
+    float stiffness = w.y * 25.5;
+    if (stiffness <= 0.0 || wind.z <= 0.0) return vec3(0.0);
+    float bend = clamp((worldPos.y - (originY - w.z * 2.55)) / stiffness, 0.0, 1.0);
+    float t = wind.w + w.x * 6.2831853;
+    float sway = 0.6 + 0.3 * sin(t) + 0.1 * sin(2.7 * t + 1.3);
+    return vec3(wind.x, 0.0, wind.y) * (wind.z * bend * bend * sway);
+}
+)";
 
+// Everything is drawn as prefab instances, one call per run of boxes sharing a
+// mesh: GL instance i is box i % prefabBoxCount of the run, its local transform
+// and color fetched from the prefab buffer, its parent transform and tint from
+// the per-instance attributes (divisor = prefabBoxCount). A plain item is an
+// instance of its mesh's bare one-box prefab, tinted with its material.
 const char* shadowVertexShaderSrc = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 2) in mat4 aInstance;
+layout (location = 7) in vec4 aWind;
 
 uniform mat4 lightSpaceMatrix;
-uniform mat4 model;
+uniform float positionScale;
+
+uniform samplerBuffer prefabBoxes;
+uniform int prefabFirstBox;
+uniform int prefabBoxCount;
 
 void main() {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    int t = (prefabFirstBox + gl_InstanceID % prefabBoxCount) * 5;
+    mat4 M = aInstance * mat4(texelFetch(prefabBoxes, t), texelFetch(prefabBoxes, t + 1),
+        texelFetch(prefabBoxes, t + 2), texelFetch(prefabBoxes, t + 3));
+    vec4 worldPos = M * vec4(aPos * positionScale, 1.0);
+    worldPos.xyz += WindOffset(worldPos.xyz, aInstance[3].y, aWind);
+    gl_Position = lightSpaceMatrix * worldPos;
 }
 )";
 
@@ -110,20 +430,34 @@ const char* vertexShaderSrc = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+layout (location = 2) in mat4 aInstance;
+layout (location = 6) in vec4 aInstanceColor;
+layout (location = 7) in vec4 aWind;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 uniform mat4 lightSpaceMatrix;
+uniform float positionScale;
+
+uniform samplerBuffer prefabBoxes;
+uniform int prefabFirstBox;
+uniform int prefabBoxCount;
 
 out vec3 FragPos;
 out vec3 Normal;
+out vec3 Color;
 out vec4 FragPosLightSpace;
 
 void main() {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    int t = (prefabFirstBox + gl_InstanceID % prefabBoxCount) * 5;
+    mat4 M = aInstance * mat4(texelFetch(prefabBoxes, t), texelFetch(prefabBoxes, t + 1),
+        texelFetch(prefabBoxes, t + 2), texelFetch(prefabBoxes, t + 3));
+    Color = texelFetch(prefabBoxes, t + 4).rgb * aInstanceColor.rgb;
+
+    vec4 worldPos = M * vec4(aPos * positionScale, 1.0);
+    worldPos.xyz += WindOffset(worldPos.xyz, aInstance[3].y, aWind);
     FragPos = worldPos.xyz;
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    Normal = mat3(transpose(inverse(M))) * aNormal;
     FragPosLightSpace = lightSpaceMatrix * worldPos;
     gl_Position = projection * view * worldPos;
 }
@@ -135,9 +469,9 @@ out vec4 FragColor;
 
 in vec3 FragPos;
 in vec3 Normal;
+in vec3 Color;
 in vec4 FragPosLightSpace;
 
-uniform vec3 uColor;
 uniform vec3 lightPos;
 uniform vec3 lightColor;
 uniform vec3 viewPos;
@@ -146,6 +480,7 @@ uniform float specularStrength;
 uniform float shininess;
 
 uniform sampler2D shadowMap;
+uniform int debugView;
 
 float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
@@ -169,12 +504,28 @@ float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir) {
     return shadow;
 }
 
+vec3 ShadowTexelDensityColor(float texelsPerPixel) {
+    float t = clamp(log2(max(texelsPerPixel, 1e-4)) * 0.5, -1.0, 1.0);
+    vec3 under = vec3(0.95, 0.15, 0.10);
+    vec3 match = vec3(0.15, 0.85, 0.20);
+    vec3 over = vec3(0.15, 0.35, 0.95);
+    return t < 0.0 ? mix(match, under, -t) : mix(match, over, t);
+}
+
 void main() {
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(lightPos - FragPos);
 
     float diff = max(dot(norm, lightDir), 0.0);
 
+    if (debugView == 2) {
+        vec3 projCoords = FragPosLightSpace.xyz / FragPosLightSpace.w * 0.5 + 0.5;
+        vec2 texel = projCoords.xy * vec2(textureSize(shadowMap, 0));
+        float texelsPerPixel = max(length(dFdx(texel)), length(dFdy(texel)));
+        FragColor = vec4(ShadowTexelDensityColor(texelsPerPixel) * (0.45 + 0.55 * diff), 1.0);
+        return;
+    }
+
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 halfDir = normalize(lightDir + viewDir);
     float spec = pow(max(dot(norm, halfDir), 0.0), shininess);
@@ -184,268 +535,1169 @@ void main() {
     vec3 specular = specularStrength * spec * lightColor;
 
     float shadow = ShadowCalculation(FragPosLightSpace, norm, lightDir);
-    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * uColor;
+    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * Color;
 
     FragColor = vec4(lighting, 1.0);
 }
 )";
 
+// Terrain height for the shaders that stand on it (compileShader library).
+// Height and its helpers mirror Terrain in Terrain.h; keep them in sync.
+const char* terrainGlsl = R"(
+uniform vec2 tOrigin;
+uniform float tTileSize;
+uniform vec2 tTileMax;
+uniform float tGroundY;
+uniform vec2 tPadHalf;
+uniform vec2 tRoad;
+uniform float tBlend;
+uniform float tAmplitude;
+uniform float tWavelength;
+uniform uint tSeed;
+
+uint Hash(int x, int z, uint seed) {
+    uint h = (uint(x) * 0x8da6b343u) ^ (uint(z) * 0xd8163841u) ^ seed;
+    h = (h ^ (h >> 16)) * 0x7feb352du;
+    h = (h ^ (h >> 15)) * 0x846ca68bu;
+    return h ^ (h >> 16);
+}
 
-int main() {
-    srand((unsigned int)time(nullptr));
-    glfwSetErrorCallback(glfw_error_callback);
+float Lattice(int x, int z, uint seed) {
+    return float(Hash(x, z, seed) >> 8) * (2.0 / 16777215.0) - 1.0;
+}
 
-    if (!glfwInit()) {
-        std::cerr << "Failed to init GLFW\n";
-        return -1;
-    }
+float Noise(vec2 p, uint seed) {
+    vec2 f = floor(p);
+    int ix = int(f.x), iz = int(f.y);
+    vec2 t = p - f;
+    t = t * t * (3.0 - 2.0 * t);
+    float a = mix(Lattice(ix, iz, seed), Lattice(ix + 1, iz, seed), t.x);
+    float b = mix(Lattice(ix, iz + 1, seed), Lattice(ix + 1, iz + 1, seed), t.x);
+    return mix(a, b, t.y);
+}
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+float Fbm(vec2 p) {
+    float sum = 0.0, weight = 1.0, total = 0.0;
+    for (int o = 0; o < 4; ++o) {
+        sum += weight * Noise(p, tSeed + uint(o) * 0x9e3779b9u);
+        total += weight;
+        p *= 2.0;
+        weight *= 0.5;
+    }
+    return sum / total;
+}
 
+float Flatness(vec2 p) {
+    vec2 tile = clamp(floor((p - tOrigin) / tTileSize + 0.5), vec2(0.0), tTileMax);
+    vec2 l = p - (tOrigin + tile * tTileSize);
+    float dPad = length(max(abs(l) - tPadHalf, vec2(0.0)));
+    float dRoad = length(max(abs(l - vec2(tRoad.x, 0.0)) - vec2(tRoad.y, tTileSize * 0.5), vec2(0.0)));
+    float t = min(min(dPad, dRoad) / tBlend, 1.0);
+    return 1.0 - t * t * (3.0 - 2.0 * t);
+}
 
+float TerrainHeight(vec2 p) {
+    float pad = Flatness(p);
+    if (pad >= 1.0) return tGroundY;
+    return tGroundY + tAmplitude * Fbm(p / tWavelength) * (1.0 - pad);
+}
+)";
 
-    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
-    const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+// Terrain patches (CdlodTree nodes): the unit grid is laid over the node's
+// square, morphed toward the next coarser grid with distance from lodEye and
+// lifted to the terrain height. Outputs what the scene fragment shaders take,
+// so it links with the main, shadow and count ones. Needs terrainGlsl.
+const char* terrainVertexShaderSrc = R"(
+#version 330 core
+layout (location = 0) in vec2 aGrid;
+layout (location = 1) in vec4 aNode;
 
-    glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 lightSpaceMatrix;
+uniform vec3 lodEye;
+uniform float gridDim;
+uniform vec2 morphRange[16];
+uniform vec3 terrainColor;
 
-    const int WIN_W = WC::WIN_W;
-    const int WIN_H = WC::WIN_H;
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+out vec4 FragPosLightSpace;
 
-    GLFWwindow* window = glfwCreateWindow(WIN_W, WIN_H, "Final House with Shadow", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window\n";
-        glfwTerminate();
-        return -1;
-    }
+void main() {
+    vec2 p = aNode.xy + aGrid * aNode.z;
+    vec2 range = morphRange[int(aNode.w)];
+    float k = clamp((distance(lodEye, vec3(p.x, TerrainHeight(p), p.y)) - range.x) / (range.y - range.x), 0.0, 1.0);
+    // Odd grid vertices slide onto the even one before them; fully morphed,
+    // the patch is the coarser level's grid.
+    p -= fract(aGrid * gridDim * 0.5) * 2.0 / gridDim * aNode.z * k;
+
+    const float e = 0.5;
+    vec4 worldPos = vec4(p.x, TerrainHeight(p), p.y, 1.0);
+    Normal = normalize(vec3(TerrainHeight(p - vec2(e, 0.0)) - TerrainHeight(p + vec2(e, 0.0)), 2.0 * e,
+        TerrainHeight(p - vec2(0.0, e)) - TerrainHeight(p + vec2(0.0, e))));
+    Color = terrainColor;
+    FragPos = worldPos.xyz;
+    FragPosLightSpace = lightSpaceMatrix * worldPos;
+    gl_Position = projection * view * worldPos;
+}
+)";
 
-    int mx, my;
-    glfwGetMonitorPos(monitor, &mx, &my);
-    int x = mx + (mode->width - WIN_W) / 2;
-    int y = my + (mode->height - WIN_H) / 2;
-    glfwSetWindowPos(window, x, y);
+// Grass blades (GrassField chunks): instance i is blade i % bladesPerChunk of
+// the chunk at aChunk, placed from a hash of the two and stood on the terrain.
+// Blades on a lot's yard, house or road, or past the density at their
+// distance, fall outside the clip volume. Density mirrors GrassField in
+// Grass.h. Needs groundGlsl.
+const char* grassVertexShaderSrc = R"(
+#version 330 core
+layout (location = 0) in vec2 aBlade;
+layout (location = 1) in ivec2 aChunk;
 
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 lightSpaceMatrix;
+uniform vec3 grassEye;
+uniform float chunkSize;
+uniform int bladesPerChunk;
+uniform int bladesFull;
+uniform vec2 fadeRange;
+uniform vec2 bladeSize;
+uniform uint grassSeed;
+uniform vec3 rootColor;
+uniform vec3 tipColor;
+
+// Style id of every lot tile, and per style its yard, road and house rects
+// (min xz, max xz) around the tile center.
+uniform usampler2D tileStyles;
+uniform vec4 exclusion[3 * LOT_STYLE_COUNT];
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetScrollCallback(window, scroll_callback);
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+out vec4 FragPosLightSpace;
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to init GLAD\n";
-        glfwTerminate();
-        return -1;
-    }
+float Unit(uint h) {
+    return float(h >> 8) * (1.0 / 16777216.0);
+}
 
-    int fbW, fbH;
-    glfwGetFramebufferSize(window, &fbW, &fbH);
-    glViewport(0, 0, fbW, fbH);
+bool InRect(vec2 l, vec4 r) {
+    return all(greaterThanEqual(l, r.xy)) && all(lessThanEqual(l, r.zw));
+}
 
-    glEnable(GL_DEPTH_TEST);
+// The rects of the tile under p, and the road of the tile before it in z,
+// which runs on past its edge.
+bool Excluded(vec2 p) {
+    vec2 tile = clamp(floor((p - tOrigin) / tTileSize + 0.5), vec2(0.0), tTileMax);
+    vec2 l = p - (tOrigin + tile * tTileSize);
+    int s = int(texelFetch(tileStyles, ivec2(tile), 0).r) * 3;
+    if (InRect(l, exclusion[s]) || InRect(l, exclusion[s + 1]) || InRect(l, exclusion[s + 2])) return true;
+    if (tile.y < 0.5) return false;
+    int prev = int(texelFetch(tileStyles, ivec2(tile) - ivec2(0, 1), 0).r) * 3;
+    return InRect(l + vec2(0.0, tTileSize), exclusion[prev + 1]);
+}
 
-    const unsigned int SHADOW_WIDTH = 2048, SHADOW_HEIGHT = 2048;
-    unsigned int depthMapFBO;
-    glGenFramebuffers(1, &depthMapFBO);
+void main() {
+    int blade = gl_InstanceID % bladesPerChunk;
+    uint chunkSeed = Hash(aChunk.x, aChunk.y, grassSeed);
+    vec2 root = (vec2(aChunk) + vec2(Unit(Hash(blade, 0, chunkSeed)), Unit(Hash(blade, 1, chunkSeed)))) * chunkSize;
+    vec3 base = vec3(root.x, TerrainHeight(root), root.y);
+
+    // The first density * bladesFull blades of a chunk stand; the next few
+    // shrink into the ground as the eye backs off.
+    float density = clamp((fadeRange.y - distance(grassEye, base)) / (fadeRange.y - fadeRange.x), 0.0, 1.0);
+    float grow = clamp((density - (float(blade) + 0.5) / float(bladesFull)) * 16.0, 0.0, 1.0);
+    FragPos = base;
+    Normal = vec3(0.0, 1.0, 0.0);
+    Color = rootColor;
+    FragPosLightSpace = vec4(0.0);
+    if (grow <= 0.0 || Excluded(root)) {
+        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+        return;
+    }
 
-    unsigned int depthMapTexture;
-    glGenTextures(1, &depthMapTexture);
-    glBindTexture(GL_TEXTURE_2D, depthMapTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    float angle = Unit(Hash(blade, 2, chunkSeed)) * 6.2831853;
+    float height = bladeSize.y * (0.6 + 0.8 * Unit(Hash(blade, 3, chunkSeed))) * grow;
+    vec3 facing = vec3(cos(angle), 0.0, sin(angle));
+    vec3 across = vec3(-facing.z, 0.0, facing.x);
+    // Tapers to the tip and bows over along `facing`.
+    float t = aBlade.y;
+    vec3 pos = base + across * (aBlade.x * 0.5 * bladeSize.x * (1.0 - t)) + vec3(0.0, height * t, 0.0) +
+        facing * (0.35 * height * t * t);
+
+    // Lit on the side toward the eye, tipped half way up so the field shades
+    // like the ground under it.
+    Normal = normalize((dot(facing, grassEye - base) < 0.0 ? -facing : facing) + vec3(0.0, 1.0, 0.0));
+    Color = mix(rootColor, tipColor, t) * (0.85 + 0.3 * Unit(Hash(blade, 4, chunkSeed)));
+    vec4 worldPos = vec4(pos, 1.0);
+    FragPos = pos;
+    FragPosLightSpace = lightSpaceMatrix * worldPos;
+    gl_Position = projection * view * worldPos;
+}
+)";
 
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMapTexture, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+// GPU scatter: one point per candidate cell of lot tile `tile`, jittered
+// inside it. A candidate is kept if it falls in its rule's area off the
+// tile's yard and road (and, for pines, the ring by the fence), wins the
+// density roll and rolls this pass's variant; it becomes a prefab parent
+// transform stood on the terrain plus a tint and wind, laid out as
+// InstanceData. The geometry shader passes on only kept ones, so transform
+// feedback appends them. Needs groundGlsl.
+const char* scatterVertexShaderSrc = R"(
+#version 330 core
+uniform ivec2 tile;
+uniform int cellsPerSide;
+uniform float cellSize;
+uniform int rule;
+uniform int variant;
+uniform int variants;
+uniform float chance;
+uniform vec2 scaleMin;
+uniform vec2 scaleMax;
+uniform float footRadius;
+uniform float windStiffness;
+uniform uint scatterSeed;
+
+// Style id of every lot tile, and per style (see ScatterAreas) the yard,
+// road, fence ring, pine area and flower area about the tile center.
+uniform usampler2D tileStyles;
+uniform vec4 areas[5 * LOT_STYLE_COUNT];
+
+out vec4 sModel0;
+out vec4 sModel1;
+out vec4 sModel2;
+out vec4 sModel3;
+flat out uint sColor;
+flat out uint sWind;
+flat out int sKeep;
+
+float Unit(uint h) {
+    return float(h >> 8) * (1.0 / 16777216.0);
+}
 
-    float vertices[] = {
-      -0.5f,-0.5f, 0.5f,  0.0f, 0.0f, 1.0f,
-       0.5f,-0.5f, 0.5f,  0.0f, 0.0f, 1.0f,
-       0.5f, 0.5f, 0.5f,  0.0f, 0.0f, 1.0f,
-      -0.5f, 0.5f, 0.5f,  0.0f, 0.0f, 1.0f,
-
-       0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,
-      -0.5f,-0.5f,-0.5f,  0.0f, 0.0f,-1.0f,
-      -0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,
-       0.5f, 0.5f,-0.5f,  0.0f, 0.0f,-1.0f,
-
-      -0.5f,-0.5f,-0.5f, -1.0f, 0.0f, 0.0f,
-      -0.5f,-0.5f, 0.5f, -1.0f, 0.0f, 0.0f,
-      -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f,
-      -0.5f, 0.5f,-0.5f, -1.0f, 0.0f, 0.0f,
-
-       0.5f,-0.5f, 0.5f,  1.0f, 0.0f, 0.0f,
-       0.5f,-0.5f,-0.5f,  1.0f, 0.0f, 0.0f,
-       0.5f, 0.5f,-0.5f,  1.0f, 0.0f, 0.0f,
-       0.5f, 0.5f, 0.5f,  1.0f, 0.0f, 0.0f,
-
-      -0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,
-       0.5f, 0.5f, 0.5f,  0.0f, 1.0f, 0.0f,
-       0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,
-      -0.5f, 0.5f,-0.5f,  0.0f, 1.0f, 0.0f,
-
-      -0.5f,-0.5f,-0.5f,  0.0f,-1.0f, 0.0f,
-       0.5f,-0.5f,-0.5f,  0.0f,-1.0f, 0.0f,
-       0.5f,-0.5f, 0.5f,  0.0f,-1.0f, 0.0f,
-      -0.5f,-0.5f, 0.5f,  0.0f,-1.0f, 0.0f
-    };
+bool InRect(vec2 l, vec4 r) {
+    return all(greaterThanEqual(l, r.xy)) && all(lessThanEqual(l, r.zw));
+}
 
-    unsigned int indices[] = {
-        0,1,2, 2,3,0,
-        4,5,6, 6,7,4,
-        8,9,10, 10,11,8,
-        12,13,14, 14,15,12,
-        16,17,18, 18,19,16,
-        20,21,22, 22,23,20
-    };
+void main() {
+    int cell = gl_VertexID;
+    uint seed = Hash(tile.x, tile.y, scatterSeed + uint(rule) * 0x9e3779b9u);
+    vec2 jitter = vec2(Unit(Hash(cell, 0, seed)), Unit(Hash(cell, 1, seed)));
+    vec2 l = (vec2(float(cell % cellsPerSide), float(cell / cellsPerSide)) + 0.15 + 0.7 * jitter) * cellSize - 0.5 * tTileSize;
+    int s = int(texelFetch(tileStyles, tile, 0).r) * 5;
+    bool inside = InRect(l, areas[s + 3 + rule]) && !InRect(l, areas[s]) && !InRect(l, areas[s + 1]) &&
+        (rule != 0 || !InRect(l, areas[s + 2]));
+    bool picked = Unit(Hash(cell, 2, seed)) < chance && int(Unit(Hash(cell, 3, seed)) * float(variants)) == variant;
+    sKeep = inside && picked ? 1 : 0;
+
+    // Lowest ground under the foot, as LotGroundY.
+    vec2 p = tOrigin + vec2(tile) * tTileSize + l;
+    float y = min(TerrainHeight(p), min(min(TerrainHeight(p - vec2(footRadius, 0.0)), TerrainHeight(p + vec2(footRadius, 0.0))),
+        min(TerrainHeight(p - vec2(0.0, footRadius)), TerrainHeight(p + vec2(0.0, footRadius)))));
+    vec2 scale = mix(scaleMin, scaleMax, Unit(Hash(cell, 4, seed)));
+    sModel0 = vec4(scale.x, 0.0, 0.0, 0.0);
+    sModel1 = vec4(0.0, scale.y, 0.0, 0.0);
+    sModel2 = vec4(0.0, 0.0, scale.x, 0.0);
+    sModel3 = vec4(p.x, y + 0.001, p.y, 1.0);
+    uint shade = uint((0.90 + 0.10 * Unit(Hash(cell, 5, seed))) * 255.0 + 0.5);
+    sColor = shade | (shade << 8) | (shade << 16) | (255u << 24);
+    // As PackWind, anchored at the instance origin.
+    sWind = (Hash(cell, 6, seed) >> 24) | (uint(clamp(windStiffness / 25.5, 0.0, 1.0) * 255.0 + 0.5) << 8);
+}
+)";
 
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+const char* scatterGeometryShaderSrc = R"(
+#version 330 core
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in vec4 sModel0[];
+in vec4 sModel1[];
+in vec4 sModel2[];
+in vec4 sModel3[];
+flat in uint sColor[];
+flat in uint sWind[];
+flat in int sKeep[];
+
+out vec4 vModel0;
+out vec4 vModel1;
+out vec4 vModel2;
+out vec4 vModel3;
+flat out uint vColor;
+flat out uint vWind;
 
-    glBindVertexArray(VAO);
+void main() {
+    if (sKeep[0] == 0) return;
+    vModel0 = sModel0[0];
+    vModel1 = sModel1[0];
+    vModel2 = sModel2[0];
+    vModel3 = sModel3[0];
+    vColor = sColor[0];
+    vWind = sWind[0];
+    EmitVertex();
+    EndPrimitive();
+}
+)";
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+const char* countFragmentShaderSrc = R"(
+#version 330 core
+out vec4 FragColor;
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+void main() {
+    FragColor = vec4(1.0, 0.0, 0.0, 1.0);
+}
+)";
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+const char* heatmapVertexShaderSrc = R"(
+#version 330 core
+out vec2 uv;
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+void main() {
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = p;
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
 
-    glBindVertexArray(0);
+const char* heatmapFragmentShaderSrc = R"(
+#version 330 core
+out vec4 FragColor;
+in vec2 uv;
+
+uniform sampler2D countTex;
+uniform float maxCount;
+
+vec3 Heat(float t) {
+    vec3 c0 = vec3(0.0, 0.0, 0.0);
+    vec3 c1 = vec3(0.10, 0.20, 0.90);
+    vec3 c2 = vec3(0.10, 0.85, 0.25);
+    vec3 c3 = vec3(0.98, 0.90, 0.15);
+    vec3 c4 = vec3(0.95, 0.15, 0.10);
+    vec3 c5 = vec3(1.0, 1.0, 1.0);
+    t = clamp(t, 0.0, 1.0) * 5.0;
+    if (t < 1.0) return mix(c0, c1, t);
+    if (t < 2.0) return mix(c1, c2, t - 1.0);
+    if (t < 3.0) return mix(c2, c3, t - 2.0);
+    if (t < 4.0) return mix(c3, c4, t - 3.0);
+    return mix(c4, c5, t - 4.0);
+}
 
-    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexShaderSrc);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
-    GLuint shaderProgram = linkProgram(vs, fs);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+void main() {
+    float n = texture(countTex, uv).r;
+    FragColor = vec4(Heat(n / maxCount), 1.0);
+}
+)";
 
-    GLuint shadowVs = compileShader(GL_VERTEX_SHADER, shadowVertexShaderSrc);
-    GLuint shadowFs = compileShader(GL_FRAGMENT_SHADER, shadowFragmentShaderSrc);
-    GLuint shadowShaderProgram = linkProgram(shadowVs, shadowFs);
-    glDeleteShader(shadowVs);
-    glDeleteShader(shadowFs);
+// Impostor capture: the scene vertex shader with the static light baked in
+// (ambient + diffuse; specular and shadows depend on the viewer) and the
+// frame's linear depth written beside the color.
+const char* captureFragmentShaderSrc = R"(
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out float FragDepth;
 
-    GLint shadowLightSpaceMatrixLoc = glGetUniformLocation(shadowShaderProgram, "lightSpaceMatrix");
-    GLint shadowModelLoc = glGetUniformLocation(shadowShaderProgram, "model");
+in vec3 FragPos;
+in vec3 Normal;
+in vec3 Color;
+in vec4 FragPosLightSpace;
 
-    glUseProgram(shaderProgram);
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-    GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
-    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-    GLint colorLoc = glGetUniformLocation(shaderProgram, "uColor");
-    GLint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos");
-    GLint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-    GLint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
-    GLint ambientLoc = glGetUniformLocation(shaderProgram, "ambientStrength");
-    GLint specularLoc = glGetUniformLocation(shaderProgram, "specularStrength");
-    GLint shininessLoc = glGetUniformLocation(shaderProgram, "shininess");
+uniform vec3 lightPos;
+uniform vec3 lightColor;
+uniform float ambientStrength;
 
-    GLint lightSpaceMatrixLoc = glGetUniformLocation(shaderProgram, "lightSpaceMatrix");
-    GLint shadowMapLoc = glGetUniformLocation(shaderProgram, "shadowMap");
-    glUniform1i(shadowMapLoc, 0);
+void main() {
+    vec3 norm = normalize(Normal);
+    float diff = max(dot(norm, normalize(lightPos - FragPos)), 0.0);
+    FragColor = vec4((ambientStrength + diff) * lightColor * Color, 1.0);
+    FragDepth = gl_FragCoord.z;
+}
+)";
 
-    const float groundY = WC::GROUND_Y;
-    const float overlayY = WC::OVERLAY_Y;
-    glm::vec3 center = WC::SHIN_CENTER;
+// One camera-facing quad per impostor, spanning its bounding sphere.
+const char* impostorVertexShaderSrc = R"(
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in vec4 aSphere;
+layout (location = 2) in float aLayer;
 
-    yaw = glm::radians(28.0f);
-    pitch = glm::radians(19.0f);
-    radius = std::max(radiusMin, std::min(radiusMax, 78.0f));
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
 
-    constexpr float YARD_SCALE_W = 2.40f;
-    constexpr float YARD_SCALE_L = 1.95f;
+out vec3 WorldPos;
+flat out vec4 Sphere;
+flat out float Layer;
 
-    float yardW0 = WC::YARD_W * YARD_SCALE_W;
-    float yardL0 = WC::YARD_L * YARD_SCALE_L;
+void main() {
+    vec3 toEye = normalize(viewPos - aSphere.xyz);
+    vec3 up = abs(toEye.y) > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up, toEye));
+    up = cross(toEye, right);
+    WorldPos = aSphere.xyz + (right * aCorner.x + up * aCorner.y) * aSphere.w;
+    Sphere = aSphere;
+    Layer = aLayer;
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
+)";
 
-    float fenceThk = WC::FENCE_THK;
+// Blends the three atlas frames around the view direction (a triangle of the
+// octahedral grid, barycentric weights). Each frame is sampled where the view
+// ray crosses that frame's plane, and its depth puts the surface point back
+// in the world for gl_FragDepth.
+const char* impostorFragmentShaderSrc = R"(
+#version 330 core
+out vec4 FragColor;
 
-    float fenceHalfW = yardW0 * 0.5f + WC::FENCE_MARGIN;
-    float fenceHalfL = yardL0 * 0.5f + WC::FENCE_MARGIN;
+in vec3 WorldPos;
+flat in vec4 Sphere;
+flat in float Layer;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform int frames;
+uniform sampler2DArray impostorColor;
+uniform sampler2DArray impostorDepth;
+
+vec2 HemiOctEncode(vec3 d) {
+    d.y = max(d.y, 0.0);
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    return vec2(d.x + d.z, d.x - d.z) * 0.5 + 0.5;
+}
+
+vec3 HemiOctDecode(vec2 uv) {
+    vec2 p = uv * 2.0 - 1.0;
+    vec3 d = vec3(p.x + p.y, 0.0, p.x - p.y) * 0.5;
+    d.y = 1.0 - abs(d.x) - abs(d.z);
+    return normalize(d);
+}
+
+void main() {
+    vec3 c = Sphere.xyz;
+    float R = Sphere.w;
+    vec3 rd = normalize(WorldPos - viewPos);
+
+    float last = float(frames - 1);
+    vec2 g = HemiOctEncode(normalize(viewPos - c)) * last;
+    vec2 base = min(floor(g), vec2(last - 1.0));
+    vec2 f = g - base;
+    vec2 cell[3];
+    float weight[3];
+    cell[1] = base + vec2(1.0, 0.0);
+    cell[2] = base + vec2(0.0, 1.0);
+    if (f.x + f.y < 1.0) {
+        cell[0] = base;
+        weight[0] = 1.0 - f.x - f.y;
+        weight[1] = f.x;
+        weight[2] = f.y;
+    }
+    else {
+        cell[0] = base + vec2(1.0);
+        weight[0] = f.x + f.y - 1.0;
+        weight[1] = 1.0 - f.y;
+        weight[2] = 1.0 - f.x;
+    }
+
+    vec4 color = vec4(0.0);
+    vec3 pos = vec3(0.0);
+    float posWeight = 0.0;
+    float halfTexel = 0.5 / float(textureSize(impostorColor, 0).x / frames);
+    for (int k = 0; k < 3; ++k) {
+        vec3 dir = HemiOctDecode(cell[k] / last);
+        vec3 up = abs(dir.y) > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+        vec3 x = normalize(cross(up, dir));
+        vec3 y = cross(dir, x);
+
+        float denom = dot(rd, dir);
+        vec3 q = viewPos + rd * (dot(c - viewPos, dir) / (abs(denom) > 1e-4 ? denom : 1e-4));
+        vec2 uv = vec2(dot(q - c, x), dot(q - c, y)) / (2.0 * R) + 0.5;
+        if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) continue;
+        vec3 atlas = vec3((cell[k] + clamp(uv, vec2(halfTexel), vec2(1.0 - halfTexel))) / float(frames), Layer);
+
+        vec4 s = texture(impostorColor, atlas);
+        color += weight[k] * s;
+        float d = texture(impostorDepth, atlas).r;
+        pos += weight[k] * s.a * (q + dir * (R - d * 2.0 * R));
+        posWeight += weight[k] * s.a;
+    }
+    if (color.a < 0.5) discard;
+
+    vec4 clip = projection * view * vec4(pos / posWeight, 1.0);
+    gl_FragDepth = clamp(clip.z / clip.w * 0.5 + 0.5, 0.0, 1.0);
+    FragColor = vec4(color.rgb / color.a, 1.0);
+}
+)";
+
+
+// Scene builders append to the calling thread's target, so each builder can run
+// as its own task and fill a private buffer without locking.
+thread_local SceneWorld* tlBuildWorld = nullptr;
+thread_local PrefabLibrary* tlBuildPrefabs = nullptr;
+thread_local MeshLibrary* tlBuildMeshes = nullptr;
+// LOD groups opened so far in this target, and the one items join (~0u: none).
+thread_local uint32_t* tlBuildLodGroups = nullptr;
+thread_local uint32_t tlLodGroup = ~0u;
+// While a prefab is being defined, AddItem records into it instead.
+thread_local std::vector<PrefabBox>* tlRecordPrefab = nullptr;
+// What items sway like (stiffness 0: they don't); the phase is per item.
+thread_local Wind tlWind = { 0.0f, 0.0f, 0.0f };
+// How items move (null: they are static).
+thread_local const Anim* tlAnim = nullptr;
+// The hierarchy node items go under (~0u: none), and whether it moves.
+thread_local uint32_t tlNode = TransformHierarchy::NONE;
+thread_local bool tlNodeMoves = false;
+
+struct BuildTarget {
+    BuildTarget(SceneWorld& world, PrefabLibrary& prefabs, MeshLibrary& meshes, uint32_t& lodGroups)
+        : prevWorld(tlBuildWorld), prevPrefabs(tlBuildPrefabs), prevMeshes(tlBuildMeshes), prevLodGroups(tlBuildLodGroups) {
+        tlBuildWorld = &world;
+        tlBuildPrefabs = &prefabs;
+        tlBuildMeshes = &meshes;
+        tlBuildLodGroups = &lodGroups;
+    }
+    ~BuildTarget() {
+        tlBuildWorld = prevWorld;
+        tlBuildPrefabs = prevPrefabs;
+        tlBuildMeshes = prevMeshes;
+        tlBuildLodGroups = prevLodGroups;
+    }
+
+    BuildTarget(const BuildTarget&) = delete;
+    BuildTarget& operator=(const BuildTarget&) = delete;
+
+    SceneWorld* prevWorld;
+    PrefabLibrary* prevPrefabs;
+    MeshLibrary* prevMeshes;
+    uint32_t* prevLodGroups;
+};
+
+// Items added while one is alive form a new LOD group: they are baked into
+// simplified proxies after the build and swapped for them at distance.
+struct LodGroupScope {
+    LodGroupScope() : prev(tlLodGroup) { tlLodGroup = (*tlBuildLodGroups)++; }
+    ~LodGroupScope() { tlLodGroup = prev; }
+
+    LodGroupScope(const LodGroupScope&) = delete;
+    LodGroupScope& operator=(const LodGroupScope&) = delete;
+
+    uint32_t prev;
+};
+
+// Items added while one is alive sway in the wind, bending fully `stiffness`
+// meters above `baseY`. The phase comes from the item's spot, so the parts
+// of one plant swing together.
+struct WindScope {
+    WindScope(float stiffness, float baseY) : prev(tlWind) { tlWind = { 0.0f, stiffness, baseY }; }
+    ~WindScope() { tlWind = prev; }
+
+    WindScope(const WindScope&) = delete;
+    WindScope& operator=(const WindScope&) = delete;
+
+    Wind prev;
+};
+
+// Items added while one is alive are dynamic and move by `anim` (or with the
+// node that takes it, see NodeScope); they never join a LOD group, since the
+// proxies are baked in place.
+struct MotionScope {
+    explicit MotionScope(const Anim& anim) : anim(anim), prev(tlAnim) { tlAnim = &this->anim; }
+    ~MotionScope() { tlAnim = prev; }
+
+    MotionScope(const MotionScope&) = delete;
+    MotionScope& operator=(const MotionScope&) = delete;
+
+    Anim anim;
+    const Anim* prev;
+};
+
+// Opens a node of the target's hierarchy at `world`, under the current one.
+// Items and nodes added while it is alive are its children: they keep their
+// placement, stored relative to the node, and follow it when it moves. The
+// first node opened in a MotionScope takes the motion: a Pivot entity moves
+// the node, and the items under it move with it instead of on their own.
+struct NodeScope {
+    explicit NodeScope(const glm::mat4& world) : prev(tlNode), prevMoves(tlNodeMoves) {
+        SceneWorld& w = *tlBuildWorld;
+        TransformHierarchy& nodes = w.Nodes();
+        node = nodes.Add(prev, prev == TransformHierarchy::NONE ? world : glm::inverse(nodes.World(prev)) * world);
+        if (tlAnim && !tlNodeMoves) {
+            Entity e = w.Create(Anim::Bit | Pivot::Bit);
+            Anim* a = w.Get<Anim>(e);
+            *a = *tlAnim;
+            a->rest = glm::vec3(nodes.Local(node)[3]);
+            w.Get<Pivot>(e)->node = node;
+            tlNodeMoves = true;
+        }
+        tlNode = node;
+    }
+    ~NodeScope() {
+        tlNode = prev;
+        tlNodeMoves = prevMoves;
+    }
+
+    NodeScope(const NodeScope&) = delete;
+    NodeScope& operator=(const NodeScope&) = delete;
+
+    uint32_t node;
+    uint32_t prev;
+    bool prevMoves;
+};
+
+// The Lod or Anim bit of a new item; SetMotion fills it in with the layer.
+uint32_t MotionBits() {
+    if (tlAnim) return Anim::Bit;
+    return tlLodGroup != ~0u ? Lod::Bit : 0u;
+}
+
+void SetMotion(SceneWorld& w, Entity e, const glm::mat4& model) {
+    if (tlAnim) {
+        Anim* a = w.Get<Anim>(e);
+        *a = *tlAnim;
+        a->rest = glm::vec3(model[3]);
+        if (tlNodeMoves) a->motion = MOTION_PARENT;
+        w.Get<Layer>(e)->flags = LAYER_DYNAMIC | LAYER_CAST_SHADOW;
+        return;
+    }
+    w.Get<Layer>(e)->flags = LAYER_STATIC | LAYER_CAST_SHADOW;
+    if (tlLodGroup != ~0u) *w.Get<Lod>(e) = { tlLodGroup, 0 };
+}
+
+uint32_t NodeBit() {
+    return tlNode != TransformHierarchy::NONE ? Parent::Bit : 0u;
+}
+
+void SetNode(SceneWorld& w, Entity e, const glm::mat4& model) {
+    *w.Get<Parent>(e) = { tlNode, glm::inverse(w.Nodes().World(tlNode)) * model };
+}
+
+uint32_t WindBit() {
+    return tlWind.stiffness > 0.0f ? Wind::Bit : 0u;
+}
+
+// Fills the Wind of a new item at `model` and pads its bounds by the most
+// it can sway.
+void SetWind(SceneWorld& w, Entity e, const glm::mat4& model) {
+    uint32_t h = ((uint32_t)(int32_t)std::floor(model[3].x * 4.0f) * 0x8da6b343u) ^
+        ((uint32_t)(int32_t)std::floor(model[3].z * 4.0f) * 0xd8163841u);
+    h = (h ^ (h >> 16)) * 0x7feb352du;
+    h ^= h >> 15;
+    *w.Get<Wind>(e) = { (float)(h >> 8) * (6.2831853f / 16777216.0f), tlWind.stiffness, tlWind.baseY };
+    Bounds& b = *w.Get<Bounds>(e);
+    b.min -= glm::vec3(WC::WIND_MAX_SWAY, 0.0f, WC::WIND_MAX_SWAY);
+    b.max += glm::vec3(WC::WIND_MAX_SWAY, 0.0f, WC::WIND_MAX_SWAY);
+}
+
+// The per-instance wind attribute as RGBA8 (windGlsl unpacks it): phase /
+// 2pi, stiffness / 25.5 m, and the anchor's depth under the instance origin
+// `originY` / 2.55 m. Zero is rigid.
+uint32_t PackWind(const Wind& wind, float originY) {
+    return PackUnorm8x4(glm::vec4(wind.phase / 6.2831853f, wind.stiffness / 25.5f, (originY - wind.baseY) / 2.55f, 0.0f));
+}
+
+// `mesh` is a MeshLibrary id; every mesh fits the unit cube, so the box
+// helpers place cylinders, cones, spheres and prisms the same way.
+void AddItem(const glm::mat4& model, const glm::vec3& col, uint32_t mesh = MESH_CUBE) {
+    if (tlRecordPrefab) {
+        tlRecordPrefab->push_back({ model, col, mesh });
+        return;
+    }
+    SceneWorld& w = *tlBuildWorld;
+    uint32_t wind = WindBit();
+    uint32_t node = NodeBit();
+    Entity e = w.Create(Transform::Bit | Bounds::Bit | Material::Bit | Layer::Bit | MeshRef::Bit | MotionBits() | wind | node);
+    w.Get<Transform>(e)->model = model;
+    *w.Get<Bounds>(e) = UnitCubeBounds(model);
+    w.Get<Material>(e)->color = col;
+    w.Get<MeshRef>(e)->mesh = mesh;
+    SetMotion(w, e, model);
+    if (node) SetNode(w, e, model);
+    if (wind) SetWind(w, e, model);
+}
+
+void AddBottom(glm::vec3 pos, glm::vec3 euler, glm::vec3 scl, glm::vec3 col, uint32_t mesh = MESH_CUBE) {
+    AddItem(MakeModel_BottomPivot(pos, euler, scl), col, mesh);
+}
+
+void AddCenter(glm::vec3 pos, glm::vec3 euler, glm::vec3 scl, glm::vec3 col, uint32_t mesh = MESH_CUBE) {
+    AddItem(MakeModel_CenterPivot(pos, euler, scl), col, mesh);
+}
+
+void AddBox(glm::vec3 pos, glm::vec3 euler, glm::vec3 scl, glm::vec3 col, bool bottomPivot) {
+    if (bottomPivot) AddBottom(pos, euler, scl, col);
+    else AddCenter(pos, euler, scl, col);
+}
+
+// Adds a world-space mesh built on the spot as one item: the mesh is fitted
+// to the unit cube like the primitives and the item's model undoes that.
+void AddMeshItem(MeshBuilder& b, glm::vec3 col) {
+    glm::mat4 model = b.FitUnitCube();
+    AddItem(model, col, tlBuildMeshes->Add(b));
+}
+
+enum : uint32_t { PREFAB_PINE = 1, PREFAB_STREET_LIGHT, PREFAB_WINDOW_RECT, PREFAB_WINDOW_WIDE3, PREFAB_CLOUD, PREFAB_MAILBOX, PREFAB_LOD_PROXY, PREFAB_FLOWER };
+
+// The prefab for `key` in the current build target, defining it on first use
+// by running `emit` (ordinary Add* calls, in prefab-local space) once.
+template <class F>
+uint32_t DefinePrefab(const PrefabKey& key, F&& emit) {
+    PrefabLibrary& lib = *tlBuildPrefabs;
+    uint32_t id = lib.Find(key);
+    if (id != ~0u) return id;
+
+    std::vector<PrefabBox> boxes;
+    std::vector<PrefabBox>* prev = tlRecordPrefab;
+    tlRecordPrefab = &boxes;
+    emit();
+    tlRecordPrefab = prev;
+    return lib.Add(key, boxes.data(), boxes.size());
+}
+
+void AddPrefabInstance(uint32_t prefab, const glm::mat4& parent) {
+    const Prefab& p = tlBuildPrefabs->Get(prefab);
+    SceneWorld& w = *tlBuildWorld;
+    uint32_t wind = WindBit();
+    uint32_t node = NodeBit();
+    Entity e = w.Create(Transform::Bit | Bounds::Bit | Layer::Bit | PrefabRef::Bit | MotionBits() | wind | node);
+    w.Get<Transform>(e)->model = parent;
+    *w.Get<Bounds>(e) = TransformBounds(parent, p.boundsMin, p.boundsMax);
+    w.Get<PrefabRef>(e)->prefab = prefab;
+    SetMotion(w, e, parent);
+    if (node) SetNode(w, e, parent);
+    if (wind) SetWind(w, e, parent);
+}
+
+// Parent transform at `pos` whose local +Z points along `facing` (an axis
+// direction), built exactly rather than through a rotation angle.
+glm::mat4 FacingParent(const glm::vec3& pos, const glm::vec3& facing) {
+    glm::vec3 up(0.0f, 1.0f, 0.0f);
+    glm::mat4 m(1.0f);
+    m[0] = glm::vec4(glm::cross(up, facing), 0.0f);
+    m[1] = glm::vec4(up, 0.0f);
+    m[2] = glm::vec4(facing, 0.0f);
+    m[3] = glm::vec4(pos, 1.0f);
+    return m;
+}
+
+enum : uint32_t { SCATTER_YARD = 1u, SCATTER_ROAD = 2u, SCATTER_HOUSE = 4u, SCATTER_NEAR_FENCE = 8u };
+
+struct PineSpot {
+    glm::vec3 base;
+    float trunkH, trunkW;
+    glm::vec3 leaf;
+};
+
+struct StreetLightSpot {
+    glm::vec3 base;
+    float poleH, poleW;
+};
+
+struct HousePalette {
+    glm::vec3 base{ 0.55f, 0.45f, 0.35f };
+    glm::vec3 wall{ 0.86f, 0.82f, 0.72f };
+    glm::vec3 trim{ 0.93f, 0.93f, 0.93f };
+    glm::vec3 door{ 0.30f, 0.18f, 0.10f };
+    glm::vec3 window{ 0.65f, 0.80f, 0.95f };
+    glm::vec3 roof{ 0.70f, 0.20f, 0.20f };
+    glm::vec3 wood{ 0.78f, 0.72f, 0.62f };
+    glm::vec3 chimney{ 0.35f, 0.22f, 0.16f };
+    glm::vec3 rail{ 0.85f, 0.85f, 0.85f };
+};
+
+// The knobs that differ between the lots of a grid; the defaults are the
+// hand-tuned single lot.
+struct LotStyle {
+    float houseScale = 1.25f;
+    float yardScaleW = 2.40f;
+    float yardScaleL = 1.95f;
+    float gateOffsetX = 4.0f;
+    HousePalette palette;
+    // Which of MakeLotStyle's palettes `palette` is; 0 for the defaults. Goes
+    // into the keys of prefabs colored from it.
+    uint32_t paletteId = 0;
+    // Which of MakeLotStyle's picks this is; 0 for the defaults.
+    uint32_t id = 0;
+};
+
+// A seeded pick from a few scales, palettes and yard layouts. The set is kept
+// small on purpose: lots repeat each other's houses often enough to share
+// prefabs and impostor atlases, while vegetation follows each lot's own seed.
+LotStyle MakeLotStyle(uint64_t seed) {
+    static const float scales[] = { 1.05f, 1.15f, 1.25f };
+    static const float yards[][3] = {
+        { 2.40f, 1.95f, 4.0f },
+        { 2.50f, 2.00f, 2.0f },
+        { 2.60f, 2.05f, 6.0f },
+    };
+    HousePalette palettes[4];
+    palettes[1].wall = glm::vec3(0.78f, 0.82f, 0.86f);
+    palettes[1].roof = glm::vec3(0.25f, 0.30f, 0.38f);
+    palettes[1].door = glm::vec3(0.20f, 0.25f, 0.35f);
+    palettes[2].wall = glm::vec3(0.88f, 0.86f, 0.78f);
+    palettes[2].roof = glm::vec3(0.22f, 0.40f, 0.28f);
+    palettes[2].door = glm::vec3(0.45f, 0.20f, 0.12f);
+    palettes[3].wall = glm::vec3(0.72f, 0.42f, 0.32f);
+    palettes[3].roof = glm::vec3(0.30f, 0.28f, 0.28f);
+    palettes[3].trim = glm::vec3(0.90f, 0.88f, 0.84f);
+    palettes[3].door = glm::vec3(0.22f, 0.22f, 0.24f);
+
+    Pcg32 rng = MakeRng(seed, RngStream::LotStyle);
+    int scale = rng.Int(3);
+    int yard = rng.Int(3);
+    int palette = rng.Int(4);
+    LotStyle s;
+    s.houseScale = scales[scale];
+    s.yardScaleW = yards[yard][0];
+    s.yardScaleL = yards[yard][1];
+    s.gateOffsetX = yards[yard][2];
+    s.palette = palettes[palette];
+    s.paletteId = (uint32_t)palette;
+    s.id = 1 + (uint32_t)(scale + 3 * (yard + 3 * palette));
+    return s;
+}
+
+// Ids MakeLotStyle hands out, and the defaults' 0. The grass and scatter
+// shaders size their per-style uniform arrays by it (groundGlsl); at 5 vec4
+// a style the scatter's 185 are already close to the 256 vec4 of vertex
+// uniforms GL 3.3 guarantees, so more styles need another way in.
+constexpr uint32_t LOT_STYLE_COUNT = 1 + 3 * 3 * 4;
+static_assert(5 * LOT_STYLE_COUNT + 32 <= 256, "scatter areas outgrow the GL 3.3 vertex uniform minimum");
+
+// Everything the builders share, computed up front so they only read it.
+struct LotLayout {
+    uint64_t seed = WC::SCENE_SEED;
+    glm::vec3 center = WC::SHIN_CENTER;
+    float groundY = WC::GROUND_Y;
+    float overlayY = WC::OVERLAY_Y;
+
+    float fenceThk, fenceHalfW, fenceHalfL, fenceLenX, fenceLenZ;
+    float gateW, fenceH, pillarW, pillarH;
+    float hedgeHh, hedgeY, hedgeThk2;
+    float yardFullW, yardFullL, yardW, yardL;
+    float fenceLeftX, fenceRightX;
+    float gateCenterX, gateLeftX, gateRightX;
+    float leftLen, rightLen, leftCenterX, rightCenterX;
+    float frontFenceCenterZ, frontFenceOuterZ;
+    float roadW, roadL, roadCenterZ;
+
+    float houseScale;
+    glm::vec3 houseCenter;
+    float slabY, slabH;
+    float W1, D1, H1;
+    float f1Y, winFrontZ, midEaveY;
+    glm::vec3 carportCenter;
+    float carportW, carportD, carportOver;
+    LotStyle style;
+
+    glm::vec3 leaf[3] = {
+        glm::vec3(0.18f, 0.45f, 0.22f),
+        glm::vec3(0.15f, 0.38f, 0.20f),
+        glm::vec3(0.20f, 0.52f, 0.25f),
+    };
+    std::vector<PineSpot> pines;
+    std::vector<StreetLightSpot> streetLights;
+
+    // Ground to stand things on. A lot built away from where it ends up (see
+    // BuildStreamedLot) queries the terrain at its final place.
+    const Terrain* terrain = nullptr;
+    glm::vec3 buildOffset{ 0.0f };
+    // Scattered pines and flowers come from the GPU scatter, not the builders.
+    bool gpuScatter = false;
+};
+
+// Overlay height at (x, z) of the lot: the lowest ground under a disc of
+// `radius`, so posts and trunks reach into slopes rather than float.
+float LotGroundY(const LotLayout& L, float x, float z, float radius = 0.0f) {
+    if (!L.terrain) return L.overlayY;
+    return L.overlayY - L.groundY + L.terrain->MinHeight(x + L.buildOffset.x, z + L.buildOffset.z, radius);
+}
+
+glm::vec3 LotGroundNormal(const LotLayout& L, float x, float z) {
+    if (!L.terrain) return glm::vec3(0.0f, 1.0f, 0.0f);
+    return L.terrain->Normal(x + L.buildOffset.x, z + L.buildOffset.z);
+}
+
+LotLayout MakeLotLayout(glm::vec3 center, uint64_t seed, const LotStyle& style = LotStyle()) {
+    LotLayout L;
+    L.seed = seed;
+    L.center = center;
+    L.style = style;
+    float overlayY = L.overlayY;
+
+    float yardW0 = WC::YARD_W * style.yardScaleW;
+    float yardL0 = WC::YARD_L * style.yardScaleL;
+
+    L.fenceThk = WC::FENCE_THK;
+
+    float fenceHalfW = yardW0 * 0.5f + WC::FENCE_MARGIN;
+    float fenceHalfL = yardL0 * 0.5f + WC::FENCE_MARGIN;
 
     float fenceInsetW = 26.0f;
     float fenceInsetL = 6.8f;
 
-    fenceHalfW = std::max(4.0f, fenceHalfW - fenceInsetW);
-    fenceHalfL = std::max(4.0f, fenceHalfL - fenceInsetL);
+    L.fenceHalfW = fenceHalfW = std::max(4.0f, fenceHalfW - fenceInsetW);
+    L.fenceHalfL = fenceHalfL = std::max(4.0f, fenceHalfL - fenceInsetL);
 
-    float fenceLenX = fenceHalfW * 2.0f + fenceThk;
-    float fenceLenZ = fenceHalfL * 2.0f + fenceThk;
+    L.fenceLenX = fenceHalfW * 2.0f + L.fenceThk;
+    L.fenceLenZ = fenceHalfL * 2.0f + L.fenceThk;
 
-    float gateOffsetX = 4.0f;
-    float gateW = 7.2f;
+    float gateOffsetX = style.gateOffsetX;
+    L.gateW = 7.2f;
 
-    float fenceH = WC::FENCE_H * 1.90f;
+    L.fenceH = WC::FENCE_H * 1.90f;
 
-    float pillarW = 0.7f;
-    float pillarH = fenceH + 0.40f;
+    L.pillarW = 0.7f;
+    L.pillarH = L.fenceH + 0.40f;
 
-    glm::vec3 wallColor(0.92f, 0.85f, 0.55f);
-    glm::vec3 capColor(0.86f, 0.79f, 0.50f);
-    glm::vec3 hedgeColor(0.12f, 0.45f, 0.15f);
+    L.hedgeHh = L.fenceH * 0.55f;
+    L.hedgeY = overlayY + L.fenceH * 0.22f;
+    L.hedgeThk2 = 0.16f;
 
-    float hedgeHh = fenceH * 0.55f;
-    float hedgeY = overlayY + fenceH * 0.22f;
-    float hedgeThk2 = 0.16f;
+    L.yardFullW = fenceHalfW * 2.0f;
+    L.yardFullL = fenceHalfL * 2.0f;
 
-    float yardFullW = fenceHalfW * 2.0f;
-    float yardFullL = fenceHalfL * 2.0f;
+    L.yardW = L.yardFullW;
+    L.yardL = L.yardFullL;
 
-    float yardW = yardFullW;
-    float yardL = yardFullL;
+    L.fenceLeftX = center.x - L.fenceLenX * 0.5f;
+    L.fenceRightX = center.x + L.fenceLenX * 0.5f;
 
-    float fenceLeftX = center.x - fenceLenX * 0.5f;
-    float fenceRightX = center.x + fenceLenX * 0.5f;
+    L.gateCenterX = center.x + gateOffsetX;
+    L.gateLeftX = L.gateCenterX - L.gateW * 0.5f;
+    L.gateRightX = L.gateCenterX + L.gateW * 0.5f;
 
-    float gateCenterX = center.x + gateOffsetX;
-    float gateLeftX = gateCenterX - gateW * 0.5f;
-    float gateRightX = gateCenterX + gateW * 0.5f;
+    L.leftLen = L.gateLeftX - L.fenceLeftX;
+    L.rightLen = L.fenceRightX - L.gateRightX;
 
-    float leftLen = gateLeftX - fenceLeftX;
-    float rightLen = fenceRightX - gateRightX;
+    L.leftCenterX = L.fenceLeftX + L.leftLen * 0.5f;
+    L.rightCenterX = L.gateRightX + L.rightLen * 0.5f;
 
-    float leftCenterX = fenceLeftX + leftLen * 0.5f;
-    float rightCenterX = gateRightX + rightLen * 0.5f;
+    L.frontFenceCenterZ = center.z + fenceHalfL;
+    L.frontFenceOuterZ = L.frontFenceCenterZ + L.fenceThk * 0.5f;
 
-    float frontFenceCenterZ = center.z + fenceHalfL;
-    float frontFenceOuterZ = frontFenceCenterZ + fenceThk * 0.5f;
+    L.roadW = L.gateW + 1.6f;
+    L.roadL = 92.0f;
+    L.roadCenterZ = L.frontFenceOuterZ + L.roadL * 0.5f;
 
-    float roadW = gateW + 1.6f;
-    float roadL = 92.0f;
-    float roadCenterZ = frontFenceOuterZ + roadL * 0.5f;
+    float HOUSE_SCALE = L.houseScale = style.houseScale;
+    glm::vec3 Hc = L.houseCenter = center + glm::vec3(-L.yardW * 0.02f, 0.0f, 0.0f);
+    L.slabY = overlayY + WC::YARD_THK;
+    L.slabH = 0.60f * HOUSE_SCALE;
 
-    std::vector<RenderItem> items;
+    float W1 = L.W1 = 19.0f * HOUSE_SCALE;
+    float D1 = L.D1 = 13.6f * HOUSE_SCALE;
+    L.H1 = 4.4f * HOUSE_SCALE * 1.22f;
 
-    auto AddBottom = [&](glm::vec3 pos, glm::vec3 euler, glm::vec3 scl, glm::vec3 col) {
-        items.push_back({ MakeModel_BottomPivot(pos, euler, scl), col });
-        };
-    auto AddCenter = [&](glm::vec3 pos, glm::vec3 euler, glm::vec3 scl, glm::vec3 col) {
-        items.push_back({ MakeModel_CenterPivot(pos, euler, scl), col });
-        };
-    auto AddBox = [&](glm::vec3 pos, glm::vec3 euler, glm::vec3 scl, glm::vec3 col, bool bottomPivot) {
-        if (bottomPivot) items.push_back({ MakeModel_BottomPivot(pos, euler, scl), col });
-        else items.push_back({ MakeModel_CenterPivot(pos, euler, scl), col });
-        };
+    L.f1Y = L.slabY + L.slabH;
+    L.winFrontZ = Hc.z + D1 * 0.5f + 0.04f * HOUSE_SCALE;
+    L.midEaveY = L.f1Y + L.H1 + 0.02f * HOUSE_SCALE;
+
+    L.carportCenter = Hc + glm::vec3(W1 * 0.60f + 4.8f * HOUSE_SCALE, 0.0f, D1 * 0.18f);
+    L.carportW = 8.4f * HOUSE_SCALE;
+    L.carportD = 10.2f * HOUSE_SCALE;
+    L.carportOver = 0.75f * HOUSE_SCALE;
+
+    const glm::vec3& leafA = L.leaf[0];
+    const glm::vec3& leafB = L.leaf[1];
+    const glm::vec3& leafC = L.leaf[2];
+
+    float outZ1 = center.z + fenceHalfL + 16.0f;
+    float outZ2 = center.z + fenceHalfL + 30.0f;
+
+    float outXR = center.x + fenceHalfW + 15.0f;
+    float outXL = center.x - fenceHalfW - 15.0f;
+
+    L.pines = {
+        { glm::vec3(outXR, overlayY, outZ1), 5.6f, 0.85f, leafA },
+        { glm::vec3(outXR + 5.5f, overlayY, outZ2), 6.3f, 0.92f, leafB },
+        { glm::vec3(outXR - 6.8f, overlayY, outZ2 + 4.2f), 6.0f, 0.88f, leafC },
+
+        { glm::vec3(outXL, overlayY, outZ1 + 2.4f), 6.0f, 0.90f, leafB },
+        { glm::vec3(outXL - 5.8f, overlayY, outZ2 + 1.8f), 6.8f, 0.98f, leafA },
+
+        { glm::vec3(center.x - fenceHalfW - 18.0f, overlayY, center.z - 10.0f), 6.4f, 0.95f, leafC },
+        { glm::vec3(center.x - fenceHalfW - 24.0f, overlayY, center.z + 12.0f), 7.2f, 1.05f, leafB },
+        { glm::vec3(center.x + fenceHalfW + 20.0f, overlayY, center.z - 18.0f), 6.8f, 1.00f, leafA },
+        { glm::vec3(center.x + fenceHalfW + 28.0f, overlayY, center.z + 6.0f), 7.6f, 1.08f, leafC },
+    };
+
+    float lampOffsetX = L.roadW * 0.5f + 4.2f;
+    float lampStartZ = L.frontFenceOuterZ + 7.0f;
+    float lampEndZ = L.frontFenceOuterZ + L.roadL - 5.0f;
+    float lampStep = 12.0f;
+
+    for (float z0 = lampStartZ; z0 <= lampEndZ; z0 += lampStep) {
+        L.streetLights.push_back({ glm::vec3(L.gateCenterX - lampOffsetX, overlayY, z0), 10.6f, 0.36f });
+        L.streetLights.push_back({ glm::vec3(L.gateCenterX + lampOffsetX, overlayY, z0), 10.6f, 0.36f });
+    }
+
+    float poleH = 9.6f;
+    float poleW = 0.34f;
+    float outPad = 6.0f;
+
+    float outLeftX = center.x - fenceHalfW - outPad;
+    float outRightX = center.x + fenceHalfW + outPad;
+    float outBackZ = center.z - fenceHalfL - outPad;
 
-    AddBottom(glm::vec3(0.0f, groundY, 0.0f), glm::vec3(0.0f),
-        glm::vec3(WC::GROUND_SIZE, WC::GROUND_THK, WC::GROUND_SIZE),
-        WC::COL_GRASS);
+    L.streetLights.push_back({ glm::vec3(outLeftX, overlayY, Hc.z + D1 * 0.10f), poleH, poleW });
+    L.streetLights.push_back({ glm::vec3(outLeftX, overlayY, Hc.z - D1 * 0.18f), poleH, poleW });
+    L.streetLights.push_back({ glm::vec3(outRightX, overlayY, Hc.z + D1 * 0.08f), poleH, poleW });
+    L.streetLights.push_back({ glm::vec3(outRightX, overlayY, Hc.z - D1 * 0.20f), poleH, poleW });
+    L.streetLights.push_back({ glm::vec3(Hc.x - W1 * 0.18f, overlayY, outBackZ), poleH, poleW });
+    L.streetLights.push_back({ glm::vec3(Hc.x + W1 * 0.18f, overlayY, outBackZ), poleH, poleW });
+
+    return L;
+}
+
+// Unit pine (trunk 1 x 1 x 1 at the origin), one per leaf color; instances
+// scale it by trunk width, height, width.
+uint32_t PinePrefab(glm::vec3 leafColor) {
+    return DefinePrefab({ PREFAB_PINE, { leafColor.x, leafColor.y, leafColor.z } }, [&] {
+        AddBottom(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f), glm::vec3(0.35f, 0.22f, 0.12f), MESH_CYLINDER);
+        AddBottom(glm::vec3(0.0f, 0.55f, 0.0f), glm::vec3(0.0f), glm::vec3(6.2f, 0.55f, 6.2f), leafColor, MESH_CONE);
+        AddBottom(glm::vec3(0.0f, 0.85f, 0.0f), glm::vec3(0.0f), glm::vec3(4.4f, 0.50f, 4.4f), leafColor * 0.95f, MESH_CONE);
+        AddBottom(glm::vec3(0.0f, 1.12f, 0.0f), glm::vec3(0.0f), glm::vec3(2.8f, 0.46f, 2.8f), leafColor * 0.90f, MESH_CONE);
+        });
+}
+
+void AddPine(glm::vec3 base, float trunkH, float trunkW, glm::vec3 leafColor) {
+    WindScope sway(WC::WIND_STIFFNESS_PINE, base.y);
+    AddPrefabInstance(PinePrefab(leafColor), MakeModel_TRS(base, glm::vec3(0.0f), glm::vec3(trunkW, trunkH, trunkW)));
+}
+
+// A flower of average stem height, for the GPU scatter; the builders' own
+// flowers are loose boxes with a stem each.
+uint32_t FlowerPrefab(glm::vec3 petalColor) {
+    return DefinePrefab({ PREFAB_FLOWER, { petalColor.x, petalColor.y, petalColor.z } }, [&] {
+        const float stemH = 0.63f, stemW = 0.11f;
+        AddBottom(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(stemW, stemH, stemW), WC::COL_FLOWER_STEM);
+        AddCenter(glm::vec3(0.0f, stemH + 0.10f, 0.0f), glm::vec3(0.0f), glm::vec3(0.46f, 0.20f, 0.46f), petalColor);
+        });
+}
+
+// Lamp post in local space, base at the origin.
+void EmitStreetLight(float poleH, float poleW) {
+    glm::vec3 poleCol(0.35f, 0.35f, 0.38f);
+    glm::vec3 lampCol(0.98f, 0.95f, 0.70f);
+    glm::vec3 base(0.0f);
+
+    float lampScale = 1.85f;
+
+    AddBottom(base, glm::vec3(0.0f),
+        glm::vec3(poleW * 3.6f, poleW * 0.70f, poleW * 3.6f), poleCol * 0.90f);
+
+    AddBottom(base + glm::vec3(0.0f, poleW * 0.70f, 0.0f), glm::vec3(0.0f),
+        glm::vec3(poleW, poleH, poleW), poleCol);
+
+    float topY = base.y + poleW * 0.70f + poleH;
+    AddBottom(glm::vec3(base.x, topY, base.z), glm::vec3(0.0f),
+        glm::vec3(poleW * 2.6f, poleW * 0.22f, poleW * 2.6f), poleCol);
+
+    float armL = poleW * 4.2f;
+    AddCenter(glm::vec3(base.x + armL * 0.5f, topY - poleW * 0.28f, base.z), glm::vec3(0.0f),
+        glm::vec3(armL, poleW * 0.22f, poleW * 0.22f), poleCol);
+
+    AddCenter(glm::vec3(base.x + armL, topY - poleW * 0.62f, base.z), glm::vec3(0.0f),
+        glm::vec3(poleW * 0.95f * lampScale, poleW * 0.52f * lampScale, poleW * 1.35f * lampScale), lampCol);
+}
+
+void AddStreetLight(glm::vec3 base, float poleH, float poleW) {
+    uint32_t prefab = DefinePrefab({ PREFAB_STREET_LIGHT, { poleH, poleW } }, [&] {
+        EmitStreetLight(poleH, poleW);
+        });
+    AddPrefabInstance(prefab, MakeModel_TRS(base, glm::vec3(0.0f), glm::vec3(1.0f)));
+}
+
+float AddDeckSkirtRoof(glm::vec3 centerXZ, float eaveY,
+    float deckW, float deckD,
+    float outerW, float outerD,
+    float pitchRad,
+    float panelThk, float deckThk,
+    glm::vec3 roofCol, glm::vec3 deckCol)
+{
+    float innerHalfW = deckW * 0.5f;
+    float innerHalfD = deckD * 0.5f;
+    float outerHalfW = outerW * 0.5f;
+    float outerHalfD = outerD * 0.5f;
+
+    float spanX = std::max(0.01f, outerHalfW - innerHalfW);
+    float spanZ = std::max(0.01f, outerHalfD - innerHalfD);
+
+    float drop = std::max(spanX, spanZ) * std::sin(pitchRad);
+    float innerEdgeY = eaveY + drop;
+    float deckTopY = innerEdgeY + 0.01f;
+
+    AddBox(glm::vec3(centerXZ.x, deckTopY - deckThk, centerXZ.z), glm::vec3(0.0f),
+        glm::vec3(deckW, deckThk, deckD), deckCol, true);
+
+    // The ring's mid-thickness runs from eaveY at the outer edge to
+    // innerEdgeY at the deck.
+    MeshBuilder roof;
+    BuildSkirtRoofMesh(roof, centerXZ, glm::vec2(outerHalfW, outerHalfD), glm::vec2(innerHalfW, innerHalfD),
+        eaveY + panelThk * 0.5f, innerEdgeY + panelThk * 0.5f, panelThk);
+    AddMeshItem(roof, roofCol);
+
+    return deckTopY;
+}
+
+// Gable roofs: the underside rises halfSpan * sin(pitch) from the eaves to the
+// ridge, which is where the gable-end fills below them stop. Return the ridge top.
+float AddGableRoof_EaveZ(const glm::vec3& centerXZ, float footprintW, float footprintD, float eaveY,
+    float pitchRad, float thk, float overhang, const glm::vec3& roofCol)
+{
+    float halfSpan = footprintD * 0.5f + overhang;
+    float halfLen = footprintW * 0.5f + overhang;
+
+    MeshBuilder roof;
+    float topY = BuildGableRoofMesh(roof, centerXZ, true, halfSpan, halfLen, eaveY, halfSpan * std::sin(pitchRad), thk);
+    AddMeshItem(roof, roofCol);
+    return topY;
+}
+
+float AddGableRoof_EaveX(const glm::vec3& centerXZ, float footprintW, float footprintD, float eaveY,
+    float pitchRad, float thk, float overhang, const glm::vec3& roofCol)
+{
+    float halfSpan = footprintW * 0.5f + overhang;
+    float halfLen = footprintD * 0.5f + overhang;
+
+    MeshBuilder roof;
+    float topY = BuildGableRoofMesh(roof, centerXZ, false, halfSpan, halfLen, eaveY, halfSpan * std::sin(pitchRad), thk);
+    AddMeshItem(roof, roofCol);
+    return topY;
+}
+
+void BuildYard(const LotLayout& L) {
+    float overlayY = L.overlayY;
+    glm::vec3 center = L.center;
+    float fenceThk = L.fenceThk;
+    float fenceHalfW = L.fenceHalfW;
+    float fenceHalfL = L.fenceHalfL;
+    float fenceLenX = L.fenceLenX;
+    float fenceLenZ = L.fenceLenZ;
+    float fenceH = L.fenceH;
+    float pillarW = L.pillarW;
+    float pillarH = L.pillarH;
+    float hedgeHh = L.hedgeHh;
+    float hedgeY = L.hedgeY;
+    float hedgeThk2 = L.hedgeThk2;
+    float yardFullW = L.yardFullW;
+    float yardFullL = L.yardFullL;
+    float fenceLeftX = L.fenceLeftX;
+    float fenceRightX = L.fenceRightX;
+    float gateCenterX = L.gateCenterX;
+    float gateLeftX = L.gateLeftX;
+    float gateRightX = L.gateRightX;
+    float leftLen = L.leftLen;
+    float rightLen = L.rightLen;
+    float leftCenterX = L.leftCenterX;
+    float rightCenterX = L.rightCenterX;
+    float frontFenceOuterZ = L.frontFenceOuterZ;
+    float roadW = L.roadW;
+    float roadL = L.roadL;
+    float roadCenterZ = L.roadCenterZ;
+
+    glm::vec3 wallColor(0.92f, 0.85f, 0.55f);
+    glm::vec3 capColor(0.86f, 0.79f, 0.50f);
+    glm::vec3 hedgeColor(0.12f, 0.45f, 0.15f);
 
     AddBottom(glm::vec3(center.x, overlayY, center.z), glm::vec3(0.0f),
         glm::vec3(yardFullW, WC::YARD_THK, yardFullL),
@@ -459,6 +1711,7 @@ int main() {
         AddBottom(glm::vec3(cx, overlayY + fenceH, cz), glm::vec3(0.0f),
             glm::vec3(len, capHh2, capThk2), capColor);
         if (addHedge) {
+            WindScope sway(WC::WIND_STIFFNESS_HEDGE, hedgeY);
             AddBottom(glm::vec3(cx, hedgeY, cz), glm::vec3(0.0f),
                 glm::vec3(len * 0.72f, hedgeHh, hedgeThk2), hedgeColor);
         }
@@ -471,6 +1724,7 @@ int main() {
         AddBottom(glm::vec3(cx, overlayY + fenceH, cz), glm::vec3(0.0f),
             glm::vec3(capThk2, capHh2, len), capColor);
         if (addHedge) {
+            WindScope sway(WC::WIND_STIFFNESS_HEDGE, hedgeY);
             AddBottom(glm::vec3(cx, hedgeY, cz), glm::vec3(0.0f),
                 glm::vec3(hedgeThk2, hedgeHh, len * 0.72f), hedgeColor);
         }
@@ -488,6 +1742,7 @@ int main() {
     float hedgeLenL = std::max(0.0f, leftLen - hedgeGapFromGate);
     if (hedgeLenL > 1.0f) {
         float hx = fenceLeftX + hedgeLenL * 0.5f;
+        WindScope sway(WC::WIND_STIFFNESS_HEDGE, hedgeY);
         AddBottom(glm::vec3(hx, hedgeY, center.z + fenceHalfL), glm::vec3(0.0f),
             glm::vec3(hedgeLenL * 0.92f, hedgeHh, hedgeThk2), hedgeColor);
     }
@@ -495,6 +1750,7 @@ int main() {
     float hedgeLenR = std::max(0.0f, rightLen - hedgeGapFromGate);
     if (hedgeLenR > 1.0f) {
         float hx = fenceRightX - hedgeLenR * 0.5f;
+        WindScope sway(WC::WIND_STIFFNESS_HEDGE, hedgeY);
         AddBottom(glm::vec3(hx, hedgeY, center.z + fenceHalfL), glm::vec3(0.0f),
             glm::vec3(hedgeLenR * 0.92f, hedgeHh, hedgeThk2), hedgeColor);
     }
@@ -513,155 +1769,87 @@ int main() {
         glm::vec3 slotCol(0.10f, 0.10f, 0.10f);
         glm::vec3 flagCol(0.95f, 0.25f, 0.20f);
 
-
         const float MB_SCALE = 2.2f;
 
         float mbX = gateRightX + 1.35f + 1.10f * (MB_SCALE - 1.0f);
         float mbZ = frontFenceOuterZ + 1.00f + 0.80f * (MB_SCALE - 1.0f);
         float mbY = overlayY;
 
+        uint32_t mailbox = DefinePrefab({ PREFAB_MAILBOX, { MB_SCALE } }, [&] {
+            AddBottom(glm::vec3(0.0f), glm::vec3(0.0f),
+                glm::vec3(0.90f * MB_SCALE, 0.12f * MB_SCALE, 0.90f * MB_SCALE), postCol * 0.85f);
 
-        AddBottom(glm::vec3(mbX, mbY, mbZ), glm::vec3(0.0f),
-            glm::vec3(0.90f * MB_SCALE, 0.12f * MB_SCALE, 0.90f * MB_SCALE), postCol * 0.85f);
-
+            AddBottom(glm::vec3(0.0f, 0.12f * MB_SCALE, 0.0f), glm::vec3(0.0f),
+                glm::vec3(0.18f * MB_SCALE, 1.25f * MB_SCALE, 0.18f * MB_SCALE), postCol);
 
-        AddBottom(glm::vec3(mbX, mbY + 0.12f * MB_SCALE, mbZ), glm::vec3(0.0f),
-            glm::vec3(0.18f * MB_SCALE, 1.25f * MB_SCALE, 0.18f * MB_SCALE), postCol);
+            float boxY = 0.12f * MB_SCALE + 1.25f * MB_SCALE;
+            AddBottom(glm::vec3(0.0f, boxY, 0.0f), glm::vec3(0.0f),
+                glm::vec3(0.92f * MB_SCALE, 0.52f * MB_SCALE, 0.52f * MB_SCALE), boxCol);
 
+            AddCenter(glm::vec3(0.0f, boxY + 0.32f * MB_SCALE, 0.29f * MB_SCALE), glm::vec3(0.0f),
+                glm::vec3(0.60f * MB_SCALE, 0.10f * MB_SCALE, 0.05f * MB_SCALE), slotCol);
 
-
-
-        float boxY = mbY + 0.12f * MB_SCALE + 1.25f * MB_SCALE;
-        AddBottom(glm::vec3(mbX, boxY, mbZ), glm::vec3(0.0f),
-            glm::vec3(0.92f * MB_SCALE, 0.52f * MB_SCALE, 0.52f * MB_SCALE), boxCol);
-
-
-
-        AddCenter(glm::vec3(mbX, boxY + 0.32f * MB_SCALE, mbZ + 0.29f * MB_SCALE), glm::vec3(0.0f),
-            glm::vec3(0.60f * MB_SCALE, 0.10f * MB_SCALE, 0.05f * MB_SCALE), slotCol);
-
-
-        AddCenter(glm::vec3(mbX + 0.52f * MB_SCALE, boxY + 0.34f * MB_SCALE, mbZ), glm::vec3(0.0f),
-            glm::vec3(0.12f * MB_SCALE, 0.40f * MB_SCALE, 0.08f * MB_SCALE), flagCol);
+            AddCenter(glm::vec3(0.52f * MB_SCALE, boxY + 0.34f * MB_SCALE, 0.0f), glm::vec3(0.0f),
+                glm::vec3(0.12f * MB_SCALE, 0.40f * MB_SCALE, 0.08f * MB_SCALE), flagCol);
+            });
+        glm::mat4 mailboxAt = MakeModel_TRS(glm::vec3(mbX, mbY, mbZ), glm::vec3(0.0f), glm::vec3(1.0f));
+        NodeScope post(mailboxAt);
+        AddPrefabInstance(mailbox, mailboxAt);
     }
 
     AddBottom(glm::vec3(gateCenterX, overlayY, roadCenterZ), glm::vec3(0.0f),
         glm::vec3(roadW, WC::DRIVE_THK, roadL),
         glm::vec3(0.45f, 0.45f, 0.45f));
+}
 
-    auto AddPine = [&](glm::vec3 base, float trunkH, float trunkW, glm::vec3 leafColor) {
-        base.y = overlayY;
-
-        AddBottom(base, glm::vec3(0.0f),
-            glm::vec3(trunkW, trunkH, trunkW),
-            glm::vec3(0.35f, 0.22f, 0.12f));
-
-        float y1 = trunkH * 0.65f;
-        float y2 = trunkH * 0.95f;
-        float y3 = trunkH * 1.20f;
-
-        AddBottom(base + glm::vec3(0.0f, y1, 0.0f), glm::vec3(0.0f),
-            glm::vec3(trunkW * 6.2f, trunkH * 0.35f, trunkW * 6.2f),
-            leafColor);
-
-        AddBottom(base + glm::vec3(0.0f, y2, 0.0f), glm::vec3(0.0f),
-            glm::vec3(trunkW * 4.4f, trunkH * 0.30f, trunkW * 4.4f),
-            leafColor * 0.95f);
-
-        AddBottom(base + glm::vec3(0.0f, y3, 0.0f), glm::vec3(0.0f),
-            glm::vec3(trunkW * 2.8f, trunkH * 0.28f, trunkW * 2.8f),
-            leafColor * 0.90f);
-        };
-
-    glm::vec3 leafA(0.18f, 0.45f, 0.22f);
-    glm::vec3 leafB(0.15f, 0.38f, 0.20f);
-    glm::vec3 leafC(0.20f, 0.52f, 0.25f);
-
-    float outZ1 = center.z + fenceHalfL + 16.0f;
-    float outZ2 = center.z + fenceHalfL + 30.0f;
-
-    float outXR = center.x + fenceHalfW + 15.0f;
-    float outXL = center.x - fenceHalfW - 15.0f;
-
-    AddPine(glm::vec3(outXR, overlayY, outZ1), 5.6f, 0.85f, leafA);
-    AddPine(glm::vec3(outXR + 5.5f, overlayY, outZ2), 6.3f, 0.92f, leafB);
-    AddPine(glm::vec3(outXR - 6.8f, overlayY, outZ2 + 4.2f), 6.0f, 0.88f, leafC);
-
-    AddPine(glm::vec3(outXL, overlayY, outZ1 + 2.4f), 6.0f, 0.90f, leafB);
-    AddPine(glm::vec3(outXL - 5.8f, overlayY, outZ2 + 1.8f), 6.8f, 0.98f, leafA);
-
-    auto AddStreetLight = [&](glm::vec3 base, float poleH, float poleW) {
-        glm::vec3 poleCol(0.35f, 0.35f, 0.38f);
-        glm::vec3 lampCol(0.98f, 0.95f, 0.70f);
-        base.y = overlayY;
-
-        float lampScale = 1.85f;
-
-        AddBottom(base, glm::vec3(0.0f),
-            glm::vec3(poleW * 3.6f, poleW * 0.70f, poleW * 3.6f), poleCol * 0.90f);
-
-        AddBottom(base + glm::vec3(0.0f, poleW * 0.70f, 0.0f), glm::vec3(0.0f),
-            glm::vec3(poleW, poleH, poleW), poleCol);
-
-        float topY = base.y + poleW * 0.70f + poleH;
-        AddBottom(glm::vec3(base.x, topY, base.z), glm::vec3(0.0f),
-            glm::vec3(poleW * 2.6f, poleW * 0.22f, poleW * 2.6f), poleCol);
-
-        float armL = poleW * 4.2f;
-        AddCenter(glm::vec3(base.x + armL * 0.5f, topY - poleW * 0.28f, base.z), glm::vec3(0.0f),
-            glm::vec3(armL, poleW * 0.22f, poleW * 0.22f), poleCol);
-
-        AddCenter(glm::vec3(base.x + armL, topY - poleW * 0.62f, base.z), glm::vec3(0.0f),
-            glm::vec3(poleW * 0.95f * lampScale, poleW * 0.52f * lampScale, poleW * 1.35f * lampScale), lampCol);
-        };
-
-    float lampOffsetX = roadW * 0.5f + 4.2f;
-    float lampStartZ = frontFenceOuterZ + 7.0f;
-    float lampEndZ = frontFenceOuterZ + roadL - 5.0f;
-    float lampStep = 12.0f;
-
-    for (float z0 = lampStartZ; z0 <= lampEndZ; z0 += lampStep) {
-        AddStreetLight(glm::vec3(gateCenterX - lampOffsetX, overlayY, z0), 10.6f, 0.36f);
-        AddStreetLight(glm::vec3(gateCenterX + lampOffsetX, overlayY, z0), 10.6f, 0.36f);
-    }
-
-    AddPine(glm::vec3(center.x - fenceHalfW - 18.0f, overlayY, center.z - 10.0f), 6.4f, 0.95f, leafC);
-    AddPine(glm::vec3(center.x - fenceHalfW - 24.0f, overlayY, center.z + 12.0f), 7.2f, 1.05f, leafB);
-    AddPine(glm::vec3(center.x + fenceHalfW + 20.0f, overlayY, center.z - 18.0f), 6.8f, 1.00f, leafA);
-    AddPine(glm::vec3(center.x + fenceHalfW + 28.0f, overlayY, center.z + 6.0f), 7.6f, 1.08f, leafC);
-
-    for (int i = 0; i < 8; ++i) {
-        float ringX = fenceHalfW + 22.0f + (float)(rand() % 25);
-        float ringZ = fenceHalfL + 18.0f + (float)(rand() % 30);
-        float sx = (rand() % 2 ? 1.0f : -1.0f) * ringX + center.x;
-        float sz = (rand() % 2 ? 1.0f : -1.0f) * ringZ + center.z;
-        float h = 5.8f + (float)(rand() % 20) / 10.0f;
-        float w = 0.82f + (float)(rand() % 18) / 100.0f;
-        glm::vec3 lc = (rand() % 3 == 0) ? leafA : ((rand() % 2) ? leafB : leafC);
-        AddPine(glm::vec3(sx, overlayY, sz), h, w, lc);
-    }
-
-    glm::vec3 colBase(0.55f, 0.45f, 0.35f);
-    glm::vec3 colWall(0.86f, 0.82f, 0.72f);
-    glm::vec3 colTrim(0.93f, 0.93f, 0.93f);
-    glm::vec3 colDoor(0.30f, 0.18f, 0.10f);
-    glm::vec3 colWindow(0.65f, 0.80f, 0.95f);
-    glm::vec3 colRoof(0.70f, 0.20f, 0.20f);
-    glm::vec3 colWood(0.78f, 0.72f, 0.62f);
-    glm::vec3 colChim(0.35f, 0.22f, 0.16f);
-    glm::vec3 colRail(0.85f, 0.85f, 0.85f);
+void BuildStreetLights(const LotLayout& L) {
+    for (const StreetLightSpot& s : L.streetLights) {
+        glm::vec3 base(s.base.x, LotGroundY(L, s.base.x, s.base.z, s.poleW * 1.8f), s.base.z);
+        AddStreetLight(base, s.poleH, s.poleW);
+    }
+}
 
-    auto AddRectWindowZ = [&](float cx, float by, float cz, float w, float h, float s, float zSign) {
+void BuildHouse(const LotLayout& L) {
+    glm::vec3 center = L.center;
+    float fenceThk = L.fenceThk;
+    float fenceHalfW = L.fenceHalfW;
+    float fenceHalfL = L.fenceHalfL;
+    float HOUSE_SCALE = L.houseScale;
+    glm::vec3 Hc = L.houseCenter;
+    float slabY = L.slabY;
+    float slabH = L.slabH;
+    float W1 = L.W1;
+    float D1 = L.D1;
+    float H1 = L.H1;
+    float f1Y = L.f1Y;
+    float winFrontZ = L.winFrontZ;
+    float midEaveY = L.midEaveY;
+    glm::vec3 colBase = L.style.palette.base;
+    glm::vec3 colWall = L.style.palette.wall;
+    glm::vec3 colTrim = L.style.palette.trim;
+    glm::vec3 colDoor = L.style.palette.door;
+    glm::vec3 colWindow = L.style.palette.window;
+    glm::vec3 colRoof = L.style.palette.roof;
+    glm::vec3 colWood = L.style.palette.wood;
+    glm::vec3 colChim = L.style.palette.chimney;
+    glm::vec3 colRail = L.style.palette.rail;
+    LodGroupScope house;
+
+    // Window prefabs face +Z with the bottom-center of the glass at the origin;
+    // placing one only picks the wall point and the facing axis. They take
+    // colTrim and colWindow, so the palette is part of their key.
+    const float paletteKey = (float)L.style.paletteId;
+    auto EmitRectWindow = [&](float w, float h, float s) {
         float glassT = 0.06f * s;
         float frameT = 0.05f * s;
         float inset = 0.14f * s;
         float barT = 0.045f * s;
 
-        float zGlass = cz + 0.022f * s * zSign;
-        float zFrame = cz + 0.030f * s * zSign;
-        float zBar = cz + 0.032f * s * zSign;
+        float zGlass = 0.022f * s;
+        float zFrame = 0.030f * s;
+        float zBar = 0.032f * s;
 
-        AddBox(glm::vec3(cx, by, zGlass), glm::vec3(0.0f),
+        AddBox(glm::vec3(0.0f, 0.0f, zGlass), glm::vec3(0.0f),
             glm::vec3(w, h, glassT), colWindow, true);
 
         float fw = std::min(inset, w * 0.22f);
@@ -669,35 +1857,35 @@ int main() {
         float innerW = std::max(0.01f, w - 2.0f * fw);
         float innerH = std::max(0.01f, h - 2.0f * fh);
 
-        AddBox(glm::vec3(cx, by + h - fh, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3(0.0f, h - fh, zFrame), glm::vec3(0.0f),
             glm::vec3(w, fh, frameT), colTrim, true);
-        AddBox(glm::vec3(cx, by, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3(0.0f, 0.0f, zFrame), glm::vec3(0.0f),
             glm::vec3(w, fh, frameT), colTrim, true);
-        AddBox(glm::vec3(cx - (w * 0.5f) + fw, by, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3(-(w * 0.5f) + fw, 0.0f, zFrame), glm::vec3(0.0f),
             glm::vec3(fw, h, frameT), colTrim, true);
-        AddBox(glm::vec3(cx + (w * 0.5f) - fw, by, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3((w * 0.5f) - fw, 0.0f, zFrame), glm::vec3(0.0f),
             glm::vec3(fw, h, frameT), colTrim, true);
 
-        float midY = by + fh + innerH * 0.5f - (barT * 0.5f);
-        AddBox(glm::vec3(cx, midY, zBar), glm::vec3(0.0f),
+        float midY = fh + innerH * 0.5f - (barT * 0.5f);
+        AddBox(glm::vec3(0.0f, midY, zBar), glm::vec3(0.0f),
             glm::vec3(innerW, barT, frameT), colTrim, true);
 
-        AddBox(glm::vec3(cx, by + fh, zBar), glm::vec3(0.0f),
+        AddBox(glm::vec3(0.0f, fh, zBar), glm::vec3(0.0f),
             glm::vec3(barT, innerH, frameT), colTrim, true);
         };
 
-    auto AddWideWindow3Z = [&](float cx, float by, float cz, float w, float h, float s, float zSign) {
+    auto EmitWideWindow3 = [&](float w, float h, float s) {
         float glassT = 0.06f * s;
         float frameT = 0.05f * s;
         float inset = 0.14f * s;
         float mullT = 0.05f * s;
         float barT = 0.045f * s;
 
-        float zGlass = cz + 0.022f * s * zSign;
-        float zFrame = cz + 0.030f * s * zSign;
-        float zBar = cz + 0.032f * s * zSign;
+        float zGlass = 0.022f * s;
+        float zFrame = 0.030f * s;
+        float zBar = 0.032f * s;
 
-        AddBox(glm::vec3(cx, by, zGlass), glm::vec3(0.0f),
+        AddBox(glm::vec3(0.0f, 0.0f, zGlass), glm::vec3(0.0f),
             glm::vec3(w, h, glassT), colWindow, true);
 
         float fw = std::min(inset, w * 0.18f);
@@ -705,1212 +1893,3242 @@ int main() {
         float innerW = std::max(0.01f, w - 2.0f * fw);
         float innerH = std::max(0.01f, h - 2.0f * fh);
 
-        AddBox(glm::vec3(cx, by + h - fh, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3(0.0f, h - fh, zFrame), glm::vec3(0.0f),
             glm::vec3(w, fh, frameT), colTrim, true);
-        AddBox(glm::vec3(cx, by, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3(0.0f, 0.0f, zFrame), glm::vec3(0.0f),
             glm::vec3(w, fh, frameT), colTrim, true);
-        AddBox(glm::vec3(cx - (w * 0.5f) + fw, by, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3(-(w * 0.5f) + fw, 0.0f, zFrame), glm::vec3(0.0f),
             glm::vec3(fw, h, frameT), colTrim, true);
-        AddBox(glm::vec3(cx + (w * 0.5f) - fw, by, zFrame), glm::vec3(0.0f),
+        AddBox(glm::vec3((w * 0.5f) - fw, 0.0f, zFrame), glm::vec3(0.0f),
             glm::vec3(fw, h, frameT), colTrim, true);
 
-        float mullX1 = cx - innerW * (1.0f / 3.0f) * 0.5f;
-        float mullX2 = cx + innerW * (1.0f / 3.0f) * 0.5f;
+        float mullX = innerW * (1.0f / 3.0f) * 0.5f;
 
-        AddBox(glm::vec3(mullX1, by + fh, zBar), glm::vec3(0.0f),
+        AddBox(glm::vec3(-mullX, fh, zBar), glm::vec3(0.0f),
             glm::vec3(mullT, innerH, frameT), colTrim, true);
-        AddBox(glm::vec3(mullX2, by + fh, zBar), glm::vec3(0.0f),
+        AddBox(glm::vec3(mullX, fh, zBar), glm::vec3(0.0f),
             glm::vec3(mullT, innerH, frameT), colTrim, true);
 
-        float midY = by + fh + innerH * 0.5f - (barT * 0.5f);
-        AddBox(glm::vec3(cx, midY, zBar), glm::vec3(0.0f),
+        float midY = fh + innerH * 0.5f - (barT * 0.5f);
+        AddBox(glm::vec3(0.0f, midY, zBar), glm::vec3(0.0f),
             glm::vec3(innerW, barT, frameT), colTrim, true);
         };
 
+    auto AddRectWindowZ = [&](float cx, float by, float cz, float w, float h, float s, float zSign) {
+        uint32_t prefab = DefinePrefab({ PREFAB_WINDOW_RECT, { w, h, s, paletteKey } }, [&] { EmitRectWindow(w, h, s); });
+        AddPrefabInstance(prefab, FacingParent(glm::vec3(cx, by, cz), glm::vec3(0.0f, 0.0f, zSign)));
+        };
+
+    auto AddWideWindow3Z = [&](float cx, float by, float cz, float w, float h, float s, float zSign) {
+        uint32_t prefab = DefinePrefab({ PREFAB_WINDOW_WIDE3, { w, h, s, paletteKey } }, [&] { EmitWideWindow3(w, h, s); });
+        AddPrefabInstance(prefab, FacingParent(glm::vec3(cx, by, cz), glm::vec3(0.0f, 0.0f, zSign)));
+        };
+
     auto AddRectWindowX = [&](float xw, float by, float cz, float wZ, float h, float s, float xSign) {
-        float glassT = 0.06f * s;
-        float frameT = 0.05f * s;
-        float inset = 0.14f * s;
-        float barT = 0.045f * s;
+        uint32_t prefab = DefinePrefab({ PREFAB_WINDOW_RECT, { wZ, h, s, paletteKey } }, [&] { EmitRectWindow(wZ, h, s); });
+        AddPrefabInstance(prefab, FacingParent(glm::vec3(xw, by, cz), glm::vec3(xSign, 0.0f, 0.0f)));
+        };
 
-        float xGlass = xw + 0.022f * s * xSign;
-        float xFrame = xw + 0.030f * s * xSign;
-        float xBar = xw + 0.032f * s * xSign;
+    float W2 = 15.2f * HOUSE_SCALE;
+    float D2 = 11.0f * HOUSE_SCALE;
+    float H2 = 3.6f * HOUSE_SCALE * 1.18f;
 
-        AddBox(glm::vec3(xGlass, by, cz), glm::vec3(0.0f),
-            glm::vec3(glassT, h, wZ), colWindow, true);
+    AddBox(glm::vec3(Hc.x, slabY, Hc.z), glm::vec3(0.0f),
+        glm::vec3(W1 + 2.4f * HOUSE_SCALE, slabH, D1 + 2.2f * HOUSE_SCALE), colBase, true);
 
-        float fw = std::min(inset, wZ * 0.22f);
-        float fh = std::min(inset, h * 0.22f);
-        float innerW = std::max(0.01f, wZ - 2.0f * fw);
-        float innerH = std::max(0.01f, h - 2.0f * fh);
+    AddBox(glm::vec3(Hc.x, f1Y, Hc.z), glm::vec3(0.0f),
+        glm::vec3(W1, H1, D1), colWall, true);
 
-        AddBox(glm::vec3(xFrame, by + h - fh, cz), glm::vec3(0.0f),
-            glm::vec3(frameT, fh, wZ), colTrim, true);
-        AddBox(glm::vec3(xFrame, by, cz), glm::vec3(0.0f),
-            glm::vec3(frameT, fh, wZ), colTrim, true);
+    float frontZ1 = Hc.z + D1 * 0.5f;
+    float backZ1 = Hc.z - D1 * 0.5f;
 
-        AddBox(glm::vec3(xFrame, by, cz - (wZ * 0.5f) + fw), glm::vec3(0.0f),
-            glm::vec3(frameT, h, fw), colTrim, true);
-        AddBox(glm::vec3(xFrame, by, cz + (wZ * 0.5f) - fw), glm::vec3(0.0f),
-            glm::vec3(frameT, h, fw), colTrim, true);
+    glm::vec3 porch = Hc + glm::vec3(W1 * 0.22f, 0.0f, D1 * 0.5f - 2.6f * HOUSE_SCALE);
+    AddBox(glm::vec3(porch.x, f1Y, porch.z), glm::vec3(0.0f),
+        glm::vec3(7.6f * HOUSE_SCALE, 4.2f * HOUSE_SCALE, 4.2f * HOUSE_SCALE), colWood, true);
 
-        float midY = by + fh + innerH * 0.5f - (barT * 0.5f);
-        AddBox(glm::vec3(xBar, midY, cz), glm::vec3(0.0f),
-            glm::vec3(frameT, barT, innerW), colTrim, true);
+    float stepH = 0.28f * HOUSE_SCALE;
+    float stepD = 0.85f * HOUSE_SCALE;
+    float stepW = 3.6f * HOUSE_SCALE;
+    float stepStartZ = frontZ1 + 0.40f * HOUSE_SCALE;
 
-        AddBox(glm::vec3(xBar, by + fh, cz), glm::vec3(0.0f),
-            glm::vec3(frameT, innerH, barT), colTrim, true);
-        };
+    AddBox(glm::vec3(porch.x, slabY, stepStartZ), glm::vec3(0.0f),
+        glm::vec3(stepW, stepH, stepD), colBase, true);
+    AddBox(glm::vec3(porch.x, slabY + stepH, stepStartZ + stepD), glm::vec3(0.0f),
+        glm::vec3(stepW, stepH, stepD), colBase, true);
+    AddBox(glm::vec3(porch.x, slabY + stepH * 2.0f, stepStartZ + stepD * 2.0f), glm::vec3(0.0f),
+        glm::vec3(stepW, stepH, stepD), colBase, true);
 
-    auto AddDeckSkirtRoof = [&](glm::vec3 centerXZ, float eaveY,
-        float deckW, float deckD,
-        float outerW, float outerD,
-        float pitchRad,
-        float panelThk, float deckThk,
-        glm::vec3 roofCol, glm::vec3 deckCol) -> float
-        {
-            float innerHalfW = deckW * 0.5f;
-            float innerHalfD = deckD * 0.5f;
-            float outerHalfW = outerW * 0.5f;
-            float outerHalfD = outerD * 0.5f;
+    float doorW = 1.9f * HOUSE_SCALE;
+    float doorH = 4.2f * HOUSE_SCALE;
+    float doorT = 0.22f * HOUSE_SCALE;
 
-            float spanX = std::max(0.01f, outerHalfW - innerHalfW);
-            float spanZ = std::max(0.01f, outerHalfD - innerHalfD);
+    float doorZ = frontZ1 + 0.14f * HOUSE_SCALE;
+    AddBox(glm::vec3(porch.x, f1Y, doorZ), glm::vec3(0.0f),
+        glm::vec3(doorW, doorH, doorT), colDoor, true);
 
-            float drop = std::max(spanX, spanZ) * std::sin(pitchRad);
-            float innerEdgeY = eaveY + drop;
-            float deckTopY = innerEdgeY + 0.01f;
+    glm::vec3 knobCol(0.88f, 0.78f, 0.25f);
+    float knobS = 0.12f * HOUSE_SCALE;
+    AddBox(glm::vec3(porch.x + doorW * 0.33f, f1Y + doorH * 0.54f, doorZ + doorT * 0.60f),
+        glm::vec3(0.0f), glm::vec3(knobS, knobS, knobS), knobCol, false);
 
-            AddBox(glm::vec3(centerXZ.x, deckTopY - deckThk, centerXZ.z), glm::vec3(0.0f),
-                glm::vec3(deckW, deckThk, deckD), deckCol, true);
+    float winBackZ = backZ1 - 0.04f * HOUSE_SCALE;
 
-            float frontSpan = spanZ;
-            float sideSpan = spanX;
+    float winBaseY1 = f1Y + H1 * 0.55f - 1.05f * HOUSE_SCALE;
 
-            float frontZc = centerXZ.z + (innerHalfD + frontSpan * 0.5f);
-            float backZc = centerXZ.z - (innerHalfD + frontSpan * 0.5f);
-            float rightXc = centerXZ.x + (innerHalfW + sideSpan * 0.5f);
-            float leftXc = centerXZ.x - (innerHalfW + sideSpan * 0.5f);
+    AddWideWindow3Z(Hc.x - W1 * 0.22f, winBaseY1 + 0.12f * HOUSE_SCALE, winFrontZ,
+        7.2f * HOUSE_SCALE, 1.9f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
 
-            float cy2 = eaveY + drop * 0.5f;
+    AddRectWindowZ(Hc.x + W1 * 0.40f, winBaseY1 + 0.18f * HOUSE_SCALE, winFrontZ,
+        2.5f * HOUSE_SCALE, 2.1f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
 
-            AddBox(glm::vec3(centerXZ.x, cy2, frontZc), glm::vec3(+pitchRad, 0.0f, 0.0f),
-                glm::vec3(outerW, panelThk, frontSpan), roofCol, false);
-            AddBox(glm::vec3(centerXZ.x, cy2, backZc), glm::vec3(-pitchRad, 0.0f, 0.0f),
-                glm::vec3(outerW, panelThk, frontSpan), roofCol, false);
+    AddRectWindowZ(Hc.x - W1 * 0.30f, winBaseY1 + 0.14f * HOUSE_SCALE, winBackZ,
+        2.6f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
 
-            AddBox(glm::vec3(rightXc, cy2, centerXZ.z), glm::vec3(0.0f, 0.0f, -pitchRad),
-                glm::vec3(sideSpan, panelThk, outerD), roofCol, false);
-            AddBox(glm::vec3(leftXc, cy2, centerXZ.z), glm::vec3(0.0f, 0.0f, +pitchRad),
-                glm::vec3(sideSpan, panelThk, outerD), roofCol, false);
+    AddRectWindowZ(Hc.x + W1 * 0.32f, winBaseY1 + 0.12f * HOUSE_SCALE, winBackZ,
+        2.3f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
 
-            return deckTopY;
-        };
+    float sideX_R = Hc.x + W1 * 0.5f;
+    float sideX_L = Hc.x - W1 * 0.5f;
 
-    auto AddGableRoof_EaveZ = [&](const glm::vec3& centerXZ, float footprintW, float footprintD, float eaveY,
-        float pitchRad, float thk, float overhang, const glm::vec3& roofCol, const glm::vec3& ridgeCol) -> float
-        {
-            float halfSpan = footprintD * 0.5f + overhang;
-            float ridgeOverlap = std::max(0.10f, thk * 1.35f);
-            float slabLen = halfSpan + ridgeOverlap;
-            float slabW = footprintW + 2.0f * overhang;
+    AddRectWindowX(sideX_R, winBaseY1 + 0.12f * HOUSE_SCALE, Hc.z + D1 * 0.18f,
+        2.6f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
+    AddRectWindowX(sideX_R, winBaseY1 + 0.12f * HOUSE_SCALE, Hc.z - D1 * 0.22f,
+        2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
 
-            float ridgeRise = halfSpan * std::sin(pitchRad);
-            float ridgeY = eaveY + ridgeRise;
+    AddRectWindowX(sideX_L, winBaseY1 + 0.10f * HOUSE_SCALE, Hc.z - D1 * 0.10f,
+        2.4f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
+    AddRectWindowX(sideX_L, winBaseY1 + 0.10f * HOUSE_SCALE, Hc.z + D1 * 0.26f,
+        2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
 
-            float zFrontEave = centerXZ.z + halfSpan;
-            float zBackEave = centerXZ.z - halfSpan;
+    glm::vec3 roof2Center = Hc + glm::vec3(-0.4f * HOUSE_SCALE, 0.0f, -0.9f * HOUSE_SCALE);
 
-            auto T = [](float x, float y, float z) { return glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z)); };
-            auto S = [](float x, float y, float z) { return glm::scale(glm::mat4(1.0f), glm::vec3(x, y, z)); };
-            auto Rx = [](float a) { return glm::rotate(glm::mat4(1.0f), a, glm::vec3(1, 0, 0)); };
+    float outerW = W1 + 4.8f * HOUSE_SCALE;
+    float outerD = D1 + 4.6f * HOUSE_SCALE;
 
-            glm::mat4 front =
-                T(centerXZ.x, eaveY, zFrontEave) *
-                Rx(+pitchRad) *
-                T(0.0f, thk * 0.5f, -slabLen * 0.5f) *
-                S(slabW, thk, slabLen);
+    float deckW = outerW - 1.1f * HOUSE_SCALE;
+    float deckD = outerD - 1.1f * HOUSE_SCALE;
 
-            glm::mat4 back =
-                T(centerXZ.x, eaveY, zBackEave) *
-                Rx(-pitchRad) *
-                T(0.0f, thk * 0.5f, +slabLen * 0.5f) *
-                S(slabW, thk, slabLen);
+    float midPitch = glm::radians(10.0f);
+    float midPanelThk = 0.22f * HOUSE_SCALE;
+    float midDeckThk = 0.20f * HOUSE_SCALE;
 
-            items.push_back({ front, roofCol });
-            items.push_back({ back,  roofCol });
+    float midRoofTopY = AddDeckSkirtRoof(roof2Center, midEaveY,
+        deckW, deckD,
+        outerW, outerD,
+        midPitch,
+        midPanelThk, midDeckThk,
+        colRoof, colRoof * 0.92f);
 
-            float capW = slabW * 1.06f;
-            float capH = thk * 1.05f;
-            float capD = std::max(0.45f, ridgeOverlap * 5.0f);
+    {
+        float capThk = 0.12f * HOUSE_SCALE;
+        float capY = midRoofTopY - capThk - 0.006f * HOUSE_SCALE;
+        AddBox(glm::vec3(roof2Center.x, capY, roof2Center.z), glm::vec3(0.0f),
+            glm::vec3(outerW * 0.86f, capThk, outerD * 0.86f), colRoof * 0.98f, true);
+    }
 
-            glm::mat4 cap =
-                T(centerXZ.x, ridgeY + capH * 0.5f + thk * 0.02f, centerXZ.z) *
-                S(capW, capH, capD);
+    float supportThk = 0.18f * HOUSE_SCALE;
+    float supportW = W2 + 1.25f * HOUSE_SCALE;
+    float supportD = D2 + 1.15f * HOUSE_SCALE;
 
-            items.push_back({ cap, ridgeCol });
+    AddBox(glm::vec3(roof2Center.x, midRoofTopY, roof2Center.z), glm::vec3(0.0f),
+        glm::vec3(supportW, supportThk, supportD), colRoof * 0.88f, true);
 
-            return ridgeY + capH;
-        };
+    float f2Y = midRoofTopY + supportThk;
+    AddBox(glm::vec3(roof2Center.x, f2Y, roof2Center.z), glm::vec3(0.0f),
+        glm::vec3(W2, H2, D2), colWall, true);
 
-    auto AddGableRoof_EaveX = [&](const glm::vec3& centerXZ, float footprintW, float footprintD, float eaveY,
-        float pitchRad, float thk, float overhang, const glm::vec3& roofCol, const glm::vec3& ridgeCol) -> float
-        {
-            float halfSpan = footprintW * 0.5f + overhang;
-            float ridgeOverlap = std::max(0.08f, thk * 1.15f);
-            float slabLen = halfSpan + ridgeOverlap;
-            float slabD = footprintD + 2.0f * overhang;
+    float f2FrontZ = roof2Center.z + D2 * 0.5f;
+    float f2BackZ = roof2Center.z - D2 * 0.5f;
 
-            float ridgeRise = halfSpan * std::sin(pitchRad);
-            float ridgeY = eaveY + ridgeRise;
+    float balW = W2 * 0.82f;
+    float balD = 2.35f * HOUSE_SCALE;
+    float balT = 0.18f * HOUSE_SCALE;
 
-            float xRightEave = centerXZ.x + halfSpan;
-            float xLeftEave = centerXZ.x - halfSpan;
+    float balFloorY = f2Y + 0.18f * HOUSE_SCALE;
+    float balCenterX = roof2Center.x - 0.40f * HOUSE_SCALE;
+    float balCenterZ = f2FrontZ + balD * 0.5f - 0.10f * HOUSE_SCALE;
 
-            auto T = [](float x, float y, float z) { return glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z)); };
-            auto S = [](float x, float y, float z) { return glm::scale(glm::mat4(1.0f), glm::vec3(x, y, z)); };
-            auto Rz = [](float a) { return glm::rotate(glm::mat4(1.0f), a, glm::vec3(0, 0, 1)); };
+    AddBox(glm::vec3(balCenterX, balFloorY, balCenterZ), glm::vec3(0.0f),
+        glm::vec3(balW, balT, balD), colBase, true);
 
-            glm::mat4 right =
-                T(xRightEave, eaveY, centerXZ.z) *
-                Rz(-pitchRad) *
-                T(-slabLen * 0.5f, thk * 0.5f, 0.0f) *
-                S(slabLen, thk, slabD);
+    float railH = 1.08f * HOUSE_SCALE;
+    float railPostW = 0.14f * HOUSE_SCALE;
+    float railT = 0.12f * HOUSE_SCALE;
 
-            glm::mat4 left =
-                T(xLeftEave, eaveY, centerXZ.z) *
-                Rz(+pitchRad) *
-                T(+slabLen * 0.5f, thk * 0.5f, 0.0f) *
-                S(slabLen, thk, slabD);
+    float railTopY = balFloorY + railH;
+    float railMidY = balFloorY + 0.22f * HOUSE_SCALE;
+    float railFrontZ = balCenterZ + balD * 0.5f - railT * 0.5f;
 
-            items.push_back({ left,  roofCol });
-            items.push_back({ right, roofCol });
+    AddBox(glm::vec3(balCenterX, railTopY, railFrontZ), glm::vec3(0.0f),
+        glm::vec3(balW, 0.10f * HOUSE_SCALE, railT), colRail, true);
+    AddBox(glm::vec3(balCenterX, railMidY, railFrontZ), glm::vec3(0.0f),
+        glm::vec3(balW, 0.08f * HOUSE_SCALE, railT), colRail, true);
 
-            float capW = std::max(0.16f, ridgeOverlap * 2.4f);
-            float capH = thk * 0.90f;
-            float capD = slabD * 1.02f;
+    int bars = 12;
+    float leftX = balCenterX - balW * 0.5f;
+    float spacing = balW / (float)bars;
 
-            glm::mat4 cap =
-                T(centerXZ.x, ridgeY + capH * 0.5f + thk * 0.02f, centerXZ.z) *
-                S(capW, capH, capD);
+    for (int i = 0; i <= bars; ++i) {
+        float xx = leftX + spacing * i;
+        AddBox(glm::vec3(xx, balFloorY + 0.06f * HOUSE_SCALE, railFrontZ), glm::vec3(0.0f),
+            glm::vec3(railPostW, railH - 0.08f * HOUSE_SCALE, railPostW), colRail, true);
+    }
 
-            items.push_back({ cap, ridgeCol });
+    float slideW = 6.4f * HOUSE_SCALE;
+    float slideH = 2.9f * HOUSE_SCALE;
+    float slideY = f2Y + 0.52f * HOUSE_SCALE;
+    float slideZ = f2FrontZ + 0.04f * HOUSE_SCALE;
 
-            return ridgeY + capH;
-        };
+    AddWideWindow3Z(balCenterX, slideY, slideZ, slideW, slideH, HOUSE_SCALE, +1.0f);
 
-    float midEaveY_forGarage = 0.0f;
+    float shutterW = 0.75f * HOUSE_SCALE;
+    float shutterH = 2.6f * HOUSE_SCALE;
+    float shutterT = 0.10f * HOUSE_SCALE;
 
-    {
-        glm::vec3 Hc = center + glm::vec3(-yardW * 0.02f, 0.0f, 0.0f);
-        float slabY = overlayY + WC::YARD_THK;
+    AddBox(glm::vec3(balCenterX - slideW * 0.5f - shutterW * 0.6f, slideY + 0.10f * HOUSE_SCALE, slideZ + 0.12f * HOUSE_SCALE), glm::vec3(0.0f),
+        glm::vec3(shutterW, shutterH, shutterT), colTrim, true);
+    AddBox(glm::vec3(balCenterX + slideW * 0.5f + shutterW * 0.6f, slideY + 0.10f * HOUSE_SCALE, slideZ + 0.12f * HOUSE_SCALE), glm::vec3(0.0f),
+        glm::vec3(shutterW, shutterH, shutterT), colTrim, true);
 
-        float HOUSE_SCALE = 1.25f;
-        float slabH = 0.60f * HOUSE_SCALE;
+    float win2BaseY = f2Y + H2 * 0.55f - 0.95f * HOUSE_SCALE;
 
-        float W1 = 19.0f * HOUSE_SCALE;
-        float D1 = 13.6f * HOUSE_SCALE;
-        float H1 = 4.4f * HOUSE_SCALE * 1.22f;
+    AddRectWindowZ(roof2Center.x - W2 * 0.18f, win2BaseY, f2BackZ - 0.04f * HOUSE_SCALE,
+        2.3f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
 
-        float W2 = 15.2f * HOUSE_SCALE;
-        float D2 = 11.0f * HOUSE_SCALE;
-        float H2 = 3.6f * HOUSE_SCALE * 1.18f;
+    float side2X_R = roof2Center.x + W2 * 0.5f;
+    float side2X_L = roof2Center.x - W2 * 0.5f;
 
-        AddBox(glm::vec3(Hc.x, slabY, Hc.z), glm::vec3(0.0f),
-            glm::vec3(W1 + 2.4f * HOUSE_SCALE, slabH, D1 + 2.2f * HOUSE_SCALE), colBase, true);
+    AddRectWindowX(side2X_R, win2BaseY, roof2Center.z + D2 * 0.10f,
+        2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
+    AddRectWindowX(side2X_L, win2BaseY, roof2Center.z - D2 * 0.18f,
+        2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
 
-        float f1Y = slabY + slabH;
-        AddBox(glm::vec3(Hc.x, f1Y, Hc.z), glm::vec3(0.0f),
-            glm::vec3(W1, H1, D1), colWall, true);
+    float topEaveY = f2Y + H2;
 
-        float frontZ1 = Hc.z + D1 * 0.5f;
-        float backZ1 = Hc.z - D1 * 0.5f;
+    float topFootW = W2 + 1.9f * HOUSE_SCALE;
+    float topFootD = D2 + 1.6f * HOUSE_SCALE;
+    float topPitch = glm::radians(28.0f);
+    float topThk = 0.22f * HOUSE_SCALE;
+    float topOver = 0.65f * HOUSE_SCALE;
 
-        glm::vec3 porch = Hc + glm::vec3(W1 * 0.22f, 0.0f, D1 * 0.5f - 2.6f * HOUSE_SCALE);
-        AddBox(glm::vec3(porch.x, f1Y, porch.z), glm::vec3(0.0f),
-            glm::vec3(7.6f * HOUSE_SCALE, 4.2f * HOUSE_SCALE, 4.2f * HOUSE_SCALE), colWood, true);
+    (void)AddGableRoof_EaveZ(glm::vec3(roof2Center.x, 0.0f, roof2Center.z),
+        topFootW, topFootD, topEaveY, topPitch, topThk, topOver,
+        colRoof);
 
-        float stepH = 0.28f * HOUSE_SCALE;
-        float stepD = 0.85f * HOUSE_SCALE;
-        float stepW = 3.6f * HOUSE_SCALE;
-        float stepStartZ = frontZ1 + 0.40f * HOUSE_SCALE;
+    float ridgeY = topEaveY + (topFootD * 0.5f + topOver) * std::sin(topPitch);
 
-        AddBox(glm::vec3(porch.x, slabY, stepStartZ), glm::vec3(0.0f),
-            glm::vec3(stepW, stepH, stepD), colBase, true);
-        AddBox(glm::vec3(porch.x, slabY + stepH, stepStartZ + stepD), glm::vec3(0.0f),
-            glm::vec3(stepW, stepH, stepD), colBase, true);
-        AddBox(glm::vec3(porch.x, slabY + stepH * 2.0f, stepStartZ + stepD * 2.0f), glm::vec3(0.0f),
-            glm::vec3(stepW, stepH, stepD), colBase, true);
+    float seamW = topFootW * 1.06f;
+    float seamD = 2.40f * HOUSE_SCALE;
+    float seamH = topThk * 1.10f;
+    AddCenter(glm::vec3(roof2Center.x, ridgeY + seamH * 0.55f + 0.03f * HOUSE_SCALE, roof2Center.z),
+        glm::vec3(0.0f), glm::vec3(seamW, seamH, seamD), colRoof * 0.96f);
 
-        float doorW = 1.9f * HOUSE_SCALE;
-        float doorH = 4.2f * HOUSE_SCALE;
-        float doorT = 0.22f * HOUSE_SCALE;
+    float ridgeCapThk2 = topThk * 0.75f;
+    AddCenter(glm::vec3(roof2Center.x, ridgeY + ridgeCapThk2 * 0.45f, roof2Center.z),
+        glm::vec3(0.0f),
+        glm::vec3(seamW * 0.98f, ridgeCapThk2, seamD * 1.08f),
+        colRoof * 0.98f);
 
-        float doorZ = frontZ1 + 0.14f * HOUSE_SCALE;
-        AddBox(glm::vec3(porch.x, f1Y, doorZ), glm::vec3(0.0f),
-            glm::vec3(doorW, doorH, doorT), colDoor, true);
+    auto AddGableSideFill = [&](float endX, float eaveY2, float ridgeY2, float depthD, float thkX, glm::vec3 col) {
+        float totalH = std::max(0.01f, ridgeY2 - eaveY2);
+        AddBottom(glm::vec3(endX, eaveY2, roof2Center.z), glm::vec3(0.0f),
+            glm::vec3(thkX, totalH, depthD), col, MESH_PRISM);
+        };
 
-        glm::vec3 knobCol(0.88f, 0.78f, 0.25f);
-        float knobS = 0.12f * HOUSE_SCALE;
-        AddBox(glm::vec3(porch.x + doorW * 0.33f, f1Y + doorH * 0.54f, doorZ + doorT * 0.60f),
-            glm::vec3(0.0f), glm::vec3(knobS, knobS, knobS), knobCol, false);
+    float gableThk = 0.30f * HOUSE_SCALE;
+    float gableDepth = topFootD;
+    float gableXL = roof2Center.x - (W2 * 0.5f) - gableThk * 0.5f;
+    float gableXR = roof2Center.x + (W2 * 0.5f) + gableThk * 0.5f;
+    AddGableSideFill(gableXL, topEaveY, ridgeY, gableDepth, gableThk, colWall * 0.98f);
+    AddGableSideFill(gableXR, topEaveY, ridgeY, gableDepth, gableThk, colWall * 0.98f);
 
-        float winFrontZ = frontZ1 + 0.04f * HOUSE_SCALE;
-        float winBackZ = backZ1 - 0.04f * HOUSE_SCALE;
+    AddBox(glm::vec3(roof2Center.x - 4.2f * HOUSE_SCALE, topEaveY + 0.10f * HOUSE_SCALE, roof2Center.z - 2.0f * HOUSE_SCALE), glm::vec3(0.0f),
+        glm::vec3(1.30f * HOUSE_SCALE, std::max(2.2f * HOUSE_SCALE, (ridgeY - topEaveY) + 1.0f * HOUSE_SCALE), 1.30f * HOUSE_SCALE), colChim, true);
 
-        float winBaseY1 = f1Y + H1 * 0.55f - 1.05f * HOUSE_SCALE;
+    {
+        LodGroupScope doghouse;
+        float dogY = slabY;
 
-        AddWideWindow3Z(Hc.x - W1 * 0.22f, winBaseY1 + 0.12f * HOUSE_SCALE, winFrontZ,
-            7.2f * HOUSE_SCALE, 1.9f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
+        float dogW = 3.4f * HOUSE_SCALE * 0.55f * 0.78f;
+        float dogD = 2.6f * HOUSE_SCALE * 0.55f;
+        float dogH = 1.9f * HOUSE_SCALE * 0.55f * 1.25f;
 
-        AddRectWindowZ(Hc.x + W1 * 0.40f, winBaseY1 + 0.18f * HOUSE_SCALE, winFrontZ,
-            2.5f * HOUSE_SCALE, 2.1f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
+        float leftInsideX = center.x - fenceHalfW + fenceThk * 1.25f;
+        float houseLeftX = Hc.x - W1 * 0.5f;
+        float marginX = dogW * 0.90f + 0.65f;
 
-        AddRectWindowZ(Hc.x - W1 * 0.30f, winBaseY1 + 0.14f * HOUSE_SCALE, winBackZ,
-            2.6f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
+        float dogX = (leftInsideX + houseLeftX) * 0.5f;
+        dogX = std::max(leftInsideX + marginX, std::min(houseLeftX - marginX, dogX));
 
-        AddRectWindowZ(Hc.x + W1 * 0.32f, winBaseY1 + 0.12f * HOUSE_SCALE, winBackZ,
-            2.3f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
+        float frontInsideZ = center.z + fenceHalfL - fenceThk * 1.25f;
+        float backInsideZ = center.z - fenceHalfL + fenceThk * 1.25f;
 
-        float sideX_R = Hc.x + W1 * 0.5f;
-        float sideX_L = Hc.x - W1 * 0.5f;
+        float dogZ = Hc.z + D1 * 0.18f;
+        float marginZ = dogD * 0.85f + 0.8f;
+        dogZ = std::max(backInsideZ + marginZ, std::min(frontInsideZ - marginZ, dogZ));
 
-        AddRectWindowX(sideX_R, winBaseY1 + 0.12f * HOUSE_SCALE, Hc.z + D1 * 0.18f,
-            2.6f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
-        AddRectWindowX(sideX_R, winBaseY1 + 0.12f * HOUSE_SCALE, Hc.z - D1 * 0.22f,
-            2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
+        glm::vec3 dogC(dogX, 0.0f, dogZ);
 
-        AddRectWindowX(sideX_L, winBaseY1 + 0.10f * HOUSE_SCALE, Hc.z - D1 * 0.10f,
-            2.4f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
-        AddRectWindowX(sideX_L, winBaseY1 + 0.10f * HOUSE_SCALE, Hc.z + D1 * 0.26f,
-            2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
+        glm::vec3 dogWall(0.92f, 0.92f, 0.94f);
+        glm::vec3 dogRoof(0.35f, 0.75f, 0.95f);
 
-        glm::vec3 roof2Center = Hc + glm::vec3(-0.4f * HOUSE_SCALE, 0.0f, -0.9f * HOUSE_SCALE);
+        AddBox(glm::vec3(dogC.x, dogY, dogC.z), glm::vec3(0.0f),
+            glm::vec3(dogW, dogH, dogD), dogWall, true);
 
-        float midEaveY = f1Y + H1 + 0.02f * HOUSE_SCALE;
-        midEaveY_forGarage = midEaveY;
+        float dogEaveY = dogY + dogH;
+        float dogRoofW = dogW + 0.55f * HOUSE_SCALE * 0.55f;
+        float dogRoofD = dogD + 0.55f * HOUSE_SCALE * 0.55f;
+        float dogPitch = glm::radians(26.0f);
+        float dogThk = 0.13f * HOUSE_SCALE * 0.55f;
+        float dogOver = 0.18f * HOUSE_SCALE * 0.55f;
 
-        float outerW = W1 + 4.8f * HOUSE_SCALE;
-        float outerD = D1 + 4.6f * HOUSE_SCALE;
+        AddGableRoof_EaveZ(glm::vec3(dogC.x, 0.0f, dogC.z), dogRoofW, dogRoofD, dogEaveY,
+            dogPitch, dogThk, dogOver, dogRoof);
 
-        float deckW = outerW - 1.1f * HOUSE_SCALE;
-        float deckD = outerD - 1.1f * HOUSE_SCALE;
+        glm::vec3 holeCol(0.08f, 0.08f, 0.08f);
+        AddBox(glm::vec3(dogC.x, dogY + dogH * 0.05f, dogC.z + dogD * 0.5f + 0.03f),
+            glm::vec3(0.0f), glm::vec3(dogW * 0.55f, dogH * 0.62f, 0.10f), holeCol, true);
+    }
+}
 
-        float midPitch = glm::radians(10.0f);
-        float midPanelThk = 0.22f * HOUSE_SCALE;
-        float midDeckThk = 0.20f * HOUSE_SCALE;
+void BuildRack(const LotLayout& L) {
+    float overlayY = L.overlayY;
+    float HOUSE_SCALE = L.houseScale;
+    glm::vec3 Hc = L.houseCenter;
+    float W1 = L.W1;
+    float winFrontZ = L.winFrontZ;
 
-        float midRoofTopY = AddDeckSkirtRoof(roof2Center, midEaveY,
-            deckW, deckD,
-            outerW, outerD,
-            midPitch,
-            midPanelThk, midDeckThk,
-            colRoof, colRoof * 0.92f);
+    float rackX = Hc.x - W1 * 0.22f;
 
-        {
-            float capThk = 0.12f * HOUSE_SCALE;
-            float capY = midRoofTopY - capThk - 0.006f * HOUSE_SCALE;
-            AddBox(glm::vec3(roof2Center.x, capY, roof2Center.z), glm::vec3(0.0f),
-                glm::vec3(outerW * 0.86f, capThk, outerD * 0.86f), colRoof * 0.98f, true);
-        }
-
-        float supportThk = 0.18f * HOUSE_SCALE;
-        float supportW = W2 + 1.25f * HOUSE_SCALE;
-        float supportD = D2 + 1.15f * HOUSE_SCALE;
-
-        AddBox(glm::vec3(roof2Center.x, midRoofTopY, roof2Center.z), glm::vec3(0.0f),
-            glm::vec3(supportW, supportThk, supportD), colRoof * 0.88f, true);
+    float rackFrontOffset = 3.2f * HOUSE_SCALE;
+    float rackZ = winFrontZ + rackFrontOffset;
 
-        float f2Y = midRoofTopY + supportThk;
-        AddBox(glm::vec3(roof2Center.x, f2Y, roof2Center.z), glm::vec3(0.0f),
-            glm::vec3(W2, H2, D2), colWall, true);
+    float rackY = overlayY + WC::YARD_THK + 0.003f;
 
-        float f2FrontZ = roof2Center.z + D2 * 0.5f;
-        float f2BackZ = roof2Center.z - D2 * 0.5f;
+    glm::vec3 rackPos(rackX, rackY, rackZ);
+    NodeScope rack(MakeModel_TRS(rackPos, glm::vec3(0.0f), glm::vec3(1.0f)));
 
-        float balW = W2 * 0.82f;
-        float balD = 2.35f * HOUSE_SCALE;
-        float balT = 0.18f * HOUSE_SCALE;
+    glm::vec3 colFrame(0.45f, 0.45f, 0.50f);
+    glm::vec3 colWire(0.30f, 0.30f, 0.34f);
 
-        float balFloorY = f2Y + 0.18f * HOUSE_SCALE;
-        float balCenterX = roof2Center.x - 0.40f * HOUSE_SCALE;
-        float balCenterZ = f2FrontZ + balD * 0.5f - 0.10f * HOUSE_SCALE;
+    const float RACK_SCALE = 2.4f;
 
-        AddBox(glm::vec3(balCenterX, balFloorY, balCenterZ), glm::vec3(0.0f),
-            glm::vec3(balW, balT, balD), colBase, true);
+    float rW = 1.4f * RACK_SCALE;
+    float rD = 0.8f * RACK_SCALE;
+    float rH = 1.0f * RACK_SCALE;
+    float pThk = 0.03f * RACK_SCALE;
 
-        float railH = 1.08f * HOUSE_SCALE;
-        float railPostW = 0.14f * HOUSE_SCALE;
-        float railT = 0.12f * HOUSE_SCALE;
+    float wireThk = 0.012f * RACK_SCALE;
+    float towelThk = 0.03f * RACK_SCALE;
 
-        float railTopY = balFloorY + railH;
-        float railMidY = balFloorY + 0.22f * HOUSE_SCALE;
-        float railFrontZ = balCenterZ + balD * 0.5f - railT * 0.5f;
+    float legX[2] = { -rW * 0.5f, +rW * 0.5f };
+    float legZ[2] = { +rD * 0.5f, -rD * 0.5f };
 
-        AddBox(glm::vec3(balCenterX, railTopY, railFrontZ), glm::vec3(0.0f),
-            glm::vec3(balW, 0.10f * HOUSE_SCALE, railT), colRail, true);
-        AddBox(glm::vec3(balCenterX, railMidY, railFrontZ), glm::vec3(0.0f),
-            glm::vec3(balW, 0.08f * HOUSE_SCALE, railT), colRail, true);
+    for (int ix = 0; ix < 2; ++ix) {
+        for (int iz = 0; iz < 2; ++iz) {
+            AddBottom(rackPos + glm::vec3(legX[ix], 0.0f, legZ[iz]),
+                glm::vec3(0.0f),
+                glm::vec3(pThk, rH, pThk),
+                colFrame);
+        }
+    }
 
-        int bars = 12;
-        float leftX = balCenterX - balW * 0.5f;
-        float spacing = balW / (float)bars;
+    float topY = rH - pThk * 0.5f;
 
-        for (int i = 0; i <= bars; ++i) {
-            float xx = leftX + spacing * i;
-            AddBox(glm::vec3(xx, balFloorY + 0.06f * HOUSE_SCALE, railFrontZ), glm::vec3(0.0f),
-                glm::vec3(railPostW, railH - 0.08f * HOUSE_SCALE, railPostW), colRail, true);
-        }
+    for (int ix = 0; ix < 2; ++ix) {
+        AddCenter(rackPos + glm::vec3(legX[ix], topY, 0.0f),
+            glm::vec3(0.0f),
+            glm::vec3(pThk, pThk, rD),
+            colFrame);
+    }
 
-        float slideW = 6.4f * HOUSE_SCALE;
-        float slideH = 2.9f * HOUSE_SCALE;
-        float slideY = f2Y + 0.52f * HOUSE_SCALE;
-        float slideZ = f2FrontZ + 0.04f * HOUSE_SCALE;
+    for (int iz = 0; iz < 2; ++iz) {
+        AddCenter(rackPos + glm::vec3(0.0f, topY, legZ[iz]),
+            glm::vec3(0.0f),
+            glm::vec3(rW, pThk, pThk),
+            colFrame);
+    }
 
-        AddWideWindow3Z(balCenterX, slideY, slideZ, slideW, slideH, HOUSE_SCALE, +1.0f);
+    int wireCount = 9;
+    float wireGap = rW / (wireCount + 1);
 
-        float shutterW = 0.75f * HOUSE_SCALE;
-        float shutterH = 2.6f * HOUSE_SCALE;
-        float shutterT = 0.10f * HOUSE_SCALE;
+    for (int i = 1; i <= wireCount; ++i) {
+        float xPos = (rW * 0.5f) - (wireGap * i);
+        AddCenter(rackPos + glm::vec3(xPos, topY, 0.0f),
+            glm::vec3(0.0f),
+            glm::vec3(wireThk, wireThk, rD),
+            colWire);
+    }
 
-        AddBox(glm::vec3(balCenterX - slideW * 0.5f - shutterW * 0.6f, slideY + 0.10f * HOUSE_SCALE, slideZ + 0.12f * HOUSE_SCALE), glm::vec3(0.0f),
-            glm::vec3(shutterW, shutterH, shutterT), colTrim, true);
-        AddBox(glm::vec3(balCenterX + slideW * 0.5f + shutterW * 0.6f, slideY + 0.10f * HOUSE_SCALE, slideZ + 0.12f * HOUSE_SCALE), glm::vec3(0.0f),
-            glm::vec3(shutterW, shutterH, shutterT), colTrim, true);
+    float towelX = (rW * 0.5f) - (wireGap * 4);
+    float towelDrop = 0.35f * RACK_SCALE;
 
-        float win2BaseY = f2Y + H2 * 0.55f - 0.95f * HOUSE_SCALE;
+    AddCenter(rackPos + glm::vec3(towelX, topY - towelDrop, 0.0f),
+        glm::vec3(0.0f),
+        glm::vec3(towelThk, 0.7f * RACK_SCALE, 0.4f * RACK_SCALE),
+        glm::vec3(0.92f, 0.92f, 0.95f));
+}
 
-        AddRectWindowZ(roof2Center.x - W2 * 0.18f, win2BaseY, f2BackZ - 0.04f * HOUSE_SCALE,
-            2.3f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
+void BuildCarport(const LotLayout& L) {
+    float HOUSE_SCALE = L.houseScale;
+    float slabY = L.slabY;
+    float slabH = L.slabH;
+    glm::vec3 carCenter = L.carportCenter;
+    float carFootW = L.carportW;
+    float carFootD = L.carportD;
+    float carOver = L.carportOver;
+    float midEaveY = L.midEaveY;
+    glm::vec3 colBase = L.style.palette.base;
+    glm::vec3 colRoof = L.style.palette.roof;
+    glm::vec3 colWood = L.style.palette.wood;
+
+    float carBaseY = slabY + slabH;
+    LodGroupScope carport;
+
+    float carPitch = glm::radians(12.0f);
+    float carRoofThk = 0.24f * HOUSE_SCALE;
+
+    float minCarH = 2.2f * HOUSE_SCALE;
+    float carEaveY = std::max(midEaveY, carBaseY + minCarH);
+    float carH = carEaveY - carBaseY;
+
+    AddBox(glm::vec3(carCenter.x, carBaseY, carCenter.z), glm::vec3(0.0f),
+        glm::vec3(carFootW * 0.98f, 0.44f * HOUSE_SCALE, carFootD * 0.98f), colBase, true);
+
+    float colW = 0.48f * HOUSE_SCALE;
+    float colX = carFootW * 0.5f - 0.95f * HOUSE_SCALE;
+    float colZ = carFootD * 0.5f - 1.05f * HOUSE_SCALE;
+
+    AddBox(glm::vec3(carCenter.x - colX, carBaseY, carCenter.z + colZ), glm::vec3(0.0f),
+        glm::vec3(colW, carH, colW), colWood * 0.90f, true);
+    AddBox(glm::vec3(carCenter.x - colX, carBaseY, carCenter.z - colZ), glm::vec3(0.0f),
+        glm::vec3(colW, carH, colW), colWood * 0.90f, true);
+    AddBox(glm::vec3(carCenter.x + colX, carBaseY, carCenter.z + colZ), glm::vec3(0.0f),
+        glm::vec3(colW, carH, colW), colWood * 0.90f, true);
+    AddBox(glm::vec3(carCenter.x + colX, carBaseY, carCenter.z - colZ), glm::vec3(0.0f),
+        glm::vec3(colW, carH, colW), colWood * 0.90f, true);
+
+    float beamH = 0.20f * HOUSE_SCALE;
+    AddBox(glm::vec3(carCenter.x, carEaveY - beamH, carCenter.z), glm::vec3(0.0f),
+        glm::vec3(carFootW * 1.02f, beamH, carFootD * 1.02f), colWood * 0.92f, true);
+
+    AddGableRoof_EaveX(glm::vec3(carCenter.x, 0.0f, carCenter.z),
+        carFootW, carFootD, carEaveY,
+        carPitch, carRoofThk, carOver,
+        colRoof);
 
-        float side2X_R = roof2Center.x + W2 * 0.5f;
-        float side2X_L = roof2Center.x - W2 * 0.5f;
+    {
+        // Pulls forward out of the carport and backs in again.
+        MotionScope car(Anim{ 0.0f, 0.35f, MOTION_SHUTTLE, carFootD * 0.35f, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f) });
+        float baseY = carBaseY + 0.01f;
+        float CAR_SCALE = 1.55f;
 
-        AddRectWindowX(side2X_R, win2BaseY, roof2Center.z + D2 * 0.10f,
-            2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, +1.0f);
-        AddRectWindowX(side2X_L, win2BaseY, roof2Center.z - D2 * 0.18f,
-            2.2f * HOUSE_SCALE, 2.0f * HOUSE_SCALE, HOUSE_SCALE, -1.0f);
+        float carLift = 0.55f * CAR_SCALE;
+        glm::vec3 carC(carCenter.x, baseY + carLift, carCenter.z);
+        NodeScope body(MakeModel_TRS(carC, glm::vec3(0.0f), glm::vec3(1.0f)));
 
-        float topEaveY = f2Y + H2;
+        glm::vec3 carGreen(0.22f, 0.72f, 0.30f);
+        glm::vec3 carGreenDark(0.14f, 0.52f, 0.22f);
+        glm::vec3 tire(0.07f, 0.07f, 0.07f);
+        glm::vec3 rim(0.75f, 0.75f, 0.75f);
+        glm::vec3 head(1.00f, 0.95f, 0.75f);
+        glm::vec3 tail(0.88f, 0.15f, 0.12f);
 
-        float topFootW = W2 + 1.9f * HOUSE_SCALE;
-        float topFootD = D2 + 1.6f * HOUSE_SCALE;
-        float topPitch = glm::radians(28.0f);
-        float topThk = 0.22f * HOUSE_SCALE;
-        float topOver = 0.65f * HOUSE_SCALE;
+        float bodyW = 2.80f * CAR_SCALE;
+        float bodyL = 5.30f * CAR_SCALE;
+        float bodyH = 0.85f * CAR_SCALE;
 
-        (void)AddGableRoof_EaveZ(glm::vec3(roof2Center.x, 0.0f, roof2Center.z),
-            topFootW, topFootD, topEaveY, topPitch, topThk, topOver,
-            colRoof, colRoof * 0.92f);
+        float cabinW = 2.35f * CAR_SCALE;
+        float cabinL = 2.70f * CAR_SCALE;
+        float cabinH = 0.95f * CAR_SCALE;
 
-        float ridgeY = topEaveY + (topFootD * 0.5f + topOver) * std::sin(topPitch);
+        float wheelR = 0.58f * CAR_SCALE;
+        float wheelThk = 0.28f * CAR_SCALE;
 
-        float seamW = topFootW * 1.06f;
-        float seamD = 2.40f * HOUSE_SCALE;
-        float seamH = topThk * 1.10f;
-        AddCenter(glm::vec3(roof2Center.x, ridgeY + seamH * 0.55f + 0.03f * HOUSE_SCALE, roof2Center.z),
-            glm::vec3(0.0f), glm::vec3(seamW, seamH, seamD), colRoof * 0.96f);
+        AddBottom(glm::vec3(carC.x, carC.y, carC.z), glm::vec3(0),
+            glm::vec3(bodyW, bodyH, bodyL), carGreen);
 
-        float ridgeCapThk2 = topThk * 0.75f;
-        AddCenter(glm::vec3(roof2Center.x, ridgeY + ridgeCapThk2 * 0.45f, roof2Center.z),
-            glm::vec3(0.0f),
-            glm::vec3(seamW * 0.98f, ridgeCapThk2, seamD * 1.08f),
-            colRoof * 0.98f);
-
-        auto AddGableSideFill = [&](float endX, float eaveY2, float ridgeY2, float depthD, float thkX, glm::vec3 col) {
-            int steps2 = 6;
-            float totalH = std::max(0.01f, ridgeY2 - eaveY2);
-            float stepH2 = totalH / (float)steps2;
-            for (int i = 0; i < steps2; ++i) {
-                float t = (float)i / (float)steps2;
-                float d = std::max(0.2f, depthD * (1.0f - t));
-                float yb = eaveY2 + stepH2 * (float)i;
-                AddBox(glm::vec3(endX, yb, roof2Center.z), glm::vec3(0.0f),
-                    glm::vec3(thkX, stepH2 + 0.002f, d), col, true);
-            }
-            };
+        AddBottom(glm::vec3(carC.x, carC.y + bodyH * 0.62f, carC.z + 1.40f * CAR_SCALE), glm::vec3(0),
+            glm::vec3(bodyW * 0.92f, 0.34f * CAR_SCALE, 1.60f * CAR_SCALE), carGreen);
 
-        float gableThk = 0.30f * HOUSE_SCALE;
-        float gableDepth = topFootD;
-        float gableXL = roof2Center.x - (W2 * 0.5f) - gableThk * 0.5f;
-        float gableXR = roof2Center.x + (W2 * 0.5f) + gableThk * 0.5f;
-        AddGableSideFill(gableXL, topEaveY, ridgeY, gableDepth, gableThk, colWall * 0.98f);
-        AddGableSideFill(gableXR, topEaveY, ridgeY, gableDepth, gableThk, colWall * 0.98f);
+        AddBottom(glm::vec3(carC.x, carC.y + 0.06f * CAR_SCALE, carC.z + bodyL * 0.5f - 0.12f * CAR_SCALE), glm::vec3(0),
+            glm::vec3(bodyW * 0.94f, 0.33f * CAR_SCALE, 0.24f * CAR_SCALE), carGreenDark);
+        AddBottom(glm::vec3(carC.x, carC.y + 0.06f * CAR_SCALE, carC.z - bodyL * 0.5f + 0.12f * CAR_SCALE), glm::vec3(0),
+            glm::vec3(bodyW * 0.94f, 0.33f * CAR_SCALE, 0.24f * CAR_SCALE), carGreenDark);
 
-        AddBox(glm::vec3(roof2Center.x - 4.2f * HOUSE_SCALE, topEaveY + 0.10f * HOUSE_SCALE, roof2Center.z - 2.0f * HOUSE_SCALE), glm::vec3(0.0f),
-            glm::vec3(1.30f * HOUSE_SCALE, std::max(2.2f * HOUSE_SCALE, (ridgeY - topEaveY) + 1.0f * HOUSE_SCALE), 1.30f * HOUSE_SCALE), colChim, true);
+        float cabinY = carC.y + bodyH;
+        glm::vec3 cabinC(carC.x, cabinY, carC.z - 0.35f * CAR_SCALE);
+        AddBottom(glm::vec3(cabinC.x, cabinC.y, cabinC.z), glm::vec3(0),
+            glm::vec3(cabinW, cabinH, cabinL), carGreen);
 
-        float dogY = slabY;
+        float sideGlassT = 0.06f * CAR_SCALE;
+        float sideWinH = cabinH * 0.65f;
+        float sideWinL = cabinL * 0.95f;
 
-        float dogW = 3.4f * HOUSE_SCALE * 0.55f * 0.78f;
-        float dogD = 2.6f * HOUSE_SCALE * 0.55f;
-        float dogH = 1.9f * HOUSE_SCALE * 0.55f * 1.25f;
+        float sideEps = 0.01f * CAR_SCALE;
+        float xL_glass = cabinC.x - (cabinW * 0.5f + sideEps);
+        float xR_glass = cabinC.x + (cabinW * 0.5f + sideEps);
 
-        float leftInsideX = center.x - fenceHalfW + fenceThk * 1.25f;
-        float houseLeftX = Hc.x - W1 * 0.5f;
-        float marginX = dogW * 0.90f + 0.65f;
+        float sideY = cabinC.y + cabinH * 0.62f;
+        float sideZ = cabinC.z;
 
-        float dogX = (leftInsideX + houseLeftX) * 0.5f;
-        dogX = std::max(leftInsideX + marginX, std::min(houseLeftX - marginX, dogX));
+        glm::vec3 sideGlassCol(0.55f, 0.78f, 0.98f);
 
-        float frontInsideZ = center.z + fenceHalfL - fenceThk * 1.25f;
-        float backInsideZ = center.z - fenceHalfL + fenceThk * 1.25f;
+        AddCenter(glm::vec3(xL_glass, sideY, sideZ),
+            glm::vec3(0.0f),
+            glm::vec3(sideGlassT, sideWinH, sideWinL),
+            sideGlassCol);
 
-        float dogZ = Hc.z + D1 * 0.18f;
-        float marginZ = dogD * 0.85f + 0.8f;
-        dogZ = std::max(backInsideZ + marginZ, std::min(frontInsideZ - marginZ, dogZ));
+        AddCenter(glm::vec3(xR_glass, sideY, sideZ),
+            glm::vec3(0.0f),
+            glm::vec3(sideGlassT, sideWinH, sideWinL),
+            sideGlassCol);
 
-        glm::vec3 dogC(dogX, 0.0f, dogZ);
+        {
+            glm::vec3 dividerCol = carGreenDark * 0.85f;
 
-        glm::vec3 dogWall(0.92f, 0.92f, 0.94f);
-        glm::vec3 dogRoof(0.35f, 0.75f, 0.95f);
+            float divT = sideGlassT + 0.02f * CAR_SCALE;
+            float divW = 0.10f * CAR_SCALE;
 
-        AddBox(glm::vec3(dogC.x, dogY, dogC.z), glm::vec3(0.0f),
-            glm::vec3(dogW, dogH, dogD), dogWall, true);
+            float splitZ = cabinC.z + cabinL * 0.10f;
 
-        float dogEaveY = dogY + dogH;
-        float dogRoofW = dogW + 0.55f * HOUSE_SCALE * 0.55f;
-        float dogRoofD = dogD + 0.55f * HOUSE_SCALE * 0.55f;
-        float dogPitch = glm::radians(26.0f);
-        float dogThk = 0.13f * HOUSE_SCALE * 0.55f;
-        float dogOver = 0.18f * HOUSE_SCALE * 0.55f;
+            float pillarBaseY = baseY - 0.01f * CAR_SCALE;
+            float pillarTopY = (cabinC.y + cabinH * 0.88f);
 
-        AddGableRoof_EaveZ(glm::vec3(dogC.x, 0.0f, dogC.z), dogRoofW, dogRoofD, dogEaveY,
-            dogPitch, dogThk, dogOver, dogRoof, dogRoof * 0.92f);
+            float divH = pillarTopY - pillarBaseY;
+            if (divH < 0.05f) divH = 0.05f;
 
-        glm::vec3 holeCol(0.08f, 0.08f, 0.08f);
-        AddBox(glm::vec3(dogC.x, dogY + dogH * 0.05f, dogC.z + dogD * 0.5f + 0.03f),
-            glm::vec3(0.0f), glm::vec3(dogW * 0.55f, dogH * 0.62f, 0.10f), holeCol, true);
+            float divEps2 = 0.012f * CAR_SCALE;
+            float xLL = cabinC.x - (cabinW * 0.5f + divEps2);
+            float xRR = cabinC.x + (cabinW * 0.5f + divEps2);
 
+            AddBottom(glm::vec3(xLL, pillarBaseY, splitZ),
+                glm::vec3(0.0f),
+                glm::vec3(divT, divH, divW),
+                dividerCol);
 
+            AddBottom(glm::vec3(xRR, pillarBaseY, splitZ),
+                glm::vec3(0.0f),
+                glm::vec3(divT, divH, divW),
+                dividerCol);
+        }
 
         {
+            glm::vec3 glassCol(0.55f, 0.78f, 0.98f);
 
-            float rackX = Hc.x - W1 * 0.22f;
+            float glassT = 0.10f * CAR_SCALE;
+            float winW = cabinW * 0.78f;
+            float winH = cabinH * 0.90f;
 
+            float yv = cabinC.y + cabinH * 0.52f;
+            float zv = cabinC.z + cabinL * 0.5f + 0.04f * CAR_SCALE;
 
+            glm::vec3 rot(glm::radians(-12.0f), 0.0f, 0.0f);
 
-            float rackFrontOffset = 3.2f * HOUSE_SCALE;
-            float rackZ = winFrontZ + rackFrontOffset;
+            AddCenter(glm::vec3(cabinC.x, yv, zv),
+                rot,
+                glm::vec3(winW, winH, glassT),
+                glassCol);
+        }
 
+        {
+            glm::vec3 wiperCol(0.06f, 0.06f, 0.06f);
 
-            float rackY = overlayY + WC::YARD_THK + 0.003f;
+            float winW = cabinW * 0.78f;
+            float winH = cabinH * 0.90f;
 
-            glm::vec3 rackPos(rackX, rackY, rackZ);
+            float yv = cabinC.y + cabinH * 0.52f;
+            float zv = cabinC.z + cabinL * 0.5f + 0.04f * CAR_SCALE;
 
+            glm::vec3 wsRot(glm::radians(-12.0f), 0.0f, 0.0f);
 
-            glm::vec3 colFrame(0.45f, 0.45f, 0.50f);
-            glm::vec3 colWire(0.30f, 0.30f, 0.34f);
+            glm::vec3 base = glm::vec3(cabinC.x, yv - winH * 0.42f, zv + 0.15f * CAR_SCALE);
 
+            float bladeT = 0.05f * CAR_SCALE;
+            float bladeH = 0.04f * CAR_SCALE;
+            float bladeL = winW * 0.42f;
 
-            const float RACK_SCALE = 2.4f;
+            float armT = 0.04f * CAR_SCALE;
+            float armH = 0.04f * CAR_SCALE;
+            float armL = winW * 0.18f;
 
-            float rW = 1.4f * RACK_SCALE;
-            float rD = 0.8f * RACK_SCALE;
-            float rH = 1.0f * RACK_SCALE;
-            float pThk = 0.03f * RACK_SCALE;
+            {
+                float xOff = -winW * 0.18f;
+                glm::vec3 p = base + glm::vec3(xOff, 0.00f, 0.00f);
+
+                AddCenter(p + glm::vec3(-armL * 0.20f, 0.01f * CAR_SCALE, 0.00f),
+                    wsRot + glm::vec3(0.0f, 0.0f, glm::radians(18.0f)),
+                    glm::vec3(armL, armH, armT),
+                    wiperCol);
+
+                AddCenter(p,
+                    wsRot + glm::vec3(0.0f, 0.0f, glm::radians(18.0f)),
+                    glm::vec3(bladeL, bladeH, bladeT),
+                    wiperCol);
+            }
 
+            {
+                float xOff = +winW * 0.18f;
+                glm::vec3 p = base + glm::vec3(xOff, 0.00f, 0.00f);
+
+                AddCenter(p + glm::vec3(+armL * 0.20f, 0.01f * CAR_SCALE, 0.00f),
+                    wsRot + glm::vec3(0.0f, 0.0f, glm::radians(-18.0f)),
+                    glm::vec3(armL, armH, armT),
+                    wiperCol);
+
+                AddCenter(p,
+                    wsRot + glm::vec3(0.0f, 0.0f, glm::radians(-18.0f)),
+                    glm::vec3(bladeL, bladeH, bladeT),
+                    wiperCol);
+            }
+        }
 
-            float wireThk = 0.012f * RACK_SCALE;
-            float towelThk = 0.03f * RACK_SCALE;
+        {
+            glm::vec3 mirrorBody(0.10f, 0.10f, 0.10f);
+            glm::vec3 mirrorGlass(0.70f, 0.85f, 0.95f);
 
-            float legX[2] = { -rW * 0.5f, +rW * 0.5f };
-            float legZ[2] = { +rD * 0.5f, -rD * 0.5f };
+            float yv = cabinC.y + cabinH * 0.58f;
+            float zv = carC.z + bodyL * 0.5f - 1.60f * CAR_SCALE;
 
+            float out = 0.18f * CAR_SCALE;
 
-            for (int ix = 0; ix < 2; ++ix) {
-                for (int iz = 0; iz < 2; ++iz) {
-                    AddBottom(rackPos + glm::vec3(legX[ix], 0.0f, legZ[iz]),
-                        glm::vec3(0.0f),
-                        glm::vec3(pThk, rH, pThk),
-                        colFrame);
-                }
-            }
+            float armLen = 0.22f * CAR_SCALE;
+            float armThk = 0.06f * CAR_SCALE;
+            float armH = 0.08f * CAR_SCALE;
 
+            float housW = 0.30f * CAR_SCALE;
+            float housH = 0.20f * CAR_SCALE;
+            float housD = 0.16f * CAR_SCALE;
 
-            float topY = rH - pThk * 0.5f;
+            float glassInset = 0.01f * CAR_SCALE;
 
+            {
+                float xSide = cabinC.x - (cabinW * 0.5f + out);
 
-            for (int ix = 0; ix < 2; ++ix) {
-                AddCenter(rackPos + glm::vec3(legX[ix], topY, 0.0f),
+                AddCenter(glm::vec3(xSide + armLen * 0.45f, yv, zv),
                     glm::vec3(0.0f),
-                    glm::vec3(pThk, pThk, rD),
-                    colFrame);
-            }
+                    glm::vec3(armLen, armH, armThk),
+                    mirrorBody);
 
+                AddCenter(glm::vec3(xSide, yv, zv),
+                    glm::vec3(0.0f),
+                    glm::vec3(housW, housH, housD),
+                    mirrorBody);
 
-            for (int iz = 0; iz < 2; ++iz) {
-                AddCenter(rackPos + glm::vec3(0.0f, topY, legZ[iz]),
+                AddCenter(glm::vec3(xSide - housW * 0.10f, yv, zv - housD * 0.5f - glassInset),
                     glm::vec3(0.0f),
-                    glm::vec3(rW, pThk, pThk),
-                    colFrame);
+                    glm::vec3(housW * 0.78f, housH * 0.78f, 0.03f * CAR_SCALE),
+                    mirrorGlass);
             }
 
+            {
+                float xSide = cabinC.x + (cabinW * 0.5f + out);
 
-            int wireCount = 9;
-            float wireGap = rW / (wireCount + 1);
+                AddCenter(glm::vec3(xSide - armLen * 0.45f, yv, zv),
+                    glm::vec3(0.0f),
+                    glm::vec3(armLen, armH, armThk),
+                    mirrorBody);
 
-            for (int i = 1; i <= wireCount; ++i) {
-                float xPos = (rW * 0.5f) - (wireGap * i);
-                AddCenter(rackPos + glm::vec3(xPos, topY, 0.0f),
+                AddCenter(glm::vec3(xSide, yv, zv),
                     glm::vec3(0.0f),
-                    glm::vec3(wireThk, wireThk, rD),
-                    colWire);
+                    glm::vec3(housW, housH, housD),
+                    mirrorBody);
+
+                AddCenter(glm::vec3(xSide + housW * 0.10f, yv, zv - housD * 0.5f - glassInset),
+                    glm::vec3(0.0f),
+                    glm::vec3(housW * 0.78f, housH * 0.78f, 0.03f * CAR_SCALE),
+                    mirrorGlass);
             }
+        }
 
+        {
+            glm::vec3 doorLineCol = carGreenDark * 0.95f;
+            glm::vec3 handleCol = glm::vec3(0.10f, 0.10f, 0.10f);
 
-            float towelX = (rW * 0.5f) - (wireGap * 4);
-            float towelDrop = 0.35f * RACK_SCALE;
+            float doorZ = carC.z + 0.10f * CAR_SCALE;
+            float doorY = carC.y + bodyH * 0.55f;
 
-            AddCenter(rackPos + glm::vec3(towelX, topY - towelDrop, 0.0f),
-                glm::vec3(0.0f),
-                glm::vec3(towelThk, 0.7f * RACK_SCALE, 0.4f * RACK_SCALE),
-                glm::vec3(0.92f, 0.92f, 0.95f));
-        }
+            float doorH = bodyH * 0.55f;
+            float doorL = bodyL * 0.40f;
+            float panelT = 0.03f * CAR_SCALE;
 
+            float eps = 0.005f * CAR_SCALE;
+            float xL = carC.x - (bodyW * 0.5f + panelT * 0.5f + eps);
+            float xR = carC.x + (bodyW * 0.5f + panelT * 0.5f + eps);
 
+            AddCenter(glm::vec3(xL, doorY, doorZ),
+                glm::vec3(0.0f),
+                glm::vec3(panelT, doorH, doorL),
+                doorLineCol);
 
-        glm::vec3 carCenter = Hc + glm::vec3(W1 * 0.60f + 4.8f * HOUSE_SCALE, 0.0f, D1 * 0.18f);
-        float carBaseY = slabY + slabH;
+            AddCenter(glm::vec3(xR, doorY, doorZ),
+                glm::vec3(0.0f),
+                glm::vec3(panelT, doorH, doorL),
+                doorLineCol);
 
-        float carPitch = glm::radians(12.0f);
-        float carRoofThk = 0.24f * HOUSE_SCALE;
+            float handleW = 0.18f * CAR_SCALE;
+            float handleH = 0.05f * CAR_SCALE;
+            float handleT = 0.05f * CAR_SCALE;
 
-        float minCarH = 2.2f * HOUSE_SCALE;
-        float carEaveY = std::max(midEaveY_forGarage, carBaseY + minCarH);
-        float carH = carEaveY - carBaseY;
+            float handleY = doorY + doorH * 0.28f;
 
-        float carFootW = 8.4f * HOUSE_SCALE;
-        float carFootD = 10.2f * HOUSE_SCALE;
-        float carOver = 0.75f * HOUSE_SCALE;
+            float handleZ_F = doorZ + doorL * 0.18f;
+            float handleZ_B = doorZ - doorL * 0.18f;
 
-        AddBox(glm::vec3(carCenter.x, carBaseY, carCenter.z), glm::vec3(0.0f),
-            glm::vec3(carFootW * 0.98f, 0.44f * HOUSE_SCALE, carFootD * 0.98f), colBase, true);
+            AddCenter(glm::vec3(xL - handleT * 0.5f, handleY, handleZ_F),
+                glm::vec3(0.0f),
+                glm::vec3(handleT, handleH, handleW),
+                handleCol);
+            AddCenter(glm::vec3(xL - handleT * 0.5f, handleY, handleZ_B),
+                glm::vec3(0.0f),
+                glm::vec3(handleT, handleH, handleW),
+                handleCol);
 
-        float colW = 0.48f * HOUSE_SCALE;
-        float colX = carFootW * 0.5f - 0.95f * HOUSE_SCALE;
-        float colZ = carFootD * 0.5f - 1.05f * HOUSE_SCALE;
+            AddCenter(glm::vec3(xR + handleT * 0.5f, handleY, handleZ_F),
+                glm::vec3(0.0f),
+                glm::vec3(handleT, handleH, handleW),
+                handleCol);
+            AddCenter(glm::vec3(xR + handleT * 0.5f, handleY, handleZ_B),
+                glm::vec3(0.0f),
+                glm::vec3(handleT, handleH, handleW),
+                handleCol);
+        }
 
-        AddBox(glm::vec3(carCenter.x - colX, carBaseY, carCenter.z + colZ), glm::vec3(0.0f),
-            glm::vec3(colW, carH, colW), colWood * 0.90f, true);
-        AddBox(glm::vec3(carCenter.x - colX, carBaseY, carCenter.z - colZ), glm::vec3(0.0f),
-            glm::vec3(colW, carH, colW), colWood * 0.90f, true);
-        AddBox(glm::vec3(carCenter.x + colX, carBaseY, carCenter.z + colZ), glm::vec3(0.0f),
-            glm::vec3(colW, carH, colW), colWood * 0.90f, true);
-        AddBox(glm::vec3(carCenter.x + colX, carBaseY, carCenter.z - colZ), glm::vec3(0.0f),
-            glm::vec3(colW, carH, colW), colWood * 0.90f, true);
+        // Cylinders lie along X: rolled a quarter turn about Z, so local Y
+        // (the axis) carries the thickness.
+        auto AddWheelRing = [&](glm::vec3 wheelC, float radius2, float thickness, glm::vec3 colTire, glm::vec3 colRim) {
+            NodeScope wheel(MakeModel_TRS(wheelC, glm::vec3(0.0f), glm::vec3(1.0f)));
+            glm::vec3 axisX(0.0f, 0.0f, 1.5707963f);
+            AddCenter(wheelC, axisX,
+                glm::vec3(radius2 * 2.14f, thickness, radius2 * 2.14f),
+                colTire, MESH_CYLINDER);
+            AddCenter(wheelC, axisX,
+                glm::vec3(radius2 * 1.24f, thickness * 1.04f, radius2 * 1.24f),
+                colRim, MESH_CYLINDER);
+            };
 
-        float beamH = 0.20f * HOUSE_SCALE;
-        AddBox(glm::vec3(carCenter.x, carEaveY - beamH, carCenter.z), glm::vec3(0.0f),
-            glm::vec3(carFootW * 1.02f, beamH, carFootD * 1.02f), colWood * 0.92f, true);
+        float wheelY = baseY + wheelR;
+        float frontZ = carC.z + bodyL * 0.5f - 1.10f * CAR_SCALE;
+        float backZ = carC.z - bodyL * 0.5f + 1.10f * CAR_SCALE;
 
-        AddGableRoof_EaveX(glm::vec3(carCenter.x, 0.0f, carCenter.z),
-            carFootW, carFootD, carEaveY,
-            carPitch, carRoofThk, carOver,
-            colRoof, colRoof * 0.92f);
+        float wheelX = bodyW * 0.5f - wheelThk * 0.35f;
 
-        {
-            float baseY = carBaseY + 0.01f;
-            float CAR_SCALE = 1.55f;
+        glm::vec3 wFL(carC.x - wheelX, wheelY, frontZ);
+        glm::vec3 wFR(carC.x + wheelX, wheelY, frontZ);
+        glm::vec3 wBL(carC.x - wheelX, wheelY, backZ);
+        glm::vec3 wBR(carC.x + wheelX, wheelY, backZ);
 
-            float carLift = 0.55f * CAR_SCALE;
-            glm::vec3 carC(carCenter.x, baseY + carLift, carCenter.z);
+        AddWheelRing(wFL, wheelR, wheelThk, tire, rim);
+        AddWheelRing(wFR, wheelR, wheelThk, tire, rim);
+        AddWheelRing(wBL, wheelR, wheelThk, tire, rim);
+        AddWheelRing(wBR, wheelR, wheelThk, tire, rim);
 
-            glm::vec3 carGreen(0.22f, 0.72f, 0.30f);
-            glm::vec3 carGreenDark(0.14f, 0.52f, 0.22f);
-            glm::vec3 tire(0.07f, 0.07f, 0.07f);
-            glm::vec3 rim(0.75f, 0.75f, 0.75f);
-            glm::vec3 head(1.00f, 0.95f, 0.75f);
-            glm::vec3 tail(0.88f, 0.15f, 0.12f);
+        float lightZOut = 0.18f * CAR_SCALE;
 
-            float bodyW = 2.80f * CAR_SCALE;
-            float bodyL = 5.30f * CAR_SCALE;
-            float bodyH = 0.85f * CAR_SCALE;
+        float headY = carC.y + 0.48f * CAR_SCALE;
+        float headZ = carC.z + bodyL * 0.5f + lightZOut;
+        AddBottom(glm::vec3(carC.x - 0.90f * CAR_SCALE, headY, headZ),
+            glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), head);
+        AddBottom(glm::vec3(carC.x + 0.90f * CAR_SCALE, headY, headZ),
+            glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), head);
 
-            float cabinW = 2.35f * CAR_SCALE;
-            float cabinL = 2.70f * CAR_SCALE;
-            float cabinH = 0.95f * CAR_SCALE;
+        float tailY = carC.y + 0.48f * CAR_SCALE;
+        float tailZ = carC.z - bodyL * 0.5f - lightZOut;
+        AddBottom(glm::vec3(carC.x - 0.90f * CAR_SCALE, tailY, tailZ),
+            glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), tail);
+        AddBottom(glm::vec3(carC.x + 0.90f * CAR_SCALE, tailY, tailZ),
+            glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), tail);
 
-            float wheelR = 0.58f * CAR_SCALE;
-            float wheelThk = 0.28f * CAR_SCALE;
+        AddBottom(glm::vec3(carC.x, carC.y - 0.08f * CAR_SCALE, carC.z),
+            glm::vec3(0),
+            glm::vec3(bodyW * 0.95f, 0.12f * CAR_SCALE, bodyL * 0.95f),
+            carGreenDark);
 
-            AddBottom(glm::vec3(carC.x, carC.y, carC.z), glm::vec3(0),
-                glm::vec3(bodyW, bodyH, bodyL), carGreen);
+        {
+            glm::vec3 plateCol(0.92f, 0.92f, 0.92f);
+            glm::vec3 borderCol(0.12f, 0.12f, 0.12f);
 
-            AddBottom(glm::vec3(carC.x, carC.y + bodyH * 0.62f, carC.z + 1.40f * CAR_SCALE), glm::vec3(0),
-                glm::vec3(bodyW * 0.92f, 0.34f * CAR_SCALE, 1.60f * CAR_SCALE), carGreen);
+            float plateW = 1.10f * CAR_SCALE;
+            float plateH = 0.32f * CAR_SCALE;
+            float plateT = 0.05f * CAR_SCALE;
 
-            AddBottom(glm::vec3(carC.x, carC.y + 0.06f * CAR_SCALE, carC.z + bodyL * 0.5f - 0.12f * CAR_SCALE), glm::vec3(0),
-                glm::vec3(bodyW * 0.94f, 0.33f * CAR_SCALE, 0.24f * CAR_SCALE), carGreenDark);
-            AddBottom(glm::vec3(carC.x, carC.y + 0.06f * CAR_SCALE, carC.z - bodyL * 0.5f + 0.12f * CAR_SCALE), glm::vec3(0),
-                glm::vec3(bodyW * 0.94f, 0.33f * CAR_SCALE, 0.24f * CAR_SCALE), carGreenDark);
+            float plateY = carC.y + 0.30f * CAR_SCALE;
+            float fz = carC.z + bodyL * 0.5f + 0.12f * CAR_SCALE;
+            float bz = carC.z - bodyL * 0.5f - 0.12f * CAR_SCALE;
 
-            float cabinY = carC.y + bodyH;
-            glm::vec3 cabinC(carC.x, cabinY, carC.z - 0.35f * CAR_SCALE);
-            AddBottom(glm::vec3(cabinC.x, cabinC.y, cabinC.z), glm::vec3(0),
-                glm::vec3(cabinW, cabinH, cabinL), carGreen);
+            AddCenter(glm::vec3(carC.x, plateY, fz), glm::vec3(0.0f),
+                glm::vec3(plateW, plateH, plateT), plateCol);
 
-            float sideGlassT = 0.06f * CAR_SCALE;
-            float sideWinH = cabinH * 0.65f;
-            float sideWinL = cabinL * 0.95f;
+            AddCenter(glm::vec3(carC.x, plateY, bz), glm::vec3(0.0f),
+                glm::vec3(plateW, plateH, plateT), plateCol);
 
-            float sideEps = 0.01f * CAR_SCALE;
-            float xL_glass = cabinC.x - (cabinW * 0.5f + sideEps);
-            float xR_glass = cabinC.x + (cabinW * 0.5f + sideEps);
+            float b = 0.03f * CAR_SCALE;
+            AddCenter(glm::vec3(carC.x, plateY + plateH * 0.5f - b * 0.5f, fz + plateT * 0.6f), glm::vec3(0.0f),
+                glm::vec3(plateW, b, b), borderCol);
+            AddCenter(glm::vec3(carC.x, plateY - plateH * 0.5f + b * 0.5f, fz + plateT * 0.6f), glm::vec3(0.0f),
+                glm::vec3(plateW, b, b), borderCol);
 
-            float sideY = cabinC.y + cabinH * 0.62f;
-            float sideZ = cabinC.z;
+            AddCenter(glm::vec3(carC.x, plateY + plateH * 0.5f - b * 0.5f, bz - plateT * 0.6f), glm::vec3(0.0f),
+                glm::vec3(plateW, b, b), borderCol);
+            AddCenter(glm::vec3(carC.x, plateY - plateH * 0.5f + b * 0.5f, bz - plateT * 0.6f), glm::vec3(0.0f),
+                glm::vec3(plateW, b, b), borderCol);
 
-            glm::vec3 sideGlassCol(0.55f, 0.78f, 0.98f);
+            float digitW = 0.06f * CAR_SCALE;
+            float digitH = plateH * 0.70f;
+            float digitT = 0.03f * CAR_SCALE;
+            float spacing2 = 0.16f * CAR_SCALE;
+            float startX2 = carC.x - spacing2 * 1.5f;
 
-            AddCenter(glm::vec3(xL_glass, sideY, sideZ),
-                glm::vec3(0.0f),
-                glm::vec3(sideGlassT, sideWinH, sideWinL),
-                sideGlassCol);
+            for (int i = 0; i < 4; ++i) {
+                float xx = startX2 + spacing2 * i;
 
-            AddCenter(glm::vec3(xR_glass, sideY, sideZ),
-                glm::vec3(0.0f),
-                glm::vec3(sideGlassT, sideWinH, sideWinL),
-                sideGlassCol);
+                AddCenter(glm::vec3(xx, plateY, fz + plateT * 0.55f), glm::vec3(0.0f),
+                    glm::vec3(digitW, digitH, digitT), borderCol);
 
-            {
-                glm::vec3 dividerCol = carGreenDark * 0.85f;
+                AddCenter(glm::vec3(xx, plateY, bz - plateT * 0.55f), glm::vec3(0.0f),
+                    glm::vec3(digitW, digitH, digitT), borderCol);
+            }
+        }
+    }
+}
 
-                float divT = sideGlassT + 0.02f * CAR_SCALE;
-                float divW = 0.10f * CAR_SCALE;
+void BuildClouds(const LotLayout& L) {
+    float overlayY = L.overlayY;
+    glm::vec3 center = L.center;
 
-                float splitZ = cabinC.z + cabinL * 0.10f;
+    glm::vec3 cloudColor(0.95f, 0.95f, 0.97f);
+    float cloudY = overlayY + 30.0f;
 
-                float pillarBaseY = baseY - 0.01f * CAR_SCALE;
-                float pillarTopY = (cabinC.y + cabinH * 0.88f);
+    // One unit-size cloud; each placement scales it uniformly.
+    uint32_t cloudPrefab = DefinePrefab({ PREFAB_CLOUD }, [&] {
+        AddCenter(glm::vec3(0.0f), glm::vec3(0.0f),
+            glm::vec3(10.0f, 2.5f, 6.0f),
+            cloudColor, MESH_SPHERE);
 
-                float divH = pillarTopY - pillarBaseY;
-                if (divH < 0.05f) divH = 0.05f;
+        AddCenter(glm::vec3(-4.0f, 0.8f, 0.0f), glm::vec3(0.0f),
+            glm::vec3(7.0f, 2.0f, 5.0f),
+            cloudColor, MESH_SPHERE);
 
-                float divEps2 = 0.012f * CAR_SCALE;
-                float xLL = cabinC.x - (cabinW * 0.5f + divEps2);
-                float xRR = cabinC.x + (cabinW * 0.5f + divEps2);
+        AddCenter(glm::vec3(4.5f, 0.4f, -1.0f), glm::vec3(0.0f),
+            glm::vec3(6.5f, 1.8f, 4.8f),
+            cloudColor, MESH_SPHERE);
 
-                AddBottom(glm::vec3(xLL, pillarBaseY, splitZ),
-                    glm::vec3(0.0f),
-                    glm::vec3(divT, divH, divW),
-                    dividerCol);
+        AddCenter(glm::vec3(0.0f, -0.4f, 2.0f), glm::vec3(0.0f),
+            glm::vec3(8.0f, 1.6f, 5.8f),
+            cloudColor, MESH_SPHERE);
+        });
 
-                AddBottom(glm::vec3(xRR, pillarBaseY, splitZ),
-                    glm::vec3(0.0f),
-                    glm::vec3(divT, divH, divW),
-                    dividerCol);
-            }
+    auto AddCloud = [&](glm::vec3 c, float s) {
+        AddPrefabInstance(cloudPrefab, MakeModel_TRS(c, glm::vec3(0.0f), glm::vec3(s)));
+        };
 
-            {
-                glm::vec3 glassCol(0.55f, 0.78f, 0.98f);
+    int cloudCount = 27;
+    float halfGroundCloud = WC::GROUND_SIZE * 0.5f - 10.0f;
 
-                float glassT = 0.10f * CAR_SCALE;
-                float winW = cabinW * 0.78f;
-                float winH = cabinH * 0.90f;
+    Pcg32 cloudRng = MakeRng(L.seed, RngStream::Clouds);
+    for (int i = 0; i < cloudCount; ++i) {
+        float rx = (float)(cloudRng.Int((int)(halfGroundCloud * 2.0f)) - (int)halfGroundCloud);
+        float rz = (float)(cloudRng.Int((int)(halfGroundCloud * 2.0f)) - (int)halfGroundCloud);
 
-                float yv = cabinC.y + cabinH * 0.52f;
-                float zv = cabinC.z + cabinL * 0.5f + 0.04f * CAR_SCALE;
+        float xx = center.x + rx;
+        float zz = center.z + rz;
 
-                glm::vec3 rot(glm::radians(-12.0f), 0.0f, 0.0f);
+        float yy = cloudY + (float)(cloudRng.Int(25) - 10);
+        float ss = 0.8f + (float)cloudRng.Int(60) / 100.0f;
 
-                AddCenter(glm::vec3(cabinC.x, yv, zv),
-                    rot,
-                    glm::vec3(winW, winH, glassT),
-                    glassCol);
-            }
+        // Drifts along x over the lot and comes back in on the far side;
+        // the big ones are slower.
+        MotionScope drift(Anim{ rx + halfGroundCloud, 2.4f / ss, MOTION_DRIFT, halfGroundCloud * 2.0f, glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f) });
+        AddCloud(glm::vec3(xx, yy, zz), ss);
+    }
+}
 
-            {
-                glm::vec3 wiperCol(0.06f, 0.06f, 0.06f);
+// Ground the grass field (see GrassField) keeps bare on a lot: the yard, the
+// road and the house, as (min x, min z, max x, max z) about the lot center.
+void GrassExclusions(const LotLayout& L, glm::vec4 out[3]) {
+    glm::vec2 c(L.center.x, L.center.z);
+    glm::vec2 yard(L.fenceHalfW + 1.0f, L.fenceHalfL + 1.0f);
+    out[0] = glm::vec4(-yard, yard);
+    out[1] = glm::vec4(L.gateCenterX - L.roadW * 0.6f - c.x, L.frontFenceOuterZ - 1.0f - c.y,
+        L.gateCenterX + L.roadW * 0.6f - c.x, L.frontFenceOuterZ + L.roadL + 1.0f - c.y);
+    glm::vec2 house = glm::vec2(L.houseCenter.x, L.houseCenter.z) - c;
+    glm::vec2 houseHalf = glm::vec2(L.W1 + 2.4f * L.houseScale, L.D1 + 2.2f * L.houseScale) * 0.5f;
+    out[2] = glm::vec4(house - houseHalf, house + houseHalf);
+}
 
-                float winW = cabinW * 0.78f;
-                float winH = cabinH * 0.90f;
+// The GPU scatter's version of BuildVegetation's rules, as rects about the
+// lot center: yard, road, the ring by the fence pines keep out of, and the
+// areas pines and flowers are scattered over.
+void ScatterAreas(const LotLayout& L, glm::vec4 out[5]) {
+    glm::vec2 c(L.center.x, L.center.z);
+    glm::vec2 fence(L.fenceHalfW, L.fenceHalfL);
+    float halfG = WC::GROUND_SIZE * 0.5f - 8.0f;
+    out[0] = glm::vec4(-fence - 2.0f, fence + 2.0f);
+    out[1] = glm::vec4(L.gateCenterX - L.roadW * 0.70f - c.x, L.frontFenceOuterZ - 1.0f - c.y,
+        L.gateCenterX + L.roadW * 0.70f - c.x, L.frontFenceOuterZ + L.roadL + 1.0f - c.y);
+    out[2] = glm::vec4(-fence - glm::vec2(22.0f, 18.0f), fence + glm::vec2(22.0f, 18.0f));
+    out[3] = glm::vec4(-fence - glm::vec2(47.0f, 48.0f), fence + glm::vec2(47.0f, 48.0f));
+    out[4] = glm::vec4(-halfG, -halfG, halfG, halfG);
+}
 
-                float yv = cabinC.y + cabinH * 0.52f;
-                float zv = cabinC.z + cabinL * 0.5f + 0.04f * CAR_SCALE;
+void BuildVegetation(const LotLayout& L) {
+    glm::vec3 center = L.center;
+    float fenceHalfW = L.fenceHalfW;
+    float fenceHalfL = L.fenceHalfL;
+    float gateCenterX = L.gateCenterX;
+    float frontFenceOuterZ = L.frontFenceOuterZ;
+    float roadW = L.roadW;
+    float roadL = L.roadL;
+    float HOUSE_SCALE = L.houseScale;
+    glm::vec3 Hc = L.houseCenter;
+    glm::vec3 carCenter = L.carportCenter;
+    glm::vec3 leafA = L.leaf[0];
+    glm::vec3 leafB = L.leaf[1];
+    glm::vec3 leafC = L.leaf[2];
+
+    ScatterField vegetation(ScatterRect::FromCenter(center.x, center.z, WC::GROUND_SIZE * 0.5f, WC::GROUND_SIZE * 0.5f), 1.0f);
+    vegetation.AddExclusion(ScatterRect::FromCenter(center.x, center.z, fenceHalfW + 2.0f, fenceHalfL + 2.0f), SCATTER_YARD);
+    vegetation.AddExclusion({ gateCenterX - roadW * 0.70f, frontFenceOuterZ - 1.0f,
+        gateCenterX + roadW * 0.70f, frontFenceOuterZ + roadL + 1.0f }, SCATTER_ROAD);
+    vegetation.AddExclusion(ScatterRect::FromCenter(center.x, center.z, fenceHalfW + 22.0f, fenceHalfL + 18.0f), SCATTER_NEAR_FENCE);
+    vegetation.AddExclusion(ScatterRect::FromCenter(Hc.x, Hc.z,
+        (L.W1 + 2.4f * HOUSE_SCALE) * 0.5f, (L.D1 + 2.2f * HOUSE_SCALE) * 0.5f), SCATTER_HOUSE);
+    vegetation.AddExclusion(ScatterRect::FromCenter(carCenter.x, carCenter.z,
+        L.carportW * 0.5f + L.carportOver, L.carportD * 0.5f + L.carportOver), SCATTER_HOUSE);
+
+    for (const PineSpot& p : L.pines) {
+        AddPine(glm::vec3(p.base.x, LotGroundY(L, p.base.x, p.base.z, p.trunkW * 0.5f), p.base.z), p.trunkH, p.trunkW, p.leaf);
+        vegetation.Insert(p.base.x, p.base.z, p.trunkW * 6.2f);
+    }
+    // Lamp posts are built by BuildStreetLights; only their footprints are reserved here.
+    for (const StreetLightSpot& s : L.streetLights) vegetation.Insert(s.base.x, s.base.z, s.poleW * 3.6f);
+    if (L.gpuScatter) return;
+
+    {
+        Pcg32 pineRng = MakeRng(L.seed, RngStream::Pines);
+
+        ScatterSpecies pineRing;
+        pineRing.minSpacing = 7.0f;
+        pineRing.density = 1.0f / 1600.0f;
+        pineRing.mask = SCATTER_YARD | SCATTER_ROAD | SCATTER_NEAR_FENCE;
+
+        std::vector<ScatterPoint> pines;
+        vegetation.Scatter(pineRing, ScatterRect::FromCenter(center.x, center.z, fenceHalfW + 47.0f, fenceHalfL + 48.0f),
+            pineRng, pines);
+
+        for (const ScatterPoint& p : pines) {
+            float h = 5.8f + (float)pineRng.Int(20) / 10.0f;
+            float w = 0.82f + (float)pineRng.Int(18) / 100.0f;
+            glm::vec3 lc = (pineRng.Int(3) == 0) ? leafA : (pineRng.Coin() ? leafB : leafC);
+            AddPine(glm::vec3(p.x, LotGroundY(L, p.x, p.z, w * 0.5f), p.z), h, w, lc);
+        }
+    }
 
-                glm::vec3 wsRot(glm::radians(-12.0f), 0.0f, 0.0f);
+    float halfG = WC::GROUND_SIZE * 0.5f - 8.0f;
+
+    glm::vec3 stemCol = WC::COL_FLOWER_STEM;
+    glm::vec3 flowerRed = WC::COL_FLOWER_RED;
+    glm::vec3 flowerYellow = WC::COL_FLOWER_YELLOW;
+
+    ScatterSpecies flower;
+    flower.minSpacing = 1.2f;
+    flower.density = 1.0f / 200.0f;
+    flower.mask = SCATTER_YARD | SCATTER_ROAD | SCATTER_HOUSE;
+
+    Pcg32 flowerRng = MakeRng(L.seed, RngStream::Flowers);
+    std::vector<ScatterPoint> flowers;
+    vegetation.Scatter(flower, ScatterRect::FromCenter(center.x, center.z, halfG, halfG), flowerRng, flowers);
+
+    // The stems and petals of every flower go through the batch builders
+    // first; the items are added after, a stem and a petal per flower.
+    TransformBatch stems, petals;
+    stems.Reserve(flowers.size());
+    petals.Reserve(flowers.size());
+    std::vector<glm::vec3> petalCols(flowers.size());
+    std::vector<float> groundY(flowers.size());
+    for (size_t i = 0; i < flowers.size(); ++i) {
+        float fx = flowers[i].x;
+        float fz = flowers[i].z;
+
+        float stemH = 0.52f + (float)flowerRng.Int(22) / 100.0f;
+        float stemW = 0.11f;
+
+        petalCols[i] = flowerRng.Coin() ? flowerRed : flowerYellow;
+        float fy = LotGroundY(L, fx, fz, stemW * 0.5f);
+        groundY[i] = fy;
+
+        stems.Add(glm::vec3(fx, fy + 0.001f, fz), glm::vec3(0.0f), glm::vec3(stemW, stemH, stemW));
+        petals.Add(glm::vec3(fx, fy + stemH + 0.10f, fz), glm::vec3(0.0f), glm::vec3(0.46f, 0.20f, 0.46f));
+    }
+    std::vector<glm::mat4> stemModels(flowers.size()), petalModels(flowers.size());
+    MakeModels_BottomPivot(stems.View(), stemModels.data());
+    MakeModels_CenterPivot(petals.View(), petalModels.data());
+    for (size_t i = 0; i < flowers.size(); ++i) {
+        WindScope sway(WC::WIND_STIFFNESS_FLOWER, groundY[i]);
+        AddItem(stemModels[i], stemCol);
+        AddItem(petalModels[i], petalCols[i]);
+    }
+}
 
-                glm::vec3 base = glm::vec3(cabinC.x, yv - winH * 0.42f, zv + 0.15f * CAR_SCALE);
+using SceneBuilder = void (*)(const LotLayout&);
+
+// Runs every builder of every lot into its own buffer (on the pool unless
+// threads == 1) and concatenates them in a fixed order, lot by lot, so the
+// result never depends on scheduling. Prefabs and meshes the builders defined
+// are merged into `prefabs` and `meshes`; LOD group ids are renumbered to be
+// unique across builders.
+SceneWorld BuildScene(const LotLayout* lots, size_t lotCount, unsigned threads, PrefabLibrary& prefabs, MeshLibrary& meshes) {
+    static const SceneBuilder builders[] = {
+        BuildYard, BuildStreetLights, BuildHouse, BuildRack,
+        BuildCarport, BuildClouds, BuildVegetation,
+    };
+    constexpr size_t builderCount = sizeof(builders) / sizeof(builders[0]);
+    const size_t partCount = lotCount * builderCount;
+
+    // Builders stage into their own arenas: chunk memory is bump-allocated and
+    // released in one go once the parts have been merged. Blocks are about one
+    // chunk, since most parts of a large grid hold only a few.
+    std::vector<std::unique_ptr<Arena>> arenas;
+    std::vector<SceneWorld> parts;
+    arenas.reserve(partCount);
+    parts.reserve(partCount);
+    for (size_t i = 0; i < partCount; ++i) {
+        arenas.emplace_back(new Arena(16 * 1024));
+        parts.emplace_back(arenas.back().get());
+    }
+    std::vector<PrefabLibrary> partPrefabs(partCount);
+    std::vector<MeshLibrary> partMeshes;
+    partMeshes.reserve(partCount);
+    for (size_t i = 0; i < partCount; ++i) partMeshes.emplace_back(0);
+    std::vector<uint32_t> partLodGroups(partCount, 0);
+
+    auto run = [&](size_t i) {
+        BuildTarget target(parts[i], partPrefabs[i], partMeshes[i], partLodGroups[i]);
+        builders[i % builderCount](lots[i / builderCount]);
+    };
 
-                float bladeT = 0.05f * CAR_SCALE;
-                float bladeH = 0.04f * CAR_SCALE;
-                float bladeL = winW * 0.42f;
+    if (threads == 1) {
+        for (size_t i = 0; i < partCount; ++i) run(i);
+    }
+    else {
+        ThreadPool pool((unsigned)std::min<size_t>(threads ? threads : ThreadPool::DefaultThreads(), partCount));
+        std::vector<std::future<void>> done;
+        done.reserve(partCount);
+        for (size_t i = 0; i < partCount; ++i) {
+            done.push_back(pool.Submit([&run, i] { run(i); }));
+        }
+        for (auto& f : done) f.get();
+    }
 
-                float armT = 0.04f * CAR_SCALE;
-                float armH = 0.04f * CAR_SCALE;
-                float armL = winW * 0.18f;
+    // Every part is complete here, so the final world's chunks can be sized
+    // exactly per archetype before anything is copied.
+    std::vector<std::pair<uint32_t, size_t>> totals;
+    for (const SceneWorld& p : parts) {
+        p.ForEachArchetype([&](uint32_t mask, size_t n) {
+            auto it = std::find_if(totals.begin(), totals.end(), [mask](const auto& t) { return t.first == mask; });
+            if (it == totals.end()) totals.push_back({ mask, n });
+            else it->second += n;
+        });
+    }
 
-                {
-                    float xOff = -winW * 0.18f;
-                    glm::vec3 p = base + glm::vec3(xOff, 0.00f, 0.00f);
+    // Built meshes and prefab ids are local to the builder that made them
+    // until shifted by that builder's offset in the merged library. Every mesh
+    // gets its bare prefab first, so a plain item's mesh id is also its prefab id.
+    std::vector<uint32_t> meshOffsets(partCount);
+    for (size_t i = 0; i < partCount; ++i) meshOffsets[i] = meshes.Append(partMeshes[i]);
+    prefabs.AddBareMeshes((uint32_t)meshes.Count());
+    uint32_t lodGroupOffset = 0;
+    for (size_t i = 0; i < partCount; ++i) {
+        std::vector<uint32_t> remap = prefabs.Append(partPrefabs[i], meshOffsets[i]);
+        parts[i].ForEachChunk(PrefabRef::Bit, [&](const SceneWorld::ChunkView& c) {
+            PrefabRef* ref = c.Column<PrefabRef>();
+            for (uint32_t r = 0; r < c.Count(); ++r) ref[r].prefab = remap[ref[r].prefab];
+            });
+        parts[i].ForEachChunk(Lod::Bit, [&](const SceneWorld::ChunkView& c) {
+            Lod* lod = c.Column<Lod>();
+            for (uint32_t r = 0; r < c.Count(); ++r) lod[r].group += lodGroupOffset;
+            });
+        lodGroupOffset += partLodGroups[i];
+        if (meshOffsets[i] == 0) continue;
+        parts[i].ForEachChunk(MeshRef::Bit, [&](const SceneWorld::ChunkView& c) {
+            MeshRef* ref = c.Column<MeshRef>();
+            for (uint32_t r = 0; r < c.Count(); ++r) {
+                if (ref[r].mesh >= MESH_PRIMITIVE_COUNT) ref[r].mesh += meshOffsets[i];
+            }
+            });
+    }
 
-                    AddCenter(p + glm::vec3(-armL * 0.20f, 0.01f * CAR_SCALE, 0.00f),
-                        wsRot + glm::vec3(0.0f, 0.0f, glm::radians(18.0f)),
-                        glm::vec3(armL, armH, armT),
-                        wiperCol);
+    SceneWorld world;
+    for (const auto& t : totals) world.Reserve(t.first, t.second);
+    for (const SceneWorld& p : parts) world.Append(p);
+    return world;
+}
 
-                    AddCenter(p,
-                        wsRot + glm::vec3(0.0f, 0.0f, glm::radians(18.0f)),
-                        glm::vec3(bladeL, bladeH, bladeT),
-                        wiperCol);
+// Bakes every LOD group into simplified proxies. A group's items are merged in
+// world space, welded per color so materials never blend, and simplified level
+// by level with budgets from LOD_ERROR_FRACTIONS. Each level becomes a prefab
+// with one flat-shaded mesh per remaining color, placed by one entity of that
+// level. Runs before MeshLibrary::Optimize, which then covers the proxies too.
+// `keyTag` goes into the proxy prefab keys, so proxies baked one lot at a time
+// only share a key when the lots do (the lot style).
+std::vector<LodGroup> BakeLodGroups(SceneWorld& world, PrefabLibrary& prefabs, MeshLibrary& meshes, uint32_t keyTag = 0) {
+    uint32_t groupCount = 0;
+    world.ForEachChunk(Lod::Bit, [&](const SceneWorld::ChunkView& c) {
+        const Lod* lod = c.Column<Lod>();
+        for (uint32_t r = 0; r < c.Count(); ++r) groupCount = std::max(groupCount, lod[r].group + 1);
+        });
+    std::vector<LodGroup> groups(groupCount);
+    if (groupCount == 0) return groups;
+
+    // Every triangle corner of every group, in world space.
+    struct Corner {
+        uint32_t group;
+        uint32_t color;
+        glm::vec3 pos;
+    };
+    std::vector<Corner> corners;
+    std::vector<glm::vec3> colors;
+    auto ColorId = [&](const glm::vec3& c) {
+        auto it = std::find(colors.begin(), colors.end(), c);
+        if (it != colors.end()) return (uint32_t)(it - colors.begin());
+        colors.push_back(c);
+        return (uint32_t)colors.size() - 1;
+    };
+    auto AddMesh = [&](uint32_t group, const glm::mat4& model, uint32_t mesh, const glm::vec3& color) {
+        const MeshRange& r = meshes.Range(mesh);
+        uint32_t col = ColorId(color);
+        bool mirrored = glm::determinant(glm::mat3(model)) < 0.0f;
+        for (uint32_t i = 0; i < r.indexCount; i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = meshes.Indices()[r.firstIndex + i + (mirrored && k > 0 ? 3 - k : k)];
+                corners.push_back({ group, col, glm::vec3(model * glm::vec4(meshes.Vertices()[v].pos, 1.0f)) });
+            }
+        }
+    };
+    world.ForEachChunk(Transform::Bit | Lod::Bit, [&](const SceneWorld::ChunkView& c) {
+        const Transform* xf = c.Column<Transform>();
+        const Lod* lod = c.Column<Lod>();
+        const Material* mat = c.Has(Material::Bit) ? c.Column<Material>() : nullptr;
+        const MeshRef* mesh = c.Has(MeshRef::Bit) ? c.Column<MeshRef>() : nullptr;
+        const PrefabRef* ref = c.Has(PrefabRef::Bit) ? c.Column<PrefabRef>() : nullptr;
+        for (uint32_t i = 0; i < c.Count(); ++i) {
+            if (lod[i].level != 0) continue;
+            if (mesh) {
+                AddMesh(lod[i].group, xf[i].model, mesh[i].mesh, mat ? mat[i].color : glm::vec3(1.0f));
+            }
+            else if (ref) {
+                const Prefab& p = prefabs.Get(ref[i].prefab);
+                for (uint32_t b = 0; b < p.boxCount; ++b) {
+                    const PrefabBox& box = prefabs.Box(p.firstBox + b);
+                    AddMesh(lod[i].group, xf[i].model * box.local, box.mesh, box.color);
                 }
+            }
+        }
+        });
+
+    // Weld: one vertex per (group, color, position), groups laid out in order.
+    std::vector<uint32_t> order(corners.size());
+    for (uint32_t i = 0; i < (uint32_t)order.size(); ++i) order[i] = i;
+    auto Key = [&](const Corner& c) { return std::make_tuple(c.group, c.color, c.pos.x, c.pos.y, c.pos.z); };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return Key(corners[a]) < Key(corners[b]); });
+    std::vector<uint32_t> vertexOf(corners.size());
+    std::vector<uint32_t> groupFirstVertex(groupCount + 1, 0);
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> vertexColor;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Corner& c = corners[order[i]];
+        if (i == 0 || Key(c) != Key(corners[order[i - 1]])) {
+            positions.push_back(c.pos);
+            vertexColor.push_back(c.color);
+            groupFirstVertex[c.group + 1] = (uint32_t)positions.size();
+        }
+        vertexOf[order[i]] = (uint32_t)positions.size() - 1;
+    }
+    for (uint32_t g = 0; g < groupCount; ++g) groupFirstVertex[g + 1] = std::max(groupFirstVertex[g + 1], groupFirstVertex[g]);
+
+    std::vector<std::vector<uint32_t>> groupIndices(groupCount);
+    for (size_t i = 0; i < corners.size(); ++i) groupIndices[corners[i].group].push_back(vertexOf[i] - groupFirstVertex[corners[i].group]);
+
+    std::vector<MeshBuilder> builders;
+    std::unordered_map<uint64_t, uint32_t> corner;
+    std::vector<PrefabBox> boxes;
+    for (uint32_t g = 0; g < groupCount; ++g) {
+        LodGroup& group = groups[g];
+        const glm::vec3* pos = positions.data() + groupFirstVertex[g];
+        const uint32_t* col = vertexColor.data() + groupFirstVertex[g];
+        uint32_t vertexCount = groupFirstVertex[g + 1] - groupFirstVertex[g];
+        const std::vector<uint32_t>& idx = groupIndices[g];
+        if (idx.empty()) continue;
+
+        glm::vec3 mn(1e30f), mx(-1e30f);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            mn = glm::min(mn, pos[v]);
+            mx = glm::max(mx, pos[v]);
+        }
+        group.center = 0.5f * (mn + mx);
+        group.radius = 0.5f * glm::length(mx - mn);
+        group.triangles[0] = (uint32_t)idx.size() / 3;
+
+        // A budget that removes nothing more gives no level of its own.
+        MeshSimplifier simplifier(pos, vertexCount, idx.data(), idx.size());
+        for (uint32_t budget = 0; budget + 1 < LOD_LEVELS; ++budget) {
+            float error = simplifier.Simplify(group.radius * LOD_ERROR_FRACTIONS[budget]);
+            if (simplifier.TriangleCount() == group.triangles[group.levelCount - 1]) continue;
+            uint32_t level = group.levelCount++;
+            group.error[level] = error;
+            group.triangles[level] = (uint32_t)simplifier.TriangleCount();
+
+            // Flat normals: corners share a vertex only within one face plane.
+            builders.assign(colors.size(), MeshBuilder());
+            corner.clear();
+            const std::vector<uint32_t>& tris = simplifier.Indices();
+            for (size_t t = 0; t < tris.size(); t += 3) {
+                const uint32_t* tri = &tris[t];
+                glm::vec3 n = glm::cross(pos[tri[1]] - pos[tri[0]], pos[tri[2]] - pos[tri[0]]);
+                float len = glm::length(n);
+                if (len <= 0.0f) continue;
+                n /= len;
+                uint64_t qn = 0;
+                for (int k = 0; k < 3; ++k) qn = qn << 10 | (uint64_t)(std::lround(n[k] * 511.0f) + 511);
+                MeshBuilder& b = builders[col[tri[0]]];
+                uint32_t out[3];
+                for (int k = 0; k < 3; ++k) {
+                    uint64_t key = (uint64_t)tri[k] << 30 | qn;
+                    auto it = corner.find(key);
+                    if (it == corner.end()) it = corner.emplace(key, b.Vertex(pos[tri[k]], n)).first;
+                    out[k] = it->second;
+                }
+                b.Tri(out[0], out[1], out[2]);
+            }
 
-                {
-                    float xOff = +winW * 0.18f;
-                    glm::vec3 p = base + glm::vec3(xOff, 0.00f, 0.00f);
-
-                    AddCenter(p + glm::vec3(+armL * 0.20f, 0.01f * CAR_SCALE, 0.00f),
-                        wsRot + glm::vec3(0.0f, 0.0f, glm::radians(-18.0f)),
-                        glm::vec3(armL, armH, armT),
-                        wiperCol);
+            boxes.clear();
+            for (size_t c = 0; c < builders.size(); ++c) {
+                if (builders[c].i.empty()) continue;
+                glm::mat4 local = builders[c].FitUnitCube();
+                boxes.push_back({ local, colors[c], meshes.Add(builders[c]) });
+            }
+            PrefabKey key;
+            key.kind = PREFAB_LOD_PROXY;
+            key.params[0] = (float)g;
+            key.params[1] = (float)level;
+            key.params[2] = (float)keyTag;
+            uint32_t prefab = prefabs.Add(key, boxes.data(), boxes.size());
+
+            Entity e = world.Create(Transform::Bit | Bounds::Bit | Layer::Bit | PrefabRef::Bit | Lod::Bit);
+            world.Get<Transform>(e)->model = glm::mat4(1.0f);
+            *world.Get<Bounds>(e) = { mn, mx };
+            world.Get<Layer>(e)->flags = LAYER_STATIC | LAYER_CAST_SHADOW;
+            world.Get<PrefabRef>(e)->prefab = prefab;
+            *world.Get<Lod>(e) = { g, level };
+        }
+    }
+    return groups;
+}
 
-                    AddCenter(p,
-                        wsRot + glm::vec3(0.0f, 0.0f, glm::radians(-18.0f)),
-                        glm::vec3(bladeL, bladeH, bladeT),
-                        wiperCol);
-                }
+// One impostor per lot, standing in for the LOD groups of that lot (the house,
+// doghouse and carport; the car is dynamic and drawn on its own). Lots of one style build identical groups, so
+// they share an atlas layer, keyed by the style plus everything the capture
+// of its first lot draws (relative to that lot), the capture shaders and the
+// light: a cached atlas is only reused for identical content. Captures light
+// every lot from `lightOffset` above its own center, like a sun.
+std::vector<Impostor> MakeImpostors(SceneWorld& world, const PrefabLibrary& prefabs, const MeshLibrary& meshes,
+    const std::vector<LodGroup>& groups, const LotLayout* lots, size_t lotCount, const glm::vec3& lightOffset)
+{
+    // A group belongs to the lot whose center is nearest; the carport may sit
+    // outside the fence.
+    std::vector<uint32_t> groupLot(groups.size(), ~0u);
+    for (uint32_t g = 0; g < (uint32_t)groups.size() && lotCount > 0; ++g) {
+        if (groups[g].radius <= 0.0f) continue;
+        float bestD = 1e30f;
+        for (size_t l = 0; l < lotCount; ++l) {
+            glm::vec2 d(groups[g].center.x - lots[l].center.x, groups[g].center.z - lots[l].center.z);
+            if (glm::dot(d, d) < bestD) {
+                bestD = glm::dot(d, d);
+                groupLot[g] = (uint32_t)l;
             }
+        }
+    }
 
-            {
-                glm::vec3 mirrorBody(0.10f, 0.10f, 0.10f);
-                glm::vec3 mirrorGlass(0.70f, 0.85f, 0.95f);
+    std::vector<uint64_t> groupHash(groups.size(), HASH_SEED);
+    auto HashMesh = [&](uint64_t h, uint32_t mesh) {
+        const MeshRange& r = meshes.Range(mesh);
+        h = HashBytes(h, meshes.Vertices().data() + r.firstVertex, r.vertexCount * sizeof(MeshVertex));
+        for (uint32_t i = 0; i < r.indexCount; ++i) {
+            uint32_t v = meshes.Indices()[r.firstIndex + i] - r.firstVertex;
+            h = HashBytes(h, &v, sizeof(v));
+        }
+        return h;
+    };
+    world.ForEachChunk(Transform::Bit | Lod::Bit, [&](const SceneWorld::ChunkView& c) {
+        const Transform* xf = c.Column<Transform>();
+        const Lod* lod = c.Column<Lod>();
+        const Material* mat = c.Has(Material::Bit) ? c.Column<Material>() : nullptr;
+        const MeshRef* mesh = c.Has(MeshRef::Bit) ? c.Column<MeshRef>() : nullptr;
+        const PrefabRef* ref = c.Has(PrefabRef::Bit) ? c.Column<PrefabRef>() : nullptr;
+        for (uint32_t i = 0; i < c.Count(); ++i) {
+            uint32_t g = lod[i].group;
+            if (lod[i].level != 0 || groupLot[g] == ~0u) continue;
+            glm::mat4 model = xf[i].model;
+            model[3] = model[3] - glm::vec4(lots[groupLot[g]].center, 0.0f);
+            uint64_t& h = groupHash[g];
+            h = HashBytes(h, &model, sizeof(glm::mat4));
+            if (mat) h = HashBytes(h, &mat[i].color, sizeof(glm::vec3));
+            if (mesh) h = HashMesh(h, mesh[i].mesh);
+            if (!ref) continue;
+            const Prefab& p = prefabs.Get(ref[i].prefab);
+            for (uint32_t b = 0; b < p.boxCount; ++b) {
+                const PrefabBox& box = prefabs.Box(p.firstBox + b);
+                h = HashBytes(h, &box.local, sizeof(glm::mat4));
+                h = HashBytes(h, &box.color, sizeof(glm::vec3));
+                h = HashMesh(h, box.mesh);
+            }
+        }
+        });
 
-                float yv = cabinC.y + cabinH * 0.58f;
-                float zv = carC.z + bodyL * 0.5f - 1.60f * CAR_SCALE;
+    uint64_t settings = HashBytes(HASH_SEED, vertexShaderSrc, std::strlen(vertexShaderSrc));
+    settings = HashBytes(settings, captureFragmentShaderSrc, std::strlen(captureFragmentShaderSrc));
+    settings = HashBytes(settings, &lightOffset, sizeof(lightOffset));
 
-                float out = 0.18f * CAR_SCALE;
+    std::vector<std::vector<uint32_t>> lotGroups(lotCount);
+    for (uint32_t g = 0; g < (uint32_t)groups.size(); ++g) {
+        if (groupLot[g] != ~0u) lotGroups[groupLot[g]].push_back(g);
+    }
 
-                float armLen = 0.22f * CAR_SCALE;
-                float armThk = 0.06f * CAR_SCALE;
-                float armH = 0.08f * CAR_SCALE;
+    std::vector<Impostor> impostors;
+    std::unordered_map<uint64_t, uint32_t> layerOf;
+    std::vector<uint64_t> layerKeys;
+    for (size_t l = 0; l < lotCount; ++l) {
+        if (lotGroups[l].empty()) continue;
+        Impostor imp;
+        imp.groups = lotGroups[l];
+        imp.origin = lots[l].center;
+        uint64_t style = HashBytes(settings, &lots[l].style, sizeof(LotStyle));
+        auto it = layerOf.find(style);
+        if (it == layerOf.end()) {
+            uint64_t key = style;
+            for (uint32_t g : imp.groups) key = HashBytes(key, &groupHash[g], sizeof(uint64_t));
+            it = layerOf.emplace(style, (uint32_t)layerKeys.size()).first;
+            layerKeys.push_back(key);
+        }
+        imp.layer = it->second;
+        imp.key = layerKeys[imp.layer];
+        glm::vec3 mn(1e30f), mx(-1e30f);
+        for (uint32_t g : imp.groups) {
+            mn = glm::min(mn, groups[g].center - glm::vec3(groups[g].radius));
+            mx = glm::max(mx, groups[g].center + glm::vec3(groups[g].radius));
+        }
+        imp.center = 0.5f * (mn + mx);
+        for (uint32_t g : imp.groups) imp.radius = std::max(imp.radius, glm::length(groups[g].center - imp.center) + groups[g].radius);
+        impostors.push_back(std::move(imp));
+    }
+    return impostors;
+}
 
-                float housW = 0.30f * CAR_SCALE;
-                float housH = 0.20f * CAR_SCALE;
-                float housD = 0.16f * CAR_SCALE;
+// Lot (x, z) of a countX x countZ grid tiling GROUND_SIZE squares around
+// `center`: its seed and its center.
+uint64_t GridLotSeed(uint64_t seed, int x, int z, int countX) {
+    return MixSeed(seed, (uint64_t)z * countX + x);
+}
 
-                float glassInset = 0.01f * CAR_SCALE;
+glm::vec3 GridLotCenter(const glm::vec3& center, int x, int z, int countX, int countZ) {
+    return center + glm::vec3((float)(x - countX / 2), 0.0f, (float)(z - countZ / 2)) * WC::GROUND_SIZE;
+}
 
-                {
-                    float xSide = cabinC.x - (cabinW * 0.5f + out);
+// One streamed lot, built off the main thread. Prefab, mesh and LOD group ids
+// of its items are local to the libraries and groups built with it.
+struct LotBuild {
+    explicit LotBuild(const LotLayout& L) : world(BuildScene(&L, 1, 1, prefabs, meshes)) {}
 
-                    AddCenter(glm::vec3(xSide + armLen * 0.45f, yv, zv),
-                        glm::vec3(0.0f),
-                        glm::vec3(armLen, armH, armThk),
-                        mirrorBody);
+    PrefabLibrary prefabs;
+    MeshLibrary meshes;
+    SceneWorld world;
+    std::vector<LodGroup> lodGroups;
+};
 
-                    AddCenter(glm::vec3(xSide, yv, zv),
-                        glm::vec3(0.0f),
-                        glm::vec3(housW, housH, housD),
-                        mirrorBody);
+// Builds, bakes and optimizes a lot in full on the calling thread. It is built
+// around `L.center` and moved by `offset` afterwards, so lots of one style
+// bake byte-identical meshes and proxies, which the main thread then shares.
+// Only heights off the terrain depend on where it ends up.
+std::unique_ptr<LotBuild> BuildStreamedLot(LotLayout L, const glm::vec3& offset) {
+    L.buildOffset = offset;
+    std::unique_ptr<LotBuild> b(new LotBuild(L));
+    b->lodGroups = BakeLodGroups(b->world, b->prefabs, b->meshes, L.style.id + 1);
+    b->meshes.Optimize(16, MESH_PRIMITIVE_COUNT);
+    b->meshes.BakeMeshlets(MESH_PRIMITIVE_COUNT);
+
+    glm::vec4 shift(offset, 0.0f);
+    b->world.ForEachChunk(Transform::Bit | Bounds::Bit, [&](const SceneWorld::ChunkView& c) {
+        Transform* xf = c.Column<Transform>();
+        Bounds* bb = c.Column<Bounds>();
+        for (uint32_t i = 0; i < c.Count(); ++i) {
+            xf[i].model[3] = xf[i].model[3] + shift;
+            bb[i].min += offset;
+            bb[i].max += offset;
+        }
+        });
+    // Motion runs from the rest position, so it moves with the lot too. A
+    // pivot's rest is its node's local translation, which only moves for
+    // root nodes.
+    TransformHierarchy& nodes = b->world.Nodes();
+    nodes.Translate(offset);
+    b->world.ForEachChunk(Anim::Bit, [&](const SceneWorld::ChunkView& c) {
+        Anim* anim = c.Column<Anim>();
+        const Pivot* pivot = c.Has(Pivot::Bit) ? c.Column<Pivot>() : nullptr;
+        for (uint32_t i = 0; i < c.Count(); ++i) {
+            if (!pivot || nodes.ParentOf(pivot[i].node) == TransformHierarchy::NONE) anim[i].rest += offset;
+        }
+        });
+    for (LodGroup& g : b->lodGroups) g.center += offset;
+    return b;
+}
 
-                    AddCenter(glm::vec3(xSide - housW * 0.10f, yv, zv - housD * 0.5f - glassInset),
-                        glm::vec3(0.0f),
-                        glm::vec3(housW * 0.78f, housH * 0.78f, 0.03f * CAR_SCALE),
-                        mirrorGlass);
-                }
+int main(int argc, char** argv) {
+    AppOptions opt;
+    if (!ParseArgs(argc, argv, opt)) return -1;
+    debugView = opt.debugView;
 
-                {
-                    float xSide = cabinC.x + (cabinW * 0.5f + out);
+    std::cout << "[Scene] seed " << opt.seed << "\n";
+    glfwSetErrorCallback(glfw_error_callback);
 
-                    AddCenter(glm::vec3(xSide - armLen * 0.45f, yv, zv),
-                        glm::vec3(0.0f),
-                        glm::vec3(armLen, armH, armThk),
-                        mirrorBody);
+    if (!glfwInit()) {
+        std::cerr << "Failed to init GLFW\n";
+        return -1;
+    }
 
-                    AddCenter(glm::vec3(xSide, yv, zv),
-                        glm::vec3(0.0f),
-                        glm::vec3(housW, housH, housD),
-                        mirrorBody);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-                    AddCenter(glm::vec3(xSide + housW * 0.10f, yv, zv - housD * 0.5f - glassInset),
-                        glm::vec3(0.0f),
-                        glm::vec3(housW * 0.78f, housH * 0.78f, 0.03f * CAR_SCALE),
-                        mirrorGlass);
-                }
-            }
 
-            {
-                glm::vec3 doorLineCol = carGreenDark * 0.95f;
-                glm::vec3 handleCol = glm::vec3(0.10f, 0.10f, 0.10f);
 
-                float doorZ = carC.z + 0.10f * CAR_SCALE;
-                float doorY = carC.y + bodyH * 0.55f;
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = glfwGetVideoMode(monitor);
 
-                float doorH = bodyH * 0.55f;
-                float doorL = bodyL * 0.40f;
-                float panelT = 0.03f * CAR_SCALE;
+    glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    if (opt.capturePath) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
-                float eps = 0.005f * CAR_SCALE;
-                float xL = carC.x - (bodyW * 0.5f + panelT * 0.5f + eps);
-                float xR = carC.x + (bodyW * 0.5f + panelT * 0.5f + eps);
+    const int WIN_W = WC::WIN_W;
+    const int WIN_H = WC::WIN_H;
 
-                AddCenter(glm::vec3(xL, doorY, doorZ),
-                    glm::vec3(0.0f),
-                    glm::vec3(panelT, doorH, doorL),
-                    doorLineCol);
+    GLFWwindow* window = glfwCreateWindow(WIN_W, WIN_H, "Final House with Shadow", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create GLFW window\n";
+        glfwTerminate();
+        return -1;
+    }
 
-                AddCenter(glm::vec3(xR, doorY, doorZ),
-                    glm::vec3(0.0f),
-                    glm::vec3(panelT, doorH, doorL),
-                    doorLineCol);
+    int mx, my;
+    glfwGetMonitorPos(monitor, &mx, &my);
+    int x = mx + (mode->width - WIN_W) / 2;
+    int y = my + (mode->height - WIN_H) / 2;
+    glfwSetWindowPos(window, x, y);
 
-                float handleW = 0.18f * CAR_SCALE;
-                float handleH = 0.05f * CAR_SCALE;
-                float handleT = 0.05f * CAR_SCALE;
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(opt.benchFrames > 0 ? 0 : 1);
 
-                float handleY = doorY + doorH * 0.28f;
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
 
-                float handleZ_F = doorZ + doorL * 0.18f;
-                float handleZ_B = doorZ - doorL * 0.18f;
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to init GLAD\n";
+        glfwTerminate();
+        return -1;
+    }
 
-                AddCenter(glm::vec3(xL - handleT * 0.5f, handleY, handleZ_F),
-                    glm::vec3(0.0f),
-                    glm::vec3(handleT, handleH, handleW),
-                    handleCol);
-                AddCenter(glm::vec3(xL - handleT * 0.5f, handleY, handleZ_B),
-                    glm::vec3(0.0f),
-                    glm::vec3(handleT, handleH, handleW),
-                    handleCol);
+    int fbW, fbH;
+    glfwGetFramebufferSize(window, &fbW, &fbH);
+    glViewport(0, 0, fbW, fbH);
 
-                AddCenter(glm::vec3(xR + handleT * 0.5f, handleY, handleZ_F),
-                    glm::vec3(0.0f),
-                    glm::vec3(handleT, handleH, handleW),
-                    handleCol);
-                AddCenter(glm::vec3(xR + handleT * 0.5f, handleY, handleZ_B),
-                    glm::vec3(0.0f),
-                    glm::vec3(handleT, handleH, handleW),
-                    handleCol);
-            }
+    glEnable(GL_DEPTH_TEST);
 
-            auto AddWheelRing = [&](glm::vec3 wheelC, float radius2, float thickness, glm::vec3 colTire, glm::vec3 colRim) {
-                const int N = 24;
-                for (int i = 0; i < N; ++i) {
-                    float a = (float)i / (float)N * 6.2831853f;
-                    float zc = std::cos(a) * radius2;
-                    float yc = std::sin(a) * radius2;
-                    glm::vec3 p = wheelC + glm::vec3(0.0f, yc, zc);
-
-                    AddCenter(p, glm::vec3(0.0f),
-                        glm::vec3(thickness, radius2 * 0.14f, radius2 * 0.14f),
-                        colTire);
-                }
-                AddCenter(wheelC, glm::vec3(0.0f),
-                    glm::vec3(thickness * 0.75f, radius2 * 0.62f, radius2 * 0.62f),
-                    colRim);
-                };
-
-            float wheelY = baseY + wheelR;
-            float frontZ = carC.z + bodyL * 0.5f - 1.10f * CAR_SCALE;
-            float backZ = carC.z - bodyL * 0.5f + 1.10f * CAR_SCALE;
-
-            float wheelX = bodyW * 0.5f - wheelThk * 0.35f;
-
-            glm::vec3 wFL(carC.x - wheelX, wheelY, frontZ);
-            glm::vec3 wFR(carC.x + wheelX, wheelY, frontZ);
-            glm::vec3 wBL(carC.x - wheelX, wheelY, backZ);
-            glm::vec3 wBR(carC.x + wheelX, wheelY, backZ);
-
-            AddWheelRing(wFL, wheelR, wheelThk, tire, rim);
-            AddWheelRing(wFR, wheelR, wheelThk, tire, rim);
-            AddWheelRing(wBL, wheelR, wheelThk, tire, rim);
-            AddWheelRing(wBR, wheelR, wheelThk, tire, rim);
-
-            float lightZOut = 0.18f * CAR_SCALE;
-
-            float headY = carC.y + 0.48f * CAR_SCALE;
-            float headZ = carC.z + bodyL * 0.5f + lightZOut;
-            AddBottom(glm::vec3(carC.x - 0.90f * CAR_SCALE, headY, headZ),
-                glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), head);
-            AddBottom(glm::vec3(carC.x + 0.90f * CAR_SCALE, headY, headZ),
-                glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), head);
-
-            float tailY = carC.y + 0.48f * CAR_SCALE;
-            float tailZ = carC.z - bodyL * 0.5f - lightZOut;
-            AddBottom(glm::vec3(carC.x - 0.90f * CAR_SCALE, tailY, tailZ),
-                glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), tail);
-            AddBottom(glm::vec3(carC.x + 0.90f * CAR_SCALE, tailY, tailZ),
-                glm::vec3(0), glm::vec3(0.55f * CAR_SCALE, 0.32f * CAR_SCALE, 0.18f * CAR_SCALE), tail);
-
-            AddBottom(glm::vec3(carC.x, carC.y - 0.08f * CAR_SCALE, carC.z),
-                glm::vec3(0),
-                glm::vec3(bodyW * 0.95f, 0.12f * CAR_SCALE, bodyL * 0.95f),
-                carGreenDark);
+    const unsigned int SHADOW_WIDTH = 2048, SHADOW_HEIGHT = 2048;
+    unsigned int depthMapFBO;
+    glGenFramebuffers(1, &depthMapFBO);
 
-            {
-                glm::vec3 plateCol(0.92f, 0.92f, 0.92f);
-                glm::vec3 borderCol(0.12f, 0.12f, 0.12f);
+    unsigned int depthMapTexture;
+    glGenTextures(1, &depthMapTexture);
+    glBindTexture(GL_TEXTURE_2D, depthMapTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-                float plateW = 1.10f * CAR_SCALE;
-                float plateH = 0.32f * CAR_SCALE;
-                float plateT = 0.05f * CAR_SCALE;
+    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMapTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-                float plateY = carC.y + 0.30f * CAR_SCALE;
-                float fz = carC.z + bodyL * 0.5f + 0.12f * CAR_SCALE;
-                float bz = carC.z - bodyL * 0.5f - 0.12f * CAR_SCALE;
+    unsigned int countFBO, countTexture, countDepthRBO;
+    int countW = 0, countH = 0;
+    glGenFramebuffers(1, &countFBO);
+    glGenTextures(1, &countTexture);
+    glGenRenderbuffers(1, &countDepthRBO);
+
+    auto ResizeCountTarget = [&](int w, int h) {
+        if (w <= 0 || h <= 0 || (w == countW && h == countH)) return;
+        countW = w;
+        countH = h;
+
+        glBindTexture(GL_TEXTURE_2D, countTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, w, h, 0, GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, countDepthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, countFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, countTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, countDepthRBO);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Count target incomplete\n";
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        };
+    ResizeCountTarget(fbW, fbH);
 
-                AddCenter(glm::vec3(carC.x, plateY, fz), glm::vec3(0.0f),
-                    glm::vec3(plateW, plateH, plateT), plateCol);
+    unsigned int fullscreenVAO;
+    glGenVertexArrays(1, &fullscreenVAO);
 
-                AddCenter(glm::vec3(carC.x, plateY, bz), glm::vec3(0.0f),
-                    glm::vec3(plateW, plateH, plateT), plateCol);
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexShaderSrc, windGlsl);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
+    GLuint shaderProgram = linkProgram(vs, fs);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
 
-                float b = 0.03f * CAR_SCALE;
-                AddCenter(glm::vec3(carC.x, plateY + plateH * 0.5f - b * 0.5f, fz + plateT * 0.6f), glm::vec3(0.0f),
-                    glm::vec3(plateW, b, b), borderCol);
-                AddCenter(glm::vec3(carC.x, plateY - plateH * 0.5f + b * 0.5f, fz + plateT * 0.6f), glm::vec3(0.0f),
-                    glm::vec3(plateW, b, b), borderCol);
+    GLuint shadowVs = compileShader(GL_VERTEX_SHADER, shadowVertexShaderSrc, windGlsl);
+    GLuint shadowFs = compileShader(GL_FRAGMENT_SHADER, shadowFragmentShaderSrc);
+    GLuint shadowShaderProgram = linkProgram(shadowVs, shadowFs);
+    glDeleteShader(shadowVs);
+    glDeleteShader(shadowFs);
 
-                AddCenter(glm::vec3(carC.x, plateY + plateH * 0.5f - b * 0.5f, bz - plateT * 0.6f), glm::vec3(0.0f),
-                    glm::vec3(plateW, b, b), borderCol);
-                AddCenter(glm::vec3(carC.x, plateY - plateH * 0.5f + b * 0.5f, bz - plateT * 0.6f), glm::vec3(0.0f),
-                    glm::vec3(plateW, b, b), borderCol);
+    GLuint countFs = compileShader(GL_FRAGMENT_SHADER, countFragmentShaderSrc);
+    GLuint countVs = compileShader(GL_VERTEX_SHADER, vertexShaderSrc, windGlsl);
+    GLuint countShaderProgram = linkProgram(countVs, countFs);
+    glDeleteShader(countVs);
+    glDeleteShader(countFs);
 
-                float digitW = 0.06f * CAR_SCALE;
-                float digitH = plateH * 0.70f;
-                float digitT = 0.03f * CAR_SCALE;
-                float spacing2 = 0.16f * CAR_SCALE;
-                float startX2 = carC.x - spacing2 * 1.5f;
+    GLuint heatVs = compileShader(GL_VERTEX_SHADER, heatmapVertexShaderSrc);
+    GLuint heatFs = compileShader(GL_FRAGMENT_SHADER, heatmapFragmentShaderSrc);
+    GLuint heatmapShaderProgram = linkProgram(heatVs, heatFs);
+    glDeleteShader(heatVs);
+    glDeleteShader(heatFs);
 
-                for (int i = 0; i < 4; ++i) {
-                    float xx = startX2 + spacing2 * i;
+    GLint countViewLoc = glGetUniformLocation(countShaderProgram, "view");
+    GLint countProjLoc = glGetUniformLocation(countShaderProgram, "projection");
 
-                    AddCenter(glm::vec3(xx, plateY, fz + plateT * 0.55f), glm::vec3(0.0f),
-                        glm::vec3(digitW, digitH, digitT), borderCol);
+    glUseProgram(heatmapShaderProgram);
+    glUniform1i(glGetUniformLocation(heatmapShaderProgram, "countTex"), 0);
+    GLint heatMaxCountLoc = glGetUniformLocation(heatmapShaderProgram, "maxCount");
 
-                    AddCenter(glm::vec3(xx, plateY, bz - plateT * 0.55f), glm::vec3(0.0f),
-                        glm::vec3(digitW, digitH, digitT), borderCol);
-                }
-            }
-        }
+    GLint shadowLightSpaceMatrixLoc = glGetUniformLocation(shadowShaderProgram, "lightSpaceMatrix");
 
-        {
+    glUseProgram(shaderProgram);
+    GLint viewLoc = glGetUniformLocation(shaderProgram, "view");
+    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
+    GLint lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos");
+    GLint lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
+    GLint viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
+    GLint ambientLoc = glGetUniformLocation(shaderProgram, "ambientStrength");
+    GLint specularLoc = glGetUniformLocation(shaderProgram, "specularStrength");
+    GLint shininessLoc = glGetUniformLocation(shaderProgram, "shininess");
 
-            float poleH = 9.6f;
-            float poleW = 0.34f;
+    GLint lightSpaceMatrixLoc = glGetUniformLocation(shaderProgram, "lightSpaceMatrix");
+    GLint shadowMapLoc = glGetUniformLocation(shaderProgram, "shadowMap");
+    glUniform1i(shadowMapLoc, 0);
+    GLint debugViewLoc = glGetUniformLocation(shaderProgram, "debugView");
 
+    // Per-draw uniforms of the three programs that draw the scene.
+    struct PassUniforms {
+        GLint prefabFirstBox = -1;
+        GLint prefabBoxCount = -1;
+        GLint wind = -1;
+    };
+    // Packed positions store 2 * pos (see PackedVertex).
+    float positionScale = opt.vertexFormat == VertexFormat::Packed ? 0.5f : 1.0f;
+    auto GetPassUniforms = [positionScale](GLuint program) {
+        PassUniforms u;
+        glUseProgram(program);
+        glUniform1f(glGetUniformLocation(program, "positionScale"), positionScale);
+        u.prefabFirstBox = glGetUniformLocation(program, "prefabFirstBox");
+        u.prefabBoxCount = glGetUniformLocation(program, "prefabBoxCount");
+        u.wind = glGetUniformLocation(program, "wind");
+        glUniform1i(glGetUniformLocation(program, "prefabBoxes"), 1);
+        return u;
+        };
+    PassUniforms shadowUniforms = GetPassUniforms(shadowShaderProgram);
+    PassUniforms countUniforms = GetPassUniforms(countShaderProgram);
+    PassUniforms mainUniforms = GetPassUniforms(shaderProgram);
 
-            float outPad = 6.0f;
+    glm::vec3 center = WC::SHIN_CENTER;
+    const glm::vec3 lightPos = center + glm::vec3(45.0f, 55.0f, 35.0f);
+    focus = center;
 
+    yaw = glm::radians(28.0f);
+    pitch = glm::radians(19.0f);
+    radius = std::max(radiusMin, std::min(radiusMax, 78.0f));
 
-            float outLeftX = center.x - fenceHalfW - outPad;
-            float outRightX = center.x + fenceHalfW + outPad;
+    double buildStart = glfwGetTime();
+    AllocSnapshot buildAllocStart = AllocSnapshot::Now();
+    PrefabLibrary prefabs;
+    MeshLibrary meshes;
+    // The terrain keeps a flat pad on every lot tile, streamed or not.
+    TerrainParams terrainParams;
+    terrainParams.tilesX = std::max(1, opt.lotsX);
+    terrainParams.tilesZ = std::max(1, opt.lotsZ);
+    glm::vec3 tile0 = GridLotCenter(center, 0, 0, terrainParams.tilesX, terrainParams.tilesZ);
+    terrainParams.origin = glm::vec2(tile0.x, tile0.z);
+    terrainParams.tileSize = WC::GROUND_SIZE;
+    terrainParams.groundY = WC::GROUND_Y;
+    terrainParams.padHalf = glm::vec2(WC::TERRAIN_PAD_HALF_W, WC::TERRAIN_PAD_HALF_L);
+    terrainParams.roadX = WC::TERRAIN_ROAD_X;
+    terrainParams.roadHalfW = WC::TERRAIN_ROAD_HALF_W;
+    terrainParams.blend = WC::TERRAIN_BLEND;
+    terrainParams.amplitude = WC::TERRAIN_AMPLITUDE;
+    terrainParams.wavelength = WC::TERRAIN_WAVELENGTH;
+    terrainParams.seed = MakeRng(opt.seed, RngStream::Terrain).NextU32();
+    const Terrain terrain(terrainParams);
+
+    // A grid's lots sit on GROUND_SIZE tiles around `center`, each with its
+    // own seed and style; lot 0 of the grid is not the hand-tuned lot. A
+    // streamed grid starts empty and fills in around the focus.
+    const bool streaming = opt.streamRadius > 0.0f;
+    std::vector<LotLayout> lots;
+    if (opt.lotsX > 0 && !streaming) {
+        lots.reserve((size_t)opt.lotsX * opt.lotsZ);
+        for (int z = 0; z < opt.lotsZ; ++z) {
+            for (int x = 0; x < opt.lotsX; ++x) {
+                uint64_t seed = GridLotSeed(opt.seed, x, z, opt.lotsX);
+                lots.push_back(MakeLotLayout(GridLotCenter(center, x, z, opt.lotsX, opt.lotsZ), seed, MakeLotStyle(seed)));
+            }
+        }
+    }
+    else if (opt.lotsX == 0) {
+        lots.push_back(MakeLotLayout(center, opt.seed));
+    }
+    for (LotLayout& L : lots) {
+        L.terrain = &terrain;
+        L.gpuScatter = opt.gpuScatter > 0.0f;
+    }
+    SceneWorld world = BuildScene(lots.data(), lots.size(), opt.buildThreads, prefabs, meshes);
+    // The far plane reaches the whole grid, so scaling runs draw every lot in view.
+    float sceneRadius = streaming ? opt.streamRadius + WC::GROUND_SIZE * 0.71f : 0.0f;
+    for (const LotLayout& L : lots) sceneRadius = std::max(sceneRadius, glm::length(L.center - center) + WC::GROUND_SIZE * 0.71f);
+    const float farPlane = std::max(260.0f, sceneRadius + radiusMax);
+    AllocSnapshot buildAllocs = AllocSnapshot::Now().Since(buildAllocStart);
+    std::cout << "[Scene] " << lots.size() << " lots, " << world.Count() << " items in " << (glfwGetTime() - buildStart) * 1000.0 << " ms";
+    if (ALLOC_TRACKING) std::cout << ", " << buildAllocs.allocations << " heap allocations (" << buildAllocs.bytes / 1024 << " KB)";
+    std::cout << "\n";
+
+    // Prefab local boxes live once in a texture buffer (unit 1). Parent
+    // transforms and tints of the visible instances are streamed every pass
+    // into its own region of instanceVBO, so uploads scale with instances, not
+    // boxes. Plain items draw as instances of the bare-mesh prefabs.
+    size_t prefabInstanceCount = 0;
+    world.ForEachChunk(PrefabRef::Bit, [&](const SceneWorld::ChunkView& c) { prefabInstanceCount += c.Count(); });
+    std::cout << "[Scene] " << prefabs.Count() << " prefabs (" << prefabs.BoxCount() << " boxes), "
+              << prefabInstanceCount << " instances\n";
+    std::cout << "[Scene] " << meshes.Count() << " meshes (" << meshes.Vertices().size() << " vertices, "
+              << meshes.Indices().size() / 3 << " triangles)\n";
+    // What the GPU scatter fills in, in the builders' variety: pines in the
+    // three leaf colors, red and yellow flowers. `rule` picks the areas and
+    // exclusions in scatterVertexShaderSrc.
+    struct GpuScatterSpecies {
+        uint32_t prefab;
+        int rule;
+        int variant, variants;
+        // One candidate per cell; instances per square meter before the
+        // exclusions at --gpu-scatter 1, as BuildVegetation's.
+        float cellSize;
+        float density;
+        glm::vec2 scaleMin, scaleMax;
+        float footRadius;
+        float windStiffness;
+    };
+    std::vector<GpuScatterSpecies> scatterSpecies;
+    if (opt.gpuScatter > 0.0f) {
+        SceneWorld unused;
+        uint32_t unusedGroups = 0;
+        BuildTarget target(unused, prefabs, meshes, unusedGroups);
+        LotLayout palette;
+        for (int k = 0; k < 3; ++k) {
+            scatterSpecies.push_back({ PinePrefab(palette.leaf[k]), 0, k, 3, 8.0f, 1.0f / 1600.0f,
+                glm::vec2(0.82f, 5.8f), glm::vec2(1.0f, 7.8f), 0.45f, WC::WIND_STIFFNESS_PINE });
+        }
+        const glm::vec3 petals[2] = { WC::COL_FLOWER_RED, WC::COL_FLOWER_YELLOW };
+        for (int k = 0; k < 2; ++k) {
+            scatterSpecies.push_back({ FlowerPrefab(petals[k]), 1, k, 2, 1.5f, 1.0f / 200.0f,
+                glm::vec2(0.85f), glm::vec2(1.15f), 0.055f, WC::WIND_STIFFNESS_FLOWER });
+        }
+    }
 
+    double lodStart = glfwGetTime();
+    std::vector<LodGroup> lodGroups = BakeLodGroups(world, prefabs, meshes);
+    {
+        uint64_t tris[LOD_LEVELS] = {};
+        for (const LodGroup& g : lodGroups) {
+            for (uint32_t k = 0; k < g.levelCount; ++k) tris[k] += g.triangles[k];
+        }
+        std::printf("[Scene] %zu LOD groups baked in %.1f ms, triangles per level:", lodGroups.size(), (glfwGetTime() - lodStart) * 1000.0);
+        for (uint32_t k = 0; k < LOD_LEVELS; ++k) std::printf(" %llu", (unsigned long long)tris[k]);
+        std::printf("\n");
+    }
+    std::vector<Impostor> impostors;
+    if (opt.impostorDistance > 0.0f && !streaming) impostors = MakeImpostors(world, prefabs, meshes, lodGroups, lots.data(), lots.size(), lightPos - center);
+    MeshLibrary::OptimizeStats meshOpt = meshes.Optimize();
+    meshes.BakeMeshlets();
+    std::printf("[Scene] vertex cache (FIFO 16): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+        meshOpt.before.Acmr(), meshOpt.after.Acmr(), meshOpt.before.Atvr(), meshOpt.after.Atvr());
+    std::printf("[Scene] %zu meshlets (<= %u vertices, %u triangles), at most %u per mesh\n",
+        meshes.MeshletCount(), MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, meshes.MaxMeshletsPerMesh());
+
+    // Streamed lots append to the mesh and prefab buffers after startup.
+    const GLenum libraryUsage = streaming ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+    std::vector<glm::vec4> prefabTexels = prefabs.PackTexels();
+    size_t prefabBytes = std::max<size_t>(1, prefabTexels.size()) * sizeof(glm::vec4);
+    GLuint prefabTBO, prefabTexture;
+    glGenBuffers(1, &prefabTBO);
+    glBindBuffer(GL_TEXTURE_BUFFER, prefabTBO);
+    glBufferData(GL_TEXTURE_BUFFER, prefabBytes, prefabTexels.empty() ? nullptr : prefabTexels.data(), libraryUsage);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glGenTextures(1, &prefabTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, prefabTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, prefabTBO);
+    glActiveTexture(GL_TEXTURE0);
+
+    // Every mesh (the primitives and the meshes built with the scene) lives
+    // in one VBO/EBO pair; a draw picks its mesh by index range. The instance
+    // attributes (locations 2..6) are pointed into instanceVBO per draw.
+    unsigned int VAO, VBO, EBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
 
-            float outBackZ = center.z - fenceHalfL - outPad;
+    glBindVertexArray(VAO);
 
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    size_t vertexBytes = 0;
+    if (opt.vertexFormat == VertexFormat::Packed) {
+        std::vector<PackedVertex> packed = meshes.PackedVertices();
+        vertexBytes = meshes.PackedVertexBytes();
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, packed.data(), libraryUsage);
+        glVertexAttribPointer(0, 4, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, pos));
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+    }
+    else {
+        vertexBytes = meshes.VertexBytes();
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, meshes.Vertices().data(), libraryUsage);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, pos));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, normal));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    std::printf("[Scene] vertex format %s: %zu B (float %zu B, packed %zu B)\n",
+        opt.vertexFormat == VertexFormat::Packed ? "packed" : "float", vertexBytes,
+        meshes.VertexBytes(), meshes.PackedVertexBytes());
 
-            AddStreetLight(glm::vec3(outLeftX, overlayY, Hc.z + D1 * 0.10f), poleH, poleW);
-            AddStreetLight(glm::vec3(outLeftX, overlayY, Hc.z - D1 * 0.18f), poleH, poleW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshes.IndexBytes(), meshes.Indices().data(), libraryUsage);
 
+    for (int a = 2; a <= 7; ++a) glEnableVertexAttribArray(a);
 
-            AddStreetLight(glm::vec3(outRightX, overlayY, Hc.z + D1 * 0.08f), poleH, poleW);
-            AddStreetLight(glm::vec3(outRightX, overlayY, Hc.z - D1 * 0.20f), poleH, poleW);
+    glBindVertexArray(0);
 
+    // Tint and wind (PackWind) as RGBA8: 72 bytes per instance instead of 96.
+    struct InstanceData {
+        glm::mat4 model;
+        uint32_t color;
+        uint32_t wind;
+    };
+    // Same fields as GL's DrawElementsIndirectCommand (minus baseVertex: our
+    // indices are absolute) plus the prefab run. GL 3.3 has no indirect
+    // draws, so each command becomes one glDrawElementsInstanced.
+    struct DrawCommand {
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        uint32_t baseInstance;
+        uint32_t prefabFirstBox;
+        uint32_t prefabBoxCount;
+    };
 
-            AddStreetLight(glm::vec3(Hc.x - W1 * 0.18f, overlayY, outBackZ), poleH, poleW);
-            AddStreetLight(glm::vec3(Hc.x + W1 * 0.18f, overlayY, outBackZ), poleH, poleW);
+    // Each pass's region has a slot for every static item.
+    auto InstanceSlots = [&](SceneWorld& w) {
+        size_t slots = 0;
+        w.ForEachChunk(Transform::Bit, [&](const SceneWorld::ChunkView& c) {
+            if (!c.Has(Anim::Bit)) slots += c.Count();
+            });
+        return slots;
+        };
+    size_t instanceSlots = InstanceSlots(world);
+    size_t commandCapacity = prefabs.RunCount();
+    size_t instanceRegionBytes = std::max<size_t>(1, instanceSlots) * sizeof(InstanceData);
+    GLuint instanceVBO;
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instanceRegionBytes * (size_t)RenderPass::Count, nullptr, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Terrain: one grid patch of TERRAIN_GRID^2 cells, drawn instanced once per
+    // selected CDLOD node (per-instance TerrainNode at location 1, pointed into
+    // the pass's region of terrainInstanceVBO per draw). The tree reaches past
+    // the far plane all round, and its depth only grows with log2 of that.
+    const CdlodTree terrainTree(glm::vec2(center.x, center.z), 2.0f * (sceneRadius + farPlane), WC::TERRAIN_LEAF_SIZE,
+        WC::TERRAIN_LOD_RANGE, WC::GROUND_Y - terrain.MaxOffset(), WC::GROUND_Y + terrain.MaxOffset());
+    const size_t terrainNodeCapacity = terrainTree.MaxNodes();
+    const size_t terrainRegionBytes = terrainNodeCapacity * sizeof(TerrainNode);
+    const int terrainGrid = WC::TERRAIN_GRID;
+    GLsizei terrainIndexCount = 0;
+    GLuint terrainVAO, terrainVBO, terrainEBO, terrainInstanceVBO;
+    {
+        std::vector<glm::vec2> grid;
+        std::vector<uint16_t> indices;
+        for (int z = 0; z <= terrainGrid; ++z) {
+            for (int x = 0; x <= terrainGrid; ++x) grid.push_back(glm::vec2((float)x, (float)z) / (float)terrainGrid);
+        }
+        for (int z = 0; z < terrainGrid; ++z) {
+            for (int x = 0; x < terrainGrid; ++x) {
+                uint16_t i = (uint16_t)(z * (terrainGrid + 1) + x);
+                uint16_t below = (uint16_t)(i + terrainGrid + 1);
+                uint16_t quad[6] = { i, below, (uint16_t)(i + 1), (uint16_t)(i + 1), below, (uint16_t)(below + 1) };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
         }
+        terrainIndexCount = (GLsizei)indices.size();
+
+        glGenVertexArrays(1, &terrainVAO);
+        glGenBuffers(1, &terrainVBO);
+        glGenBuffers(1, &terrainEBO);
+        glGenBuffers(1, &terrainInstanceVBO);
+        glBindVertexArray(terrainVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, terrainVBO);
+        glBufferData(GL_ARRAY_BUFFER, grid.size() * sizeof(glm::vec2), grid.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrainEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, terrainInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, terrainRegionBytes * (size_t)RenderPass::Count, nullptr, GL_STREAM_DRAW);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        std::printf("[Scene] terrain: %d CDLOD levels over %.0f m, %dx%d patch, at most %zu patches per pass\n",
+            terrainTree.Levels(), terrainTree.RootSize(), terrainGrid, terrainGrid, terrainNodeCapacity);
+    }
+    const uint64_t terrainGpuBytes = (uint64_t)(terrainGrid + 1) * (terrainGrid + 1) * sizeof(glm::vec2) +
+        (uint64_t)terrainIndexCount * sizeof(uint16_t) + terrainRegionBytes * (size_t)RenderPass::Count;
+
+    // Grass: one blade strip drawn instanced per blade of the selected chunks.
+    // The per-instance GrassChunk (location 1) advances once per band's blades
+    // per chunk, so one call draws a whole band; placement, exclusion and
+    // fading happen in grassVertexShaderSrc, and the CPU only picks chunks.
+    GrassParams grassParams;
+    grassParams.bladesPerChunk = opt.grassBlades;
+    grassParams.seed = MakeRng(opt.seed, RngStream::Grass).NextU32();
+    const GrassField grass(grassParams, WC::GROUND_Y - terrain.MaxOffset(), WC::GROUND_Y + terrain.MaxOffset());
+    const size_t grassRegionBytes = grass.MaxChunks() * sizeof(GrassChunk);
+    const glm::vec2 bladeStrip[] = {
+        glm::vec2(-1.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(-1.0f, 0.45f), glm::vec2(1.0f, 0.45f), glm::vec2(0.0f, 1.0f),
+    };
+    const GLsizei bladeVertexCount = (GLsizei)(sizeof(bladeStrip) / sizeof(bladeStrip[0]));
+    GLuint grassVAO, grassVBO, grassInstanceVBO;
+    glGenVertexArrays(1, &grassVAO);
+    glGenBuffers(1, &grassVBO);
+    glGenBuffers(1, &grassInstanceVBO);
+    glBindVertexArray(grassVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, grassVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(bladeStrip), bladeStrip, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, grassInstanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, grassRegionBytes * (size_t)RenderPass::Count, nullptr, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Style id of every terrain tile (unit 4) and the rects of each style,
+    // so the grass and scatter shaders know what to keep clear of on any lot,
+    // built or not. Unused styles get empty rects.
+    const TerrainParams& tp = terrain.Params();
+    std::vector<uint8_t> tileStyles((size_t)tp.tilesX * tp.tilesZ, 0);
+    glm::vec4 grassExclusion[3 * LOT_STYLE_COUNT];
+    glm::vec4 scatterAreas[5 * LOT_STYLE_COUNT];
+    std::fill(grassExclusion, grassExclusion + 3 * LOT_STYLE_COUNT, glm::vec4(1.0f, 1.0f, -1.0f, -1.0f));
+    std::fill(scatterAreas, scatterAreas + 5 * LOT_STYLE_COUNT, glm::vec4(1.0f, 1.0f, -1.0f, -1.0f));
+    bool styleSeen[LOT_STYLE_COUNT] = {};
+    auto AddTileStyle = [&](const LotStyle& style) {
+        if (styleSeen[style.id]) return;
+        styleSeen[style.id] = true;
+        LotLayout L = MakeLotLayout(glm::vec3(0.0f), opt.seed, style);
+        GrassExclusions(L, &grassExclusion[3 * style.id]);
+        ScatterAreas(L, &scatterAreas[5 * style.id]);
+        };
+    if (opt.lotsX == 0) AddTileStyle(LotStyle());
+    for (int z = 0; z < opt.lotsZ; ++z) {
+        for (int x = 0; x < opt.lotsX; ++x) {
+            LotStyle style = MakeLotStyle(GridLotSeed(opt.seed, x, z, opt.lotsX));
+            tileStyles[(size_t)z * tp.tilesX + x] = (uint8_t)style.id;
+            AddTileStyle(style);
+        }
+    }
+    GLuint tileStyleTexture;
+    glGenTextures(1, &tileStyleTexture);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, tileStyleTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, tp.tilesX, tp.tilesZ, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, tileStyles.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glActiveTexture(GL_TEXTURE0);
+    std::printf("[Scene] grass: %d blades per %.0f m chunk, faded out by %.0f m, %d lot styles masked\n",
+        grassParams.bladesPerChunk, grassParams.chunkSize, grassParams.fadeEnd,
+        (int)std::count(styleSeen, styleSeen + LOT_STYLE_COUNT, true));
+    const uint64_t grassGpuBytes = sizeof(bladeStrip) + grassRegionBytes * (size_t)RenderPass::Count + tileStyles.size();
+
+    // The terrain and grass vertex shaders with each of the scene fragment
+    // shaders; both take the terrain from terrainGlsl, behind the style
+    // count the per-style arrays are sized by.
+    const std::string groundGlsl = "#define LOT_STYLE_COUNT " + std::to_string(LOT_STYLE_COUNT) + "\n" + terrainGlsl;
+    struct TerrainUniforms {
+        GLint view, projection, lightSpaceMatrix, lodEye;
+        GLint lightPos, lightColor, viewPos, ambient, specular, shininess, debugView;
+        // Grass only: blades per chunk of the band being drawn.
+        GLint bladesPerChunk;
+    };
+    auto SetTerrainUniforms = [&](GLuint program) {
+        glUseProgram(program);
+        glUniform2fv(glGetUniformLocation(program, "tOrigin"), 1, glm::value_ptr(tp.origin));
+        glUniform1f(glGetUniformLocation(program, "tTileSize"), tp.tileSize);
+        glUniform2f(glGetUniformLocation(program, "tTileMax"), (float)(tp.tilesX - 1), (float)(tp.tilesZ - 1));
+        glUniform1f(glGetUniformLocation(program, "tGroundY"), tp.groundY);
+        glUniform2fv(glGetUniformLocation(program, "tPadHalf"), 1, glm::value_ptr(tp.padHalf));
+        glUniform2f(glGetUniformLocation(program, "tRoad"), tp.roadX, tp.roadHalfW);
+        glUniform1f(glGetUniformLocation(program, "tBlend"), tp.blend);
+        glUniform1f(glGetUniformLocation(program, "tAmplitude"), tp.amplitude);
+        glUniform1f(glGetUniformLocation(program, "tWavelength"), tp.wavelength);
+        glUniform1ui(glGetUniformLocation(program, "tSeed"), tp.seed);
+        };
+    auto LinkGroundProgram = [&](const char* vertexSrc, const char* fragmentSrc, GLuint& program) {
+        GLuint gvs = compileShader(GL_VERTEX_SHADER, vertexSrc, groundGlsl.c_str());
+        GLuint gfs = compileShader(GL_FRAGMENT_SHADER, fragmentSrc);
+        program = linkProgram(gvs, gfs);
+        glDeleteShader(gvs);
+        glDeleteShader(gfs);
+
+        SetTerrainUniforms(program);
+        glUniform1i(glGetUniformLocation(program, "shadowMap"), 0);
+
+        TerrainUniforms u;
+        u.view = glGetUniformLocation(program, "view");
+        u.projection = glGetUniformLocation(program, "projection");
+        u.lightSpaceMatrix = glGetUniformLocation(program, "lightSpaceMatrix");
+        u.lodEye = glGetUniformLocation(program, "lodEye");
+        u.lightPos = glGetUniformLocation(program, "lightPos");
+        u.lightColor = glGetUniformLocation(program, "lightColor");
+        u.viewPos = glGetUniformLocation(program, "viewPos");
+        u.ambient = glGetUniformLocation(program, "ambientStrength");
+        u.specular = glGetUniformLocation(program, "specularStrength");
+        u.shininess = glGetUniformLocation(program, "shininess");
+        u.debugView = glGetUniformLocation(program, "debugView");
+        u.bladesPerChunk = glGetUniformLocation(program, "bladesPerChunk");
+        return u;
+        };
+    auto LinkTerrainProgram = [&](const char* fragmentSrc, GLuint& program) {
+        TerrainUniforms u = LinkGroundProgram(terrainVertexShaderSrc, fragmentSrc, program);
+        glUniform1f(glGetUniformLocation(program, "gridDim"), (float)terrainGrid);
+        glm::vec2 morph[CdlodTree::MAX_LEVELS];
+        for (int l = 0; l < terrainTree.Levels(); ++l) morph[l] = terrainTree.MorphRange(l);
+        glUniform2fv(glGetUniformLocation(program, "morphRange"), terrainTree.Levels(), glm::value_ptr(morph[0]));
+        glUniform3fv(glGetUniformLocation(program, "terrainColor"), 1, glm::value_ptr(WC::COL_GRASS));
+        return u;
+        };
+    auto LinkGrassProgram = [&](const char* fragmentSrc, GLuint& program) {
+        TerrainUniforms u = LinkGroundProgram(grassVertexShaderSrc, fragmentSrc, program);
+        const GrassParams& gp = grass.Params();
+        glUniform1f(glGetUniformLocation(program, "chunkSize"), gp.chunkSize);
+        glUniform1i(glGetUniformLocation(program, "bladesFull"), gp.bladesPerChunk);
+        glUniform2f(glGetUniformLocation(program, "fadeRange"), gp.fadeStart, gp.fadeEnd);
+        glUniform2fv(glGetUniformLocation(program, "bladeSize"), 1, glm::value_ptr(gp.bladeSize));
+        glUniform1ui(glGetUniformLocation(program, "grassSeed"), gp.seed);
+        glUniform3fv(glGetUniformLocation(program, "rootColor"), 1, glm::value_ptr(WC::COL_GRASS));
+        glUniform3fv(glGetUniformLocation(program, "tipColor"), 1, glm::value_ptr(WC::COL_GRASS_TIP));
+        glUniform1i(glGetUniformLocation(program, "tileStyles"), 4);
+        glUniform4fv(glGetUniformLocation(program, "exclusion"), 3 * LOT_STYLE_COUNT, glm::value_ptr(grassExclusion[0]));
+        return u;
+        };
+    GLuint terrainProgram, terrainShadowProgram, terrainCountProgram;
+    TerrainUniforms terrainUniforms = LinkTerrainProgram(fragmentShaderSrc, terrainProgram);
+    TerrainUniforms terrainShadowUniforms = LinkTerrainProgram(shadowFragmentShaderSrc, terrainShadowProgram);
+    TerrainUniforms terrainCountUniforms = LinkTerrainProgram(countFragmentShaderSrc, terrainCountProgram);
+    GLuint grassProgram, grassCountProgram;
+    TerrainUniforms grassUniforms = LinkGrassProgram(fragmentShaderSrc, grassProgram);
+    TerrainUniforms grassCountUniforms = LinkGrassProgram(countFragmentShaderSrc, grassCountProgram);
+    glUseProgram(0);
+
+    // GPU scatter: every species on every lot tile, made once into scatterVBO
+    // as InstanceData, species by species and tiles in order, so the tiles
+    // in view are a few contiguous ranges of each species (see DrawScatter).
+    // A first run of each (species, tile) only counts what it keeps; the
+    // second writes it straight to its place. Only the counts come back.
+    const size_t scatterTileCount = (size_t)tp.tilesX * tp.tilesZ;
+    std::vector<uint32_t> scatterOffsets(scatterSpecies.size() * (scatterTileCount + 1), 0);
+    size_t scatterInstances = 0;
+    GLuint scatterVBO = 0;
+    if (!scatterSpecies.empty()) {
+        double scatterStart = glfwGetTime();
+        GLuint svs = compileShader(GL_VERTEX_SHADER, scatterVertexShaderSrc, groundGlsl.c_str());
+        GLuint sgs = compileShader(GL_GEOMETRY_SHADER, scatterGeometryShaderSrc);
+        const char* varyings[] = { "vModel0", "vModel1", "vModel2", "vModel3", "vColor", "vWind" };
+        GLuint scatterProgram = linkFeedbackProgram(svs, sgs, varyings, 6);
+        glDeleteShader(svs);
+        glDeleteShader(sgs);
+        SetTerrainUniforms(scatterProgram);
+        glUniform1i(glGetUniformLocation(scatterProgram, "tileStyles"), 4);
+        glUniform4fv(glGetUniformLocation(scatterProgram, "areas"), 5 * LOT_STYLE_COUNT, glm::value_ptr(scatterAreas[0]));
+        glUniform1ui(glGetUniformLocation(scatterProgram, "scatterSeed"), MakeRng(opt.seed, RngStream::Flowers).NextU32());
+        GLint tileLoc = glGetUniformLocation(scatterProgram, "tile");
+
+        auto CellsPerSide = [&](const GpuScatterSpecies& sp) { return (int)std::ceil(tp.tileSize / sp.cellSize); };
+        size_t maxCells = 0;
+        for (const GpuScatterSpecies& sp : scatterSpecies) maxCells = std::max(maxCells, (size_t)CellsPerSide(sp) * CellsPerSide(sp));
+        GLuint scratchVBO, emptyVAO;
+        glGenBuffers(1, &scratchVBO);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, scratchVBO);
+        glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, maxCells * sizeof(InstanceData), nullptr, GL_DYNAMIC_COPY);
+        glGenBuffers(1, &scatterVBO);
+        glGenVertexArrays(1, &emptyVAO);
+        glBindVertexArray(emptyVAO);
+        glEnable(GL_RASTERIZER_DISCARD);
+
+        auto UseSpecies = [&](const GpuScatterSpecies& sp) {
+            int side = CellsPerSide(sp);
+            glUniform1i(glGetUniformLocation(scatterProgram, "cellsPerSide"), side);
+            glUniform1f(glGetUniformLocation(scatterProgram, "cellSize"), sp.cellSize);
+            glUniform1i(glGetUniformLocation(scatterProgram, "rule"), sp.rule);
+            glUniform1i(glGetUniformLocation(scatterProgram, "variant"), sp.variant);
+            glUniform1i(glGetUniformLocation(scatterProgram, "variants"), sp.variants);
+            glUniform1f(glGetUniformLocation(scatterProgram, "chance"), std::min(1.0f, sp.density * sp.cellSize * sp.cellSize * opt.gpuScatter));
+            glUniform2fv(glGetUniformLocation(scatterProgram, "scaleMin"), 1, glm::value_ptr(sp.scaleMin));
+            glUniform2fv(glGetUniformLocation(scatterProgram, "scaleMax"), 1, glm::value_ptr(sp.scaleMax));
+            glUniform1f(glGetUniformLocation(scatterProgram, "footRadius"), sp.footRadius);
+            glUniform1f(glGetUniformLocation(scatterProgram, "windStiffness"), sp.windStiffness);
+            return (GLsizei)side * side;
+            };
+        auto Scatter = [&](size_t t, GLsizei cells) {
+            glUniform2i(tileLoc, (GLint)(t % (size_t)tp.tilesX), (GLint)(t / (size_t)tp.tilesX));
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, cells);
+            glEndTransformFeedback();
+            };
 
+        std::vector<GLuint> queries(scatterTileCount);
+        glGenQueries((GLsizei)queries.size(), queries.data());
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, scratchVBO);
+        for (size_t s = 0; s < scatterSpecies.size(); ++s) {
+            GLsizei cells = UseSpecies(scatterSpecies[s]);
+            for (size_t t = 0; t < scatterTileCount; ++t) {
+                glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, queries[t]);
+                Scatter(t, cells);
+                glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+            }
+            uint32_t* offsets = &scatterOffsets[s * (scatterTileCount + 1)];
+            offsets[0] = (uint32_t)scatterInstances;
+            for (size_t t = 0; t < scatterTileCount; ++t) {
+                GLuint kept = 0;
+                glGetQueryObjectuiv(queries[t], GL_QUERY_RESULT, &kept);
+                scatterInstances += kept;
+                offsets[t + 1] = (uint32_t)scatterInstances;
+            }
+        }
+        glDeleteQueries((GLsizei)queries.size(), queries.data());
+
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, scatterVBO);
+        glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, std::max<size_t>(1, scatterInstances) * sizeof(InstanceData), nullptr, GL_STATIC_DRAW);
+        for (size_t s = 0; s < scatterSpecies.size(); ++s) {
+            GLsizei cells = UseSpecies(scatterSpecies[s]);
+            const uint32_t* offsets = &scatterOffsets[s * (scatterTileCount + 1)];
+            for (size_t t = 0; t < scatterTileCount; ++t) {
+                if (offsets[t + 1] == offsets[t]) continue;
+                glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, scatterVBO, (GLintptr)offsets[t] * sizeof(InstanceData),
+                    (GLsizeiptr)(offsets[t + 1] - offsets[t]) * sizeof(InstanceData));
+                Scatter(t, cells);
+            }
+        }
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+        glDisable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(0);
+        glDeleteVertexArrays(1, &emptyVAO);
+        glDeleteBuffers(1, &scratchVBO);
+        glDeleteProgram(scatterProgram);
+        glUseProgram(0);
+        std::printf("[Scene] GPU scatter: %zu instances of %zu species over %zu tiles in %.1f ms\n",
+            scatterInstances, scatterSpecies.size(), scatterTileCount, (glfwGetTime() - scatterStart) * 1000.0);
     }
 
+    FrameStatsRecorder& stats = GetFrameStats();
     {
-        glm::vec3 cloudColor(0.95f, 0.95f, 0.97f);
-        float cloudY = overlayY + 30.0f;
-
-        auto AddCloud = [&](glm::vec3 c, float s) {
-            AddCenter(c, glm::vec3(0.0f),
-                glm::vec3(10.0f * s, 2.5f * s, 6.0f * s),
-                cloudColor);
-
-            AddCenter(c + glm::vec3(-4.0f * s, 0.8f * s, 0.0f), glm::vec3(0.0f),
-                glm::vec3(7.0f * s, 2.0f * s, 5.0f * s),
-                cloudColor);
+        MemoryStats& mem = stats.Current().mem;
+        mem.gpuVertexBytes = vertexBytes;
+        mem.gpuIndexBytes = meshes.IndexBytes();
+        mem.gpuShadowBytes = (uint64_t)SHADOW_WIDTH * SHADOW_HEIGHT * 4;
+        mem.gpuTerrainBytes = terrainGpuBytes + grassGpuBytes;
+        mem.gpuInstanceBytes = prefabBytes + instanceRegionBytes * (size_t)RenderPass::Count + scatterInstances * sizeof(InstanceData);
+        mem.cpuItemBytes = world.MemoryBytes() + prefabs.MemoryBytes();
+    }
 
-            AddCenter(c + glm::vec3(4.5f * s, 0.4f * s, -1.0f * s), glm::vec3(0.0f),
-                glm::vec3(6.5f * s, 1.8f * s, 4.8f * s),
-                cloudColor);
+    BenchResult bench;
+    bench.warmupFrames = opt.benchWarmup;
+    bench.allocTracked = ALLOC_TRACKING != 0;
+    bench.lots = (uint32_t)lots.size();
+    bench.items = world.Count();
+    if (opt.benchFrames > 0) bench.frameMs.reserve((size_t)opt.benchFrames);
+
+    // Per-frame scratch (cull lists and the like). Reset at the top of every
+    // frame; after the first few frames its blocks are reused and the frame
+    // loop makes no heap allocations at all.
+    Arena frameArena(256 * 1024);
+
+    struct VisibleInstance {
+        uint32_t prefab;
+        const glm::mat4* parent;
+        const glm::vec3* tint;
+        const Wind* wind;
+    };
+    const glm::vec3 white(1.0f);
+
+    // Level each LOD group draws at this frame, picked once from the camera so
+    // the shadow pass matches what the main pass shows. Groups standing in an
+    // impostor are hidden from the main pass; the other passes take them from
+    // proxyLodLevels instead.
+    uint32_t* lodLevels = nullptr;
+    uint32_t* proxyLodLevels = nullptr;
+
+    // What the passes draw: the startup world, then every streamed lot.
+    std::vector<SceneWorld*> worlds{ &world };
+    size_t itemCount = world.Count();
+
+    // Selects the terrain patches for `frustum` with LOD from `lodEye` (the
+    // camera in every pass, so the shadow caster has the same surface) and
+    // draws them in one call with the bound terrain program.
+    auto DrawTerrain = [&](RenderPass pass, const Frustum& frustum, const glm::vec3& lodEye) {
+        TerrainNode* nodes = frameArena.AllocArray<TerrainNode>(terrainNodeCapacity);
+        size_t count = terrainTree.Select(lodEye, frustum, nodes, terrainNodeCapacity);
+        if (count == 0) return;
+        size_t offset = (size_t)pass * terrainRegionBytes;
+        glBindVertexArray(terrainVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, terrainInstanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)(count * sizeof(TerrainNode)), nodes);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TerrainNode), (void*)offset);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDrawElementsInstanced(GL_TRIANGLES, terrainIndexCount, GL_UNSIGNED_SHORT, nullptr, (GLsizei)count);
+        glBindVertexArray(0);
+        stats.Upload(count * sizeof(TerrainNode));
+        stats.Draw(pass, (uint64_t)terrainIndexCount / 3, (uint32_t)count);
+        };
 
-            AddCenter(c + glm::vec3(0.0f, -0.4f * s, 2.0f * s), glm::vec3(0.0f),
-                glm::vec3(8.0f * s, 1.6f * s, 5.8f * s),
-                cloudColor);
-            };
+    // Picks the grass chunks in `frustum` around `lodEye` and draws each band
+    // in one call with the bound grass program (uniforms `u`).
+    auto DrawGrass = [&](RenderPass pass, const Frustum& frustum, const glm::vec3& lodEye, const TerrainUniforms& u) {
+        if (grass.Params().bladesPerChunk <= 0) return;
+        GrassChunk* chunks = frameArena.AllocArray<GrassChunk>(grass.MaxChunks() * GrassField::BANDS);
+        size_t counts[GrassField::BANDS];
+        grass.Select(lodEye, frustum, chunks, counts);
+        size_t total = 0;
+        for (size_t c : counts) total += c;
+        if (total == 0) return;
+        size_t offset = (size_t)pass * grassRegionBytes;
+        glBindVertexArray(grassVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, grassInstanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)(total * sizeof(GrassChunk)), chunks);
+        for (int b = 0; b < GrassField::BANDS; ++b) {
+            if (counts[b] > 0) {
+                GLsizei blades = (GLsizei)grass.BandBlades(b);
+                glVertexAttribIPointer(1, 2, GL_INT, sizeof(GrassChunk), (void*)offset);
+                glVertexAttribDivisor(1, (GLuint)blades);
+                glUniform1i(u.bladesPerChunk, blades);
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, bladeVertexCount, (GLsizei)counts[b] * blades);
+                stats.Uniforms(1);
+                stats.Draw(pass, (uint64_t)bladeVertexCount - 2, (uint32_t)counts[b] * (uint32_t)blades);
+            }
+            offset += counts[b] * sizeof(GrassChunk);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        stats.Upload(total * sizeof(GrassChunk));
+        };
 
-        int cloudCount = 27;
-        float halfGroundCloud = WC::GROUND_SIZE * 0.5f - 10.0f;
+    // Draws `commands` with the bound scene program, their instances read
+    // from `buffer` at `regionBase`. Every GL instance repeats the run's
+    // boxes, so the attribute divisor is the run length.
+    auto SubmitCommands = [&](RenderPass pass, const PassUniforms& u, GLuint buffer, size_t regionBase, const DrawCommand* commands,
+        size_t commandCount) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBindVertexArray(VAO);
+        for (size_t k = 0; k < commandCount; ++k) {
+            const DrawCommand& cmd = commands[k];
+            size_t offset = regionBase + (size_t)cmd.baseInstance * sizeof(InstanceData);
+            for (int c = 0; c < 4; ++c) {
+                glVertexAttribPointer(2 + c, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                    (void*)(offset + offsetof(InstanceData, model) + c * sizeof(glm::vec4)));
+                glVertexAttribDivisor(2 + c, cmd.prefabBoxCount);
+            }
+            glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, color)));
+            glVertexAttribDivisor(6, cmd.prefabBoxCount);
+            glVertexAttribPointer(7, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, wind)));
+            glVertexAttribDivisor(7, cmd.prefabBoxCount);
+            glUniform1i(u.prefabFirstBox, (GLint)cmd.prefabFirstBox);
+            glUniform1i(u.prefabBoxCount, (GLint)cmd.prefabBoxCount);
+            glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)cmd.count, GL_UNSIGNED_INT,
+                (void*)((size_t)cmd.firstIndex * sizeof(uint32_t)), (GLsizei)cmd.instanceCount);
+            stats.Uniforms(2);
+            stats.Draw(pass, cmd.count / 3, cmd.instanceCount);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        };
 
-        for (int i = 0; i < cloudCount; ++i) {
-            float rx = (float)(rand() % (int)(halfGroundCloud * 2.0f) - (int)halfGroundCloud);
-            float rz = (float)(rand() % (int)(halfGroundCloud * 2.0f) - (int)halfGroundCloud);
+    // Only chunks with all of `requireBits` are drawn.
+    auto DrawWorld = [&](RenderPass pass, const Frustum& frustum, uint32_t layerMask, const PassUniforms& u, uint32_t requireBits) {
+        PassStats& ps = stats.Current().Pass(pass);
+        const uint32_t* levels = pass == RenderPass::Main ? lodLevels : proxyLodLevels;
+        ps.submitted = (uint32_t)itemCount;
+
+        // Plain items are the bare prefab of their mesh tinted by their
+        // material; prefab instances keep the colors baked into their boxes.
+        VisibleInstance* instances = frameArena.AllocArray<VisibleInstance>(itemCount);
+        size_t instanceCount = 0;
+        for (SceneWorld* w : worlds) w->ForEachChunk(Transform::Bit | Bounds::Bit | Layer::Bit | requireBits, [&](const SceneWorld::ChunkView& c) {
+            const Transform* xf = c.Column<Transform>();
+            const Bounds* bb = c.Column<Bounds>();
+            const Layer* layer = c.Column<Layer>();
+            const Material* mat = c.Has(Material::Bit) ? c.Column<Material>() : nullptr;
+            const MeshRef* mesh = c.Has(MeshRef::Bit) ? c.Column<MeshRef>() : nullptr;
+            const PrefabRef* ref = c.Has(PrefabRef::Bit) ? c.Column<PrefabRef>() : nullptr;
+            const Lod* lod = c.Has(Lod::Bit) ? c.Column<Lod>() : nullptr;
+            const Wind* wind = c.Has(Wind::Bit) ? c.Column<Wind>() : nullptr;
+            if ((!ref && !mesh) || c.Has(Anim::Bit)) return;
+            for (uint32_t i = 0; i < c.Count(); ++i) {
+                if (lod && lod[i].level != levels[lod[i].group]) {
+                    ps.lodSkipped++;
+                    continue;
+                }
+                if ((layer[i].flags & layerMask) != layerMask || !frustum.IntersectsAabb(bb[i].min, bb[i].max)) {
+                    ps.culled++;
+                    continue;
+                }
+                const Wind* sway = wind ? &wind[i] : nullptr;
+                if (ref) instances[instanceCount++] = { ref[i].prefab, &xf[i].model, &white, sway };
+                else instances[instanceCount++] = { prefabs.BarePrefab(mesh[i].mesh), &xf[i].model, mat ? &mat[i].color : &white, sway };
+            }
+            });
+
+        if (instanceCount == 0) return;
+
+        // Counting sort by prefab: groups[p] is where prefab p's instances start.
+        size_t prefabCount = prefabs.Count();
+        uint32_t* groups = frameArena.AllocArray<uint32_t>(prefabCount + 1);
+        std::fill(groups, groups + prefabCount + 1, 0u);
+        for (size_t i = 0; i < instanceCount; ++i) groups[instances[i].prefab + 1]++;
+        for (size_t p = 0; p < prefabCount; ++p) groups[p + 1] += groups[p];
+
+        VisibleInstance* sorted = frameArena.AllocArray<VisibleInstance>(instanceCount);
+        uint32_t* cursor = frameArena.AllocArray<uint32_t>(prefabCount);
+        std::copy(groups, groups + prefabCount, cursor);
+        for (size_t i = 0; i < instanceCount; ++i) sorted[cursor[instances[i].prefab]++] = instances[i];
+
+        // Build the draw list and its instance stream.
+        InstanceData* data = frameArena.AllocArray<InstanceData>(instanceSlots);
+        DrawCommand* commands = frameArena.AllocArray<DrawCommand>(commandCapacity);
+        uint32_t used = 0;
+        size_t commandCount = 0;
+        auto Emit = [&](const VisibleInstance& v) {
+            InstanceData& d = data[used++];
+            d.model = *v.parent;
+            d.color = PackUnorm8x4(glm::vec4(*v.tint, 1.0f));
+            d.wind = v.wind ? PackWind(*v.wind, (*v.parent)[3].y) : 0u;
+        };
+        for (size_t p = 0; p < prefabCount; ++p) {
+            uint32_t n = groups[p + 1] - groups[p];
+            if (n == 0) continue;
+            const VisibleInstance* group = sorted + groups[p];
+            const Prefab& prefab = prefabs.Get((uint32_t)p);
+
+            uint32_t base = used;
+            for (uint32_t i = 0; i < n; ++i) Emit(group[i]);
+            for (uint32_t r = 0; r < prefab.runCount; ++r) {
+                const PrefabRun& run = prefabs.Run(prefab.firstRun + r);
+                const MeshRange& range = meshes.Range(run.mesh);
+                commands[commandCount++] = { range.indexCount, n * run.boxCount, range.firstIndex, base, run.firstBox, run.boxCount };
+            }
+        }
+        if (commandCount == 0) return;
+
+        size_t regionBase = (size_t)pass * instanceRegionBytes;
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)regionBase, (GLsizeiptr)(used * sizeof(InstanceData)), data);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        stats.Upload(used * sizeof(InstanceData));
+        SubmitCommands(pass, u, instanceVBO, regionBase, commands, commandCount);
+        };
 
-            float xx = center.x + rx;
-            float zz = center.z + rz;
+    // Dynamic items (Anim) stay out of the per-pass streams. Once a frame
+    // UpdateDynamic moves them and writes every one, prefab by prefab, to
+    // dynamicVBO: the only instance data rewritten whatever the view. Passes
+    // draw the prefab groups in view straight from it. Pivots move hierarchy
+    // nodes first; only items under a node that changed are re-placed. Items
+    // outside both the camera and light frusta, or under DYNAMIC_MIN_PIXELS
+    // on screen, are not written: every lot of a grid has its car and clouds.
+    // Neither is an item around the eye: clouds drift through the camera's
+    // orbit, and from inside the near plane opens one up over the screen.
+    struct DynamicGroup {
+        uint32_t prefab;
+        uint32_t first;
+        uint32_t count;
+        // Layer flags all its items have, and the box around them.
+        uint32_t flags;
+        glm::vec3 bmin, bmax;
+    };
+    GLuint dynamicVBO;
+    glGenBuffers(1, &dynamicVBO);
+    size_t dynamicCapacity = 0;
+    DynamicGroup* dynamicGroups = nullptr;
+    size_t dynamicGroupCount = 0;
+    size_t dynamicRunCount = 0;
+    const float DYNAMIC_MIN_PIXELS = 2.0f;
+    auto UpdateDynamic = [&](float t, const Frustum& camera, const Frustum& light, const glm::vec3& eye, float pixelsPerUnit) {
+        auto Wanted = [&](const Bounds& b) {
+            float d = glm::length(glm::max(glm::max(b.min - eye, eye - b.max), glm::vec3(0.0f)));
+            if (d == 0.0f) return false;
+            if (light.IntersectsAabb(b.min, b.max)) return true;
+            if (!camera.IntersectsAabb(b.min, b.max)) return false;
+            return glm::length(b.max - b.min) * pixelsPerUnit >= DYNAMIC_MIN_PIXELS * std::max(d, 1.0f);
+            };
+        dynamicGroupCount = 0;
+        dynamicRunCount = 0;
+        size_t prefabCount = prefabs.Count();
+        uint32_t* counts = frameArena.AllocArray<uint32_t>(prefabCount);
+        std::fill(counts, counts + prefabCount, 0u);
+        auto PrefabOf = [&](const SceneWorld::ChunkView& c, uint32_t i) {
+            return c.Has(PrefabRef::Bit) ? c.Column<PrefabRef>()[i].prefab : prefabs.BarePrefab(c.Column<MeshRef>()[i].mesh);
+            };
+        for (SceneWorld* w : worlds) {
+            TransformHierarchy& nodes = w->Nodes();
+            w->ForEachChunk(Anim::Bit | Pivot::Bit, [&](const SceneWorld::ChunkView& c) {
+                const Anim* anim = c.Column<Anim>();
+                const Pivot* pivot = c.Column<Pivot>();
+                for (uint32_t i = 0; i < c.Count(); ++i) {
+                    glm::mat4 local = nodes.Local(pivot[i].node);
+                    local[3] = glm::vec4(anim[i].rest + AnimOffset(anim[i], t), 1.0f);
+                    nodes.SetLocal(pivot[i].node, local);
+                }
+                });
+            if (!nodes.Update()) continue;
+            for (const TransformHierarchy::Range& moved : nodes.Updated()) {
+                w->ForEachChild(moved, [&](const SceneWorld::ChunkView& c, uint32_t i) {
+                    Transform* xf = c.Column<Transform>();
+                    Bounds* bb = c.Column<Bounds>();
+                    const Parent* parent = c.Column<Parent>();
+                    xf[i].model = nodes.World(parent[i].node) * parent[i].local;
+                    if (c.Has(PrefabRef::Bit)) {
+                        const Prefab& p = prefabs.Get(c.Column<PrefabRef>()[i].prefab);
+                        bb[i] = TransformBounds(xf[i].model, p.boundsMin, p.boundsMax);
+                    }
+                    else {
+                        bb[i] = UnitCubeBounds(xf[i].model);
+                    }
+                    if (c.Has(Wind::Bit)) {
+                        bb[i].min -= glm::vec3(WC::WIND_MAX_SWAY, 0.0f, WC::WIND_MAX_SWAY);
+                        bb[i].max += glm::vec3(WC::WIND_MAX_SWAY, 0.0f, WC::WIND_MAX_SWAY);
+                    }
+                    });
+            }
+        }
+        size_t total = 0, skipped = 0;
+        for (SceneWorld* w : worlds) w->ForEachChunk(Transform::Bit | Bounds::Bit | Anim::Bit, [&](const SceneWorld::ChunkView& c) {
+            Transform* xf = c.Column<Transform>();
+            Bounds* bb = c.Column<Bounds>();
+            const Anim* anim = c.Column<Anim>();
+            for (uint32_t i = 0; i < c.Count(); ++i) {
+                if (anim[i].motion != MOTION_PARENT) {
+                    glm::vec3 pos = anim[i].rest + AnimOffset(anim[i], t);
+                    glm::vec3 delta = pos - glm::vec3(xf[i].model[3]);
+                    xf[i].model[3] = glm::vec4(pos, 1.0f);
+                    bb[i].min += delta;
+                    bb[i].max += delta;
+                }
+                if (!Wanted(bb[i])) {
+                    ++skipped;
+                    continue;
+                }
+                counts[PrefabOf(c, i)]++;
+                ++total;
+            }
+            });
+        stats.Current().Pass(RenderPass::Main).culled += skipped;
+        if (total == 0) return;
+
+        // counts becomes each prefab's group index.
+        dynamicGroups = frameArena.AllocArray<DynamicGroup>(std::min(total, prefabCount));
+        uint32_t first = 0;
+        for (size_t p = 0; p < prefabCount; ++p) {
+            if (counts[p] == 0) continue;
+            dynamicGroups[dynamicGroupCount] = { (uint32_t)p, first, 0, ~0u, glm::vec3(1e30f), glm::vec3(-1e30f) };
+            dynamicRunCount += prefabs.Get((uint32_t)p).runCount;
+            first += counts[p];
+            counts[p] = (uint32_t)dynamicGroupCount++;
+        }
+        InstanceData* data = frameArena.AllocArray<InstanceData>(total);
+        for (SceneWorld* w : worlds) w->ForEachChunk(Transform::Bit | Bounds::Bit | Layer::Bit | Anim::Bit, [&](const SceneWorld::ChunkView& c) {
+            const Transform* xf = c.Column<Transform>();
+            const Bounds* bb = c.Column<Bounds>();
+            const Layer* layer = c.Column<Layer>();
+            const Material* mat = c.Has(Material::Bit) ? c.Column<Material>() : nullptr;
+            for (uint32_t i = 0; i < c.Count(); ++i) {
+                if (!Wanted(bb[i])) continue;
+                DynamicGroup& g = dynamicGroups[counts[PrefabOf(c, i)]];
+                InstanceData& d = data[g.first + g.count++];
+                d.model = xf[i].model;
+                d.color = PackUnorm8x4(glm::vec4(mat ? mat[i].color : white, 1.0f));
+                d.wind = 0u;
+                g.flags &= layer[i].flags;
+                g.bmin = glm::min(g.bmin, bb[i].min);
+                g.bmax = glm::max(g.bmax, bb[i].max);
+            }
+            });
+
+        glBindBuffer(GL_ARRAY_BUFFER, dynamicVBO);
+        if (total > dynamicCapacity) {
+            size_t grown = std::max(total, dynamicCapacity * 2);
+            stats.Current().mem.gpuInstanceBytes += (grown - dynamicCapacity) * sizeof(InstanceData);
+            dynamicCapacity = grown;
+            glBufferData(GL_ARRAY_BUFFER, dynamicCapacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(total * sizeof(InstanceData)), data);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        stats.Upload(total * sizeof(InstanceData));
+        };
 
-            float yy = cloudY + (float)(rand() % 25 - 10);
-            float ss = 0.8f + (float)(rand() % 60) / 100.0f;
+    auto DrawDynamic = [&](RenderPass pass, const Frustum& frustum, uint32_t layerMask, const PassUniforms& u) {
+        if (dynamicGroupCount == 0) return;
+        PassStats& ps = stats.Current().Pass(pass);
+        DrawCommand* commands = frameArena.AllocArray<DrawCommand>(dynamicRunCount);
+        size_t commandCount = 0;
+        for (size_t g = 0; g < dynamicGroupCount; ++g) {
+            const DynamicGroup& dg = dynamicGroups[g];
+            if ((dg.flags & layerMask) != layerMask || !frustum.IntersectsAabb(dg.bmin, dg.bmax)) {
+                ps.culled += dg.count;
+                continue;
+            }
+            const Prefab& prefab = prefabs.Get(dg.prefab);
+            for (uint32_t r = 0; r < prefab.runCount; ++r) {
+                const PrefabRun& run = prefabs.Run(prefab.firstRun + r);
+                const MeshRange& range = meshes.Range(run.mesh);
+                commands[commandCount++] = { range.indexCount, dg.count * run.boxCount, range.firstIndex, dg.first, run.firstBox, run.boxCount };
+            }
+        }
+        SubmitCommands(pass, u, dynamicVBO, 0, commands, commandCount);
+        };
 
-            AddCloud(glm::vec3(xx, yy, zz), ss);
+    // Impostor atlases, one array layer per impostor: captured from the
+    // impostor's groups at level 0 with baked lighting, or loaded from the
+    // disk cache when the content key matches.
+    struct ImpostorInstance {
+        glm::vec4 sphere;
+        float layer;
+    };
+    GLuint impostorColorTex = 0, impostorDepthTex = 0;
+    GLuint impostorVAO = 0, impostorQuadVBO = 0, impostorInstanceVBO = 0;
+    GLuint impostorProgram = 0;
+    GLint impostorViewLoc = -1, impostorProjLoc = -1, impostorViewPosLoc = -1;
+    if (!impostors.empty()) {
+        double impostorStart = glfwGetTime();
+        GLint maxLayers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        size_t impostorCount = impostors.size();
+        impostors.erase(std::remove_if(impostors.begin(), impostors.end(),
+            [maxLayers](const Impostor& imp) { return (GLint)imp.layer >= maxLayers; }), impostors.end());
+        if (impostors.size() < impostorCount) {
+            std::cerr << "Only " << maxLayers << " impostor layers fit in an array texture; "
+                      << impostorCount - impostors.size() << " lots draw without one\n";
         }
+        GLsizei layers = 0;
+        for (const Impostor& imp : impostors) layers = std::max(layers, (GLsizei)imp.layer + 1);
+        const int S = IMPOSTOR_ATLAS_SIZE;
+
+        // Mips stop at 8-texel frames so neighbouring frames don't bleed.
+        int maxMip = 0;
+        while ((IMPOSTOR_FRAME_SIZE >> (maxMip + 1)) >= 8) maxMip++;
+        glGenTextures(1, &impostorColorTex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostorColorTex);
+        for (int m = 0; m <= maxMip; ++m) glTexImage3D(GL_TEXTURE_2D_ARRAY, m, GL_RGBA8, S >> m, S >> m, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxMip);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glGenTextures(1, &impostorDepthTex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostorDepthTex);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16, S, S, layers, 0, GL_RED, GL_UNSIGNED_SHORT, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        GLuint captureFBO, captureDepthRBO;
+        glGenFramebuffers(1, &captureFBO);
+        glGenRenderbuffers(1, &captureDepthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, captureDepthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, S, S);
+
+        GLuint captureVs = compileShader(GL_VERTEX_SHADER, vertexShaderSrc, windGlsl);
+        GLuint captureFs = compileShader(GL_FRAGMENT_SHADER, captureFragmentShaderSrc);
+        GLuint captureProgram = linkProgram(captureVs, captureFs);
+        glDeleteShader(captureVs);
+        glDeleteShader(captureFs);
+        PassUniforms captureUniforms = GetPassUniforms(captureProgram);
+        GLint captureViewLoc = glGetUniformLocation(captureProgram, "view");
+        GLint captureProjLoc = glGetUniformLocation(captureProgram, "projection");
+        GLint captureLightPosLoc = glGetUniformLocation(captureProgram, "lightPos");
+        glUniform3f(glGetUniformLocation(captureProgram, "lightColor"), 1.0f, 1.0f, 1.0f);
+        glUniform1f(glGetUniformLocation(captureProgram, "ambientStrength"), 0.35f);
+
+        std::error_code ec;
+        std::filesystem::create_directories(opt.impostorCache, ec);
+        std::vector<unsigned char> color, depth;
+        std::vector<uint32_t> captureLevels(lodGroups.size());
+        const GLenum captureBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const float clearDepth[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        std::vector<bool> filled((size_t)layers, false);
+        int cached = 0;
+        for (const Impostor& imp : impostors) {
+            if (filled[imp.layer]) continue;
+            filled[imp.layer] = true;
+            char path[1024];
+            std::snprintf(path, sizeof(path), "%s/%016llx.imp", opt.impostorCache, (unsigned long long)imp.key);
+            if (LoadImpostorAtlas(path, imp.key, color, depth)) {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, impostorColorTex);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)imp.layer, S, S, 1, GL_RGBA, GL_UNSIGNED_BYTE, color.data());
+                glBindTexture(GL_TEXTURE_2D_ARRAY, impostorDepthTex);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)imp.layer, S, S, 1, GL_RED, GL_UNSIGNED_SHORT, depth.data());
+                cached++;
+                continue;
+            }
 
-        int grassPatchCount = 70;
-        float halfGround = WC::GROUND_SIZE * 0.5f;
+            glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, impostorColorTex, 0, (GLint)imp.layer);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, impostorDepthTex, 0, (GLint)imp.layer);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureDepthRBO);
+            glDrawBuffers(2, captureBuffers);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                std::cerr << "Impostor capture target incomplete\n";
+                break;
+            }
+            glViewport(0, 0, S, S);
+            glClearBufferfv(GL_COLOR, 0, clearColor);
+            glClearBufferfv(GL_COLOR, 1, clearDepth);
+            glClear(GL_DEPTH_BUFFER_BIT);
+
+            std::fill(captureLevels.begin(), captureLevels.end(), LOD_HIDDEN);
+            for (uint32_t g : imp.groups) captureLevels[g] = 0;
+            lodLevels = captureLevels.data();
+            glUseProgram(captureProgram);
+            glm::vec3 captureLightPos = imp.origin + (lightPos - center);
+            glUniform3fv(captureLightPosLoc, 1, glm::value_ptr(captureLightPos));
+            glm::mat4 proj = ImpostorFrameProjection(imp.radius);
+            glUniformMatrix4fv(captureProjLoc, 1, GL_FALSE, glm::value_ptr(proj));
+            for (int fy = 0; fy < IMPOSTOR_FRAMES; ++fy) {
+                for (int fx = 0; fx < IMPOSTOR_FRAMES; ++fx) {
+                    glm::mat4 frameView = ImpostorFrameView(imp.center, imp.radius, ImpostorFrameDir(fx, fy));
+                    glViewport(fx * IMPOSTOR_FRAME_SIZE, fy * IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE, IMPOSTOR_FRAME_SIZE);
+                    glUniformMatrix4fv(captureViewLoc, 1, GL_FALSE, glm::value_ptr(frameView));
+                    DrawWorld(RenderPass::Main, Frustum::FromMatrix(proj * frameView), 0u, captureUniforms, Lod::Bit);
+                    frameArena.Reset();
+                }
+            }
 
-        for (int i = 0; i < grassPatchCount; ++i) {
-            float patchMargin = 2.0f;
+            color.resize(IMPOSTOR_COLOR_BYTES);
+            depth.resize(IMPOSTOR_DEPTH_BYTES);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glReadPixels(0, 0, S, S, GL_RGBA, GL_UNSIGNED_BYTE, color.data());
+            glReadBuffer(GL_COLOR_ATTACHMENT1);
+            glReadPixels(0, 0, S, S, GL_RED, GL_UNSIGNED_SHORT, depth.data());
+            if (!SaveImpostorAtlas(path, imp.key, color, depth)) std::cerr << "Failed to write impostor cache: " << path << "\n";
+        }
+        lodLevels = nullptr;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, fbW, fbH);
+        glDeleteFramebuffers(1, &captureFBO);
+        glDeleteRenderbuffers(1, &captureDepthRBO);
+        glDeleteProgram(captureProgram);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostorColorTex);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostorColorTex);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostorDepthTex);
+        glActiveTexture(GL_TEXTURE0);
 
-            float rx = (float)(rand() % (int)((halfGround - patchMargin) * 2.0f) - (int)(halfGround - patchMargin));
-            float rz = (float)(rand() % (int)((halfGround - patchMargin) * 2.0f) - (int)(halfGround - patchMargin));
+        GLuint impVs = compileShader(GL_VERTEX_SHADER, impostorVertexShaderSrc);
+        GLuint impFs = compileShader(GL_FRAGMENT_SHADER, impostorFragmentShaderSrc);
+        impostorProgram = linkProgram(impVs, impFs);
+        glDeleteShader(impVs);
+        glDeleteShader(impFs);
+        glUseProgram(impostorProgram);
+        impostorViewLoc = glGetUniformLocation(impostorProgram, "view");
+        impostorProjLoc = glGetUniformLocation(impostorProgram, "projection");
+        impostorViewPosLoc = glGetUniformLocation(impostorProgram, "viewPos");
+        glUniform1i(glGetUniformLocation(impostorProgram, "frames"), IMPOSTOR_FRAMES);
+        glUniform1i(glGetUniformLocation(impostorProgram, "impostorColor"), 2);
+        glUniform1i(glGetUniformLocation(impostorProgram, "impostorDepth"), 3);
+
+        const float quad[8] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+        glGenVertexArrays(1, &impostorVAO);
+        glGenBuffers(1, &impostorQuadVBO);
+        glGenBuffers(1, &impostorInstanceVBO);
+        glBindVertexArray(impostorVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, impostorQuadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, impostorInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, impostors.size() * sizeof(ImpostorInstance), nullptr, GL_STREAM_DRAW);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (void*)offsetof(ImpostorInstance, sphere));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (void*)offsetof(ImpostorInstance, layer));
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribDivisor(1, 1);
+        glVertexAttribDivisor(2, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        uint64_t colorBytes = 0;
+        for (int m = 0; m <= maxMip; ++m) colorBytes += (uint64_t)(S >> m) * (S >> m) * 4;
+        stats.Current().mem.gpuImpostorBytes = (colorBytes + IMPOSTOR_DEPTH_BYTES) * layers + impostors.size() * sizeof(ImpostorInstance);
+        std::printf("[Scene] %zu impostors, %d atlas layers (%d x %d frames of %d px), %d from cache, %d captured in %.1f ms, %.1f MB\n",
+            impostors.size(), (int)layers, IMPOSTOR_FRAMES, IMPOSTOR_FRAMES, IMPOSTOR_FRAME_SIZE, cached, (int)layers - cached,
+            (glfwGetTime() - impostorStart) * 1000.0, stats.Current().mem.gpuImpostorBytes / (1024.0 * 1024.0));
+    }
 
-            float gx = center.x + rx;
-            float gz = center.z + rz;
+    // Lot streaming. Lots are built on `streamPool` as the focus approaches
+    // (BuildStreamedLot) and merged here, a few per frame: their meshes and
+    // prefabs join the libraries (shared with earlier lots where identical)
+    // and are appended to the GPU buffers, their LOD groups take free slots in
+    // lodGroups and their world joins `worlds`. Lots past the radius, or the
+    // farthest ones when the budget runs out, are dropped again. GL calls stay
+    // on this thread; the workers only build.
+    struct StreamedLot {
+        uint32_t cell;
+        SceneWorld world;
+        std::vector<uint32_t> groups;
+        size_t instanceSlots;
+    };
+    struct PendingLot {
+        uint32_t cell;
+        std::future<std::unique_ptr<LotBuild>> build;
+    };
+    std::unique_ptr<CellStreamer> streamer;
+    std::atomic<bool> streamStop{ false };
+    std::unique_ptr<ThreadPool> streamPool;
+    std::vector<PendingLot> pendingLots;
+    std::vector<std::unique_ptr<StreamedLot>> streamedLots;
+    std::vector<uint32_t> freeLodGroups, streamLoads, streamEvicts;
+    const size_t baseInstanceSlots = instanceSlots;
+    size_t streamedSlots = 0;
+    size_t vertexCapacity = vertexBytes, indexCapacity = meshes.IndexBytes(), texelCapacity = prefabBytes;
+    size_t uploadedVertices = meshes.Vertices().size(), uploadedIndices = meshes.Indices().size(), uploadedBoxes = prefabs.BoxCount();
+
+    // Grows the bound buffer to at least `bytes` (doubling); true when it was
+    // reallocated and has to be filled again from the start. The buffer name
+    // stays, so the VAO and the texture buffer keep pointing at it.
+    auto Reserve = [&](GLenum target, size_t& capacity, size_t bytes) {
+        if (bytes <= capacity) return false;
+        capacity = std::max(bytes, capacity * 2);
+        glBufferData(target, (GLsizeiptr)capacity, nullptr, libraryUsage);
+        return true;
+    };
 
-            if (std::abs(gx - center.x) < yardW * 0.55f &&
-                std::abs(gz - center.z) < yardL * 0.55f) {
-                continue;
+    // Uploads what the mesh and prefab libraries gained since the last call.
+    auto SyncLibraries = [&]() {
+        uint64_t uploaded = 0;
+        size_t vertexCount = meshes.Vertices().size();
+        if (vertexCount > uploadedVertices) {
+            bool packed = opt.vertexFormat == VertexFormat::Packed;
+            size_t stride = packed ? sizeof(PackedVertex) : sizeof(MeshVertex);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            size_t from = Reserve(GL_ARRAY_BUFFER, vertexCapacity, vertexCount * stride) ? 0 : uploadedVertices;
+            size_t bytes = (vertexCount - from) * stride;
+            if (packed) glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(from * stride), (GLsizeiptr)bytes, meshes.PackedVertices(from).data());
+            else glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(from * stride), (GLsizeiptr)bytes, meshes.Vertices().data() + from);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            uploadedVertices = vertexCount;
+            uploaded += bytes;
+        }
+        size_t indexCount = meshes.Indices().size();
+        if (indexCount > uploadedIndices) {
+            glBindVertexArray(VAO);
+            size_t from = Reserve(GL_ELEMENT_ARRAY_BUFFER, indexCapacity, indexCount * sizeof(uint32_t)) ? 0 : uploadedIndices;
+            size_t bytes = (indexCount - from) * sizeof(uint32_t);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)(from * sizeof(uint32_t)), (GLsizeiptr)bytes, meshes.Indices().data() + from);
+            glBindVertexArray(0);
+            uploadedIndices = indexCount;
+            uploaded += bytes;
+        }
+        size_t boxCount = prefabs.BoxCount();
+        if (boxCount > uploadedBoxes) {
+            size_t stride = PrefabLibrary::TEXELS_PER_BOX * sizeof(glm::vec4);
+            glBindBuffer(GL_TEXTURE_BUFFER, prefabTBO);
+            bool grown = Reserve(GL_TEXTURE_BUFFER, texelCapacity, boxCount * stride);
+            size_t from = grown ? 0 : uploadedBoxes;
+            std::vector<glm::vec4> texels = prefabs.PackTexels(from);
+            glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)(from * stride), (GLsizeiptr)(texels.size() * sizeof(glm::vec4)), texels.data());
+            glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            if (grown) {
+                glActiveTexture(GL_TEXTURE1);
+                glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, prefabTBO);
+                glActiveTexture(GL_TEXTURE0);
             }
-
-            float ww = 1.8f + (float)(rand() % 20) / 10.0f;
-            float ll = 1.8f + (float)(rand() % 20) / 10.0f;
-
-            float gg = 0.40f + (float)(rand() % 20) / 100.0f;
-            glm::vec3 grassColor(0.18f, gg, 0.18f);
-
-            items.push_back({
-                MakeModel_BottomPivot(glm::vec3(gx, overlayY + 0.001f, gz),
-                                      glm::vec3(0.0f),
-                                      glm::vec3(ww, 0.02f, ll)),
-                grassColor
-                });
+            uploadedBoxes = boxCount;
+            uploaded += texels.size() * sizeof(glm::vec4);
         }
+        commandCapacity = prefabs.RunCount();
+        MemoryStats& mem = stats.Current().mem;
+        mem.gpuVertexBytes = vertexCapacity;
+        mem.gpuIndexBytes = indexCapacity;
+        mem.gpuInstanceBytes = texelCapacity + instanceRegionBytes * (size_t)RenderPass::Count + (scatterInstances + dynamicCapacity) * sizeof(InstanceData);
+        stats.Upload(uploaded);
+        return uploaded;
+        };
 
-        int flowerCount = 260;
-        float halfG = WC::GROUND_SIZE * 0.5f - 8.0f;
-
-        glm::vec3 stemCol(0.10f, 0.55f, 0.12f);
-        glm::vec3 flowerRed(0.95f, 0.20f, 0.18f);
-        glm::vec3 flowerYellow(0.98f, 0.92f, 0.22f);
+    auto ReserveInstanceSlots = [&](size_t slots) {
+        if (slots <= instanceSlots) return;
+        instanceSlots = std::max(slots, instanceSlots * 2);
+        instanceRegionBytes = instanceSlots * sizeof(InstanceData);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instanceRegionBytes * (size_t)RenderPass::Count, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        stats.Current().mem.gpuInstanceBytes = texelCapacity + instanceRegionBytes * (size_t)RenderPass::Count + (scatterInstances + dynamicCapacity) * sizeof(InstanceData);
+        };
 
-        for (int i = 0; i < flowerCount; ++i) {
-            float rx = (float)(rand() % (int)(halfG * 2.0f) - (int)halfG);
-            float rz = (float)(rand() % (int)(halfG * 2.0f) - (int)halfG);
+    // Makes a built lot resident; returns the bytes it brought in (uploads
+    // plus its items).
+    auto MergeLot = [&](uint32_t cell, LotBuild& b) {
+        std::vector<uint32_t> meshRemap = meshes.AppendShared(b.meshes);
+        std::vector<uint32_t> prefabRemap = prefabs.Append(b.prefabs, meshRemap);
+        std::unique_ptr<StreamedLot> lot(new StreamedLot{ cell, std::move(b.world), {}, 0 });
+        for (const LodGroup& g : b.lodGroups) {
+            uint32_t id = (uint32_t)lodGroups.size();
+            if (!freeLodGroups.empty()) {
+                id = freeLodGroups.back();
+                freeLodGroups.pop_back();
+                lodGroups[id] = g;
+            }
+            else {
+                lodGroups.push_back(g);
+            }
+            lot->groups.push_back(id);
+        }
+        lot->world.ForEachChunk(0u, [&](const SceneWorld::ChunkView& c) {
+            if (c.Has(PrefabRef::Bit)) {
+                PrefabRef* ref = c.Column<PrefabRef>();
+                for (uint32_t r = 0; r < c.Count(); ++r) ref[r].prefab = prefabRemap[ref[r].prefab];
+            }
+            if (c.Has(MeshRef::Bit)) {
+                MeshRef* ref = c.Column<MeshRef>();
+                for (uint32_t r = 0; r < c.Count(); ++r) ref[r].mesh = meshRemap[ref[r].mesh];
+            }
+            if (c.Has(Lod::Bit)) {
+                Lod* lod = c.Column<Lod>();
+                for (uint32_t r = 0; r < c.Count(); ++r) lod[r].group = lot->groups[lod[r].group];
+            }
+            });
+
+        uint64_t uploaded = SyncLibraries();
+        lot->instanceSlots = InstanceSlots(lot->world);
+        streamedSlots += lot->instanceSlots;
+        ReserveInstanceSlots(baseInstanceSlots + streamedSlots);
+        itemCount += lot->world.Count();
+        worlds.push_back(&lot->world);
+        uint64_t lotBytes = lot->world.MemoryBytes() + lot->groups.capacity() * sizeof(uint32_t) + b.lodGroups.size() * sizeof(LodGroup);
+        streamer->Loaded(cell, lotBytes);
+        streamedLots.push_back(std::move(lot));
+        return uploaded + lotBytes;
+        };
 
-            float fx = center.x + rx;
-            float fz = center.z + rz;
+    // Library entries of a dropped lot stay: they are shared, and bounded by
+    // the number of lot styles.
+    auto DropLot = [&](uint32_t cell) {
+        auto it = std::find_if(streamedLots.begin(), streamedLots.end(),
+            [cell](const std::unique_ptr<StreamedLot>& l) { return l->cell == cell; });
+        if (it == streamedLots.end()) return;
+        StreamedLot& lot = **it;
+        for (uint32_t g : lot.groups) {
+            lodGroups[g] = LodGroup();
+            freeLodGroups.push_back(g);
+        }
+        itemCount -= lot.world.Count();
+        streamedSlots -= lot.instanceSlots;
+        worlds.erase(std::find(worlds.begin(), worlds.end(), &lot.world));
+        streamedLots.erase(it);
+        };
 
-            if (std::abs(fx - center.x) < fenceHalfW + 2.0f &&
-                std::abs(fz - center.z) < fenceHalfL + 2.0f) {
+    // Merges finished lots (nearest first, as they were queued) until the
+    // frame's share is spent, then plans around the focus: drops and queues.
+    // True while streaming still has work in flight or did some this frame.
+    auto UpdateStreaming = [&]() {
+        StreamStats& ss = stats.Current().stream;
+        uint64_t merged = 0;
+        for (size_t k = 0; k < pendingLots.size();) {
+            if (ss.merged > 0 && merged >= opt.streamUploadBytes) break;
+            if (pendingLots[k].build.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++k;
                 continue;
             }
-
-            if (std::abs(fx - gateCenterX) < roadW * 0.70f &&
-                fz > frontFenceOuterZ - 1.0f &&
-                fz < frontFenceOuterZ + roadL + 1.0f) {
+            uint32_t cell = pendingLots[k].cell;
+            std::unique_ptr<LotBuild> b = pendingLots[k].build.get();
+            pendingLots.erase(pendingLots.begin() + k);
+            if (!b || !streamer->Wanted(cell, focus)) {
+                streamer->Dropped(cell);
                 continue;
             }
+            merged += MergeLot(cell, *b);
+            ss.merged++;
+        }
+
+        size_t inFlight = streamPool->Size() * 2;
+        streamer->Plan(focus, inFlight > pendingLots.size() ? inFlight - pendingLots.size() : 0, streamLoads, streamEvicts);
+        for (uint32_t cell : streamEvicts) DropLot(cell);
+        for (uint32_t cell : streamLoads) {
+            int x = streamer->X(cell), z = streamer->Z(cell);
+            uint64_t seed = GridLotSeed(opt.seed, x, z, opt.lotsX);
+            glm::vec3 offset = GridLotCenter(center, x, z, opt.lotsX, opt.lotsZ) - center;
+            std::atomic<bool>* stop = &streamStop;
+            const Terrain* ground = &terrain;
+            const bool gpuScatter = opt.gpuScatter > 0.0f;
+            pendingLots.push_back({ cell, streamPool->Submit([stop, ground, gpuScatter, center, seed, offset]() -> std::unique_ptr<LotBuild> {
+                if (stop->load()) return nullptr;
+                LotLayout L = MakeLotLayout(center, seed, MakeLotStyle(seed));
+                L.terrain = ground;
+                L.gpuScatter = gpuScatter;
+                return BuildStreamedLot(L, offset);
+                }) });
+        }
 
-            float stemH = 0.52f + (float)(rand() % 22) / 100.0f;
-            float stemW = 0.11f;
+        ss.evicted = (uint32_t)streamEvicts.size();
+        ss.resident = (uint32_t)streamer->ResidentCount();
+        ss.loading = (uint32_t)streamer->LoadingCount();
+        ss.residentBytes = streamer->ResidentBytes();
+        stats.Current().mem.cpuItemBytes = world.MemoryBytes() + prefabs.MemoryBytes() + streamer->ResidentBytes();
+        return !pendingLots.empty() || ss.merged > 0 || ss.evicted > 0;
+        };
 
-            glm::vec3 petalCol = (rand() % 2 == 0) ? flowerRed : flowerYellow;
+    if (streaming) {
+        glm::vec3 origin = GridLotCenter(center, 0, 0, opt.lotsX, opt.lotsZ);
+        streamer.reset(new CellStreamer(opt.lotsX, opt.lotsZ, WC::GROUND_SIZE, glm::vec2(origin.x, origin.z), opt.streamRadius, opt.streamBudgetBytes));
+        streamPool.reset(new ThreadPool(opt.buildThreads ? opt.buildThreads : std::max(1u, ThreadPool::DefaultThreads() - 1)));
+        std::printf("[Scene] streaming %d x %d lots within %.0f m of the focus on %zu threads, budget %.0f MB, %.0f KB merged per frame\n",
+            opt.lotsX, opt.lotsZ, opt.streamRadius, streamPool->Size(), opt.streamBudgetBytes / (1024.0 * 1024.0), opt.streamUploadBytes / 1024.0);
+    }
 
-            AddBottom(glm::vec3(fx, overlayY + 0.001f, fz), glm::vec3(0.0f),
-                glm::vec3(stemW, stemH, stemW), stemCol);
+    // Scattered instances of the tiles in `frustum` (and resident, when
+    // streaming): consecutive visible tiles are one range of each species in
+    // scatterVBO, drawn as is with no upload.
+    size_t scatterRuns = 0;
+    for (const GpuScatterSpecies& sp : scatterSpecies) scatterRuns = std::max(scatterRuns, (size_t)prefabs.Get(sp.prefab).runCount);
+    auto DrawScatter = [&](RenderPass pass, const Frustum& frustum, const PassUniforms& u) {
+        if (scatterInstances == 0) return;
+        PassStats& ps = stats.Current().Pass(pass);
+        uint8_t* visible = frameArena.AllocArray<uint8_t>(scatterTileCount);
+        float top = 0.0f;
+        for (const GpuScatterSpecies& sp : scatterSpecies) top = std::max(top, prefabs.Get(sp.prefab).boundsMax.y * sp.scaleMax.y);
+        for (size_t t = 0; t < scatterTileCount; ++t) {
+            glm::vec2 c = tp.origin + glm::vec2((float)(t % (size_t)tp.tilesX), (float)(t / (size_t)tp.tilesX)) * tp.tileSize;
+            glm::vec3 bmin(c.x - tp.tileSize * 0.5f - 4.0f, tp.groundY - tp.amplitude, c.y - tp.tileSize * 0.5f - 4.0f);
+            glm::vec3 bmax(c.x + tp.tileSize * 0.5f + 4.0f, tp.groundY + tp.amplitude + top, c.y + tp.tileSize * 0.5f + 4.0f);
+            visible[t] = (!streamer || streamer->State((uint32_t)t) == CellState::Resident) && frustum.IntersectsAabb(bmin, bmax);
+        }
 
-            AddCenter(glm::vec3(fx, overlayY + stemH + 0.10f, fz), glm::vec3(0.0f),
-                glm::vec3(0.46f, 0.20f, 0.46f), petalCol);
+        DrawCommand* commands = frameArena.AllocArray<DrawCommand>(scatterSpecies.size() * (scatterTileCount / 2 + 1) * scatterRuns);
+        size_t commandCount = 0;
+        for (size_t s = 0; s < scatterSpecies.size(); ++s) {
+            const uint32_t* offsets = &scatterOffsets[s * (scatterTileCount + 1)];
+            const Prefab& prefab = prefabs.Get(scatterSpecies[s].prefab);
+            for (size_t t = 0; t < scatterTileCount;) {
+                if (!visible[t]) {
+                    ps.culled += offsets[t + 1] - offsets[t];
+                    ++t;
+                    continue;
+                }
+                size_t end = t + 1;
+                while (end < scatterTileCount && visible[end]) ++end;
+                uint32_t first = offsets[t], n = offsets[end] - offsets[t];
+                ps.submitted += n;
+                t = end;
+                if (n == 0) continue;
+                for (uint32_t r = 0; r < prefab.runCount; ++r) {
+                    const PrefabRun& run = prefabs.Run(prefab.firstRun + r);
+                    const MeshRange& range = meshes.Range(run.mesh);
+                    commands[commandCount++] = { range.indexCount, n * run.boxCount, range.firstIndex, first, run.firstBox, run.boxCount };
+                }
+            }
         }
+        SubmitCommands(pass, u, scatterVBO, 0, commands, commandCount);
+        };
+
+    if (ALLOC_TRACKING) {
+        AllocSnapshot startup = AllocSnapshot::Now();
+        std::cout << "[Startup] " << startup.allocations << " heap allocations (" << startup.bytes / 1024
+                  << " KB) before the first frame\n";
     }
 
     float lastFrame = 0.0f;
+    int frameIndex = 0;
+    // Frames since streaming last had work; the bench warms up and measures
+    // only settled frames, since loading lots allocates by design.
+    int settledFrames = 0;
+    int exitCode = 0;
+    double frameStart = glfwGetTime();
+    AllocSnapshot frameAllocMark = AllocSnapshot::Now();
 
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = (float)glfwGetTime();
         float deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        frameArena.Reset();
+        stats.BeginFrame((uint64_t)frameIndex);
+        stats.Current().mem.gpuTargetBytes = (uint64_t)countW * countH * (2 + 4);
+
         processInput(window, deltaTime);
+        bool streamBusy = streaming && UpdateStreaming();
 
-        glm::vec3 lightPos = center + glm::vec3(45.0f, 55.0f, 35.0f);
+        int w, h;
+        glfwGetFramebufferSize(window, &w, &h);
+        const float fovY = glm::radians(45.0f);
 
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
+        float cp = (float)std::cos((double)pitch);
+        float sp = (float)std::sin((double)pitch);
+        float cyv = (float)std::cos((double)yaw);
+        float syv = (float)std::sin((double)yaw);
+
+        glm::vec3 cameraPos;
+        cameraPos.x = focus.x + radius * cp * syv;
+        cameraPos.y = focus.y + radius * sp;
+        cameraPos.z = focus.z + radius * cp * cyv;
+        // The light keeps its place relative to the focus, like a sun.
+        glm::vec3 frameLightPos = lightPos + (focus - center);
+        const glm::vec4 windState(WC::WIND_DIR, opt.wind, currentFrame * 1.7f);
 
         float near_plane = 1.0f, far_plane = 200.0f;
         glm::mat4 lightProjection = glm::ortho(-100.0f, 100.0f, -100.0f, 100.0f, near_plane, far_plane);
-        glm::mat4 lightView = glm::lookAt(lightPos, center, glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 lightView = glm::lookAt(frameLightPos, focus, glm::vec3(0.0f, 1.0f, 0.0f));
         glm::mat4 lightSpaceMatrix = lightProjection * lightView;
+        Frustum lightFrustum = Frustum::FromMatrix(lightSpaceMatrix);
+
+        float aspect = (h == 0) ? 1.0f : (float)w / (float)h;
+        glm::mat4 projection = glm::perspective(fovY, aspect, 0.1f, farPlane);
+        glm::mat4 view = glm::lookAt(cameraPos, focus, glm::vec3(0, 1, 0));
+        Frustum cameraFrustum = Frustum::FromMatrix(projection * view);
+        float pixelsPerUnit = (float)std::max(h, 1) / (2.0f * std::tan(fovY * 0.5f));
+
+        UpdateDynamic(currentFrame, cameraFrustum, lightFrustum, cameraPos, pixelsPerUnit);
+
+        lodLevels = frameArena.AllocArray<uint32_t>(lodGroups.size());
+        for (size_t g = 0; g < lodGroups.size(); ++g) lodLevels[g] = lodGroups[g].Select(cameraPos, pixelsPerUnit, opt.lodPixelError);
+
+        // A lot past the impostor distance draws as its impostor; its shadow
+        // comes from the coarsest proxies.
+        proxyLodLevels = frameArena.AllocArray<uint32_t>(lodGroups.size());
+        std::copy(lodLevels, lodLevels + lodGroups.size(), proxyLodLevels);
+        uint32_t* activeImpostors = frameArena.AllocArray<uint32_t>(impostors.size());
+        size_t activeImpostorCount = 0;
+        for (size_t k = 0; k < impostors.size(); ++k) {
+            if (glm::length(cameraPos - impostors[k].center) <= opt.impostorDistance) continue;
+            for (uint32_t g : impostors[k].groups) {
+                lodLevels[g] = LOD_HIDDEN;
+                proxyLodLevels[g] = lodGroups[g].levelCount - 1;
+            }
+            activeImpostors[activeImpostorCount++] = (uint32_t)k;
+        }
+
+        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+        glClear(GL_DEPTH_BUFFER_BIT);
 
         glUseProgram(shadowShaderProgram);
         glUniformMatrix4fv(shadowLightSpaceMatrixLoc, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
-
-        glBindVertexArray(VAO);
-        for (const auto& it : items) {
-            glUniformMatrix4fv(shadowModelLoc, 1, GL_FALSE, glm::value_ptr(it.model));
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-        }
-        glBindVertexArray(0);
+        glUniform4fv(shadowUniforms.wind, 1, glm::value_ptr(windState));
+        stats.Uniforms(2);
+        DrawWorld(RenderPass::Shadow, lightFrustum, LAYER_CAST_SHADOW, shadowUniforms, 0u);
+        DrawDynamic(RenderPass::Shadow, lightFrustum, LAYER_CAST_SHADOW, shadowUniforms);
+        DrawScatter(RenderPass::Shadow, lightFrustum, shadowUniforms);
+
+        // The terrain shader applies projection * view; the light's matrix
+        // goes in whole.
+        glUseProgram(terrainShadowProgram);
+        glUniformMatrix4fv(terrainShadowUniforms.projection, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+        glUniformMatrix4fv(terrainShadowUniforms.view, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+        glUniform3fv(terrainShadowUniforms.lodEye, 1, glm::value_ptr(cameraPos));
+        stats.Uniforms(3);
+        DrawTerrain(RenderPass::Shadow, lightFrustum, cameraPos);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        int w, h;
-        glfwGetFramebufferSize(window, &w, &h);
         glViewport(0, 0, w, h);
         glClearColor(0.55f, 0.75f, 0.95f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
-
-        float aspect = (h == 0) ? 1.0f : (float)w / (float)h;
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 260.0f);
-
-        float cp = (float)std::cos((double)pitch);
-        float sp = (float)std::sin((double)pitch);
-        float cyv = (float)std::cos((double)yaw);
-        float syv = (float)std::sin((double)yaw);
-
-        glm::vec3 cameraPos;
-        cameraPos.x = center.x + radius * cp * syv;
-        cameraPos.y = center.y + radius * sp;
-        cameraPos.z = center.z + radius * cp * cyv;
+        if (debugView == DebugView::Overdraw || debugView == DebugView::TriDensity) {
+            bool wire = (debugView == DebugView::TriDensity);
+
+            ResizeCountTarget(w, h);
+            glBindFramebuffer(GL_FRAMEBUFFER, countFBO);
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            glDisable(GL_DEPTH_TEST);
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            if (wire) glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+            glUseProgram(countShaderProgram);
+            glUniformMatrix4fv(countProjLoc, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(countViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+            glUniform4fv(countUniforms.wind, 1, glm::value_ptr(windState));
+            stats.Uniforms(3);
+            DrawWorld(RenderPass::Debug, cameraFrustum, 0u, countUniforms, 0u);
+            DrawDynamic(RenderPass::Debug, cameraFrustum, 0u, countUniforms);
+            DrawScatter(RenderPass::Debug, cameraFrustum, countUniforms);
+            glUseProgram(terrainCountProgram);
+            glUniformMatrix4fv(terrainCountUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(terrainCountUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+            glUniform3fv(terrainCountUniforms.lodEye, 1, glm::value_ptr(cameraPos));
+            stats.Uniforms(3);
+            DrawTerrain(RenderPass::Debug, cameraFrustum, cameraPos);
+            glUseProgram(grassCountProgram);
+            glUniformMatrix4fv(grassCountUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(grassCountUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+            glUniform3fv(grassCountUniforms.lodEye, 1, glm::value_ptr(cameraPos));
+            stats.Uniforms(3);
+            DrawGrass(RenderPass::Debug, cameraFrustum, cameraPos, grassCountUniforms);
+
+            if (wire) glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            glDisable(GL_BLEND);
+            glEnable(GL_DEPTH_TEST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            glDisable(GL_DEPTH_TEST);
+            glUseProgram(heatmapShaderProgram);
+            glUniform1f(heatMaxCountLoc, wire ? 6.0f : 10.0f);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, countTexture);
+            glBindVertexArray(fullscreenVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+            stats.Uniforms(1);
+            stats.Draw(RenderPass::Debug, 1);
+            glEnable(GL_DEPTH_TEST);
+        }
+        else {
+            glUseProgram(shaderProgram);
+
+            glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+
+            glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
+            glUniform3fv(lightPosLoc, 1, glm::value_ptr(frameLightPos));
+            glUniform3fv(lightColorLoc, 1, glm::value_ptr(lightColor));
+            glUniform3fv(viewPosLoc, 1, glm::value_ptr(cameraPos));
+            glUniform1f(ambientLoc, 0.35f);
+            glUniform1f(specularLoc, 0.45f);
+            glUniform1f(shininessLoc, 64.0f);
+            glUniform1i(debugViewLoc, (int)debugView);
+            glUniform4fv(mainUniforms.wind, 1, glm::value_ptr(windState));
+
+            glUniformMatrix4fv(lightSpaceMatrixLoc, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, depthMapTexture);
+            stats.Uniforms(12);
+            DrawWorld(RenderPass::Main, cameraFrustum, 0u, mainUniforms, 0u);
+            DrawDynamic(RenderPass::Main, cameraFrustum, 0u, mainUniforms);
+            DrawScatter(RenderPass::Main, cameraFrustum, mainUniforms);
+
+            // After the items, so what stands on the ground hides it early.
+            glUseProgram(terrainProgram);
+            glUniformMatrix4fv(terrainUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(terrainUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(terrainUniforms.lightSpaceMatrix, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+            glUniform3fv(terrainUniforms.lodEye, 1, glm::value_ptr(cameraPos));
+            glUniform3fv(terrainUniforms.lightPos, 1, glm::value_ptr(frameLightPos));
+            glUniform3fv(terrainUniforms.lightColor, 1, glm::value_ptr(lightColor));
+            glUniform3fv(terrainUniforms.viewPos, 1, glm::value_ptr(cameraPos));
+            glUniform1f(terrainUniforms.ambient, 0.35f);
+            glUniform1f(terrainUniforms.specular, 0.10f);
+            glUniform1f(terrainUniforms.shininess, 16.0f);
+            glUniform1i(terrainUniforms.debugView, (int)debugView);
+            stats.Uniforms(11);
+            DrawTerrain(RenderPass::Main, cameraFrustum, cameraPos);
+
+            // Blades are not in the shadow map: too thin to cast much, and
+            // they take the shadows of everything else.
+            glUseProgram(grassProgram);
+            glUniformMatrix4fv(grassUniforms.projection, 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(grassUniforms.view, 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(grassUniforms.lightSpaceMatrix, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
+            glUniform3fv(grassUniforms.lodEye, 1, glm::value_ptr(cameraPos));
+            glUniform3fv(grassUniforms.lightPos, 1, glm::value_ptr(frameLightPos));
+            glUniform3fv(grassUniforms.lightColor, 1, glm::value_ptr(lightColor));
+            glUniform3fv(grassUniforms.viewPos, 1, glm::value_ptr(cameraPos));
+            glUniform1f(grassUniforms.ambient, 0.35f);
+            glUniform1f(grassUniforms.specular, 0.05f);
+            glUniform1f(grassUniforms.shininess, 16.0f);
+            glUniform1i(grassUniforms.debugView, (int)debugView);
+            stats.Uniforms(11);
+            DrawGrass(RenderPass::Main, cameraFrustum, cameraPos, grassUniforms);
+
+            size_t visibleImpostors = 0;
+            ImpostorInstance* impostorData = frameArena.AllocArray<ImpostorInstance>(activeImpostorCount);
+            for (size_t k = 0; k < activeImpostorCount; ++k) {
+                const Impostor& imp = impostors[activeImpostors[k]];
+                if (!cameraFrustum.IntersectsSphere(imp.center, imp.radius)) {
+                    stats.Current().Pass(RenderPass::Main).culled++;
+                    continue;
+                }
+                impostorData[visibleImpostors++] = { glm::vec4(imp.center, imp.radius), (float)imp.layer };
+            }
+            if (visibleImpostors > 0) {
+                glBindBuffer(GL_ARRAY_BUFFER, impostorInstanceVBO);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(visibleImpostors * sizeof(ImpostorInstance)), impostorData);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                stats.Upload(visibleImpostors * sizeof(ImpostorInstance));
+
+                glUseProgram(impostorProgram);
+                glUniformMatrix4fv(impostorProjLoc, 1, GL_FALSE, glm::value_ptr(projection));
+                glUniformMatrix4fv(impostorViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+                glUniform3fv(impostorViewPosLoc, 1, glm::value_ptr(cameraPos));
+                stats.Uniforms(3);
+                glBindVertexArray(impostorVAO);
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)visibleImpostors);
+                glBindVertexArray(0);
+                stats.Draw(RenderPass::Main, 2, (uint32_t)visibleImpostors);
+            }
+        }
 
-        glm::mat4 view = glm::lookAt(cameraPos, center, glm::vec3(0, 1, 0));
+        // Counts everything since the previous frame's mark, so the swap and
+        // event polling at the bottom of the loop are included too.
+        AllocSnapshot frameAllocs = AllocSnapshot::Now().Since(frameAllocMark);
+        frameAllocMark = AllocSnapshot::Now();
+        stats.Heap((uint32_t)frameAllocs.allocations, frameAllocs.bytes);
+        stats.Current().scratchBytes = frameArena.BytesUsed();
+        stats.Current().mem.cpuOtherBytes = meshes.MemoryBytes() + lodGroups.capacity() * sizeof(LodGroup) + frameArena.BytesReserved();
 
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+        double frameEnd = glfwGetTime();
+        stats.EndFrame((frameEnd - frameStart) * 1000.0);
+        frameStart = frameEnd;
 
-        glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
-        glUniform3fv(lightPosLoc, 1, glm::value_ptr(lightPos));
-        glUniform3fv(lightColorLoc, 1, glm::value_ptr(lightColor));
-        glUniform3fv(viewPosLoc, 1, glm::value_ptr(cameraPos));
-        glUniform1f(ambientLoc, 0.35f);
-        glUniform1f(specularLoc, 0.45f);
-        glUniform1f(shininessLoc, 64.0f);
+        if (opt.statsEvery > 0 && (frameIndex % opt.statsEvery) == 0) {
+            PrintFrameStats(stats.Last());
+        }
 
-        glUniformMatrix4fv(lightSpaceMatrixLoc, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, depthMapTexture);
+        ++frameIndex;
+        settledFrames = streamBusy ? 0 : settledFrames + 1;
+        if (opt.benchFrames > 0 && settledFrames > opt.benchWarmup) {
+            bench.Record(stats.Last());
+            if ((int)bench.frameMs.size() >= opt.benchFrames) {
+                bench.last = stats.Last();
+                bench.items = itemCount;
+                if (streaming) bench.lots = (uint32_t)streamedLots.size();
+                if (WriteBenchJson(opt.benchOut, bench)) {
+                    std::cout << "[Bench] " << bench.frameMs.size() << " frames -> " << opt.benchOut << "\n";
+                }
+                else {
+                    std::cerr << "Failed to write bench results: " << opt.benchOut << "\n";
+                }
+                if (!bench.allocTracked) {
+                    std::cout << "[Bench] heap allocations not checked (built with ALLOC_TRACKING=0)\n";
+                }
+                else if (!bench.AllocationFree()) {
+                    std::cerr << "[Bench] FAILED: " << bench.heapAllocs << " heap allocations in "
+                              << bench.allocatingFrames << " frames after warm-up (first at frame "
+                              << bench.firstAllocatingFrame << ")\n";
+                    exitCode = 1;
+                }
+                break;
+            }
+        }
 
-        glBindVertexArray(VAO);
-        for (const auto& it : items) {
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(it.model));
-            glUniform3fv(colorLoc, 1, glm::value_ptr(it.color));
-            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+        if (opt.capturePath && frameIndex >= opt.captureFrames) {
+            if (WriteFramebufferPPM(opt.capturePath, w, h)) {
+                std::cout << "[Capture] " << opt.capturePath << " (" << DebugViewName(debugView) << ")\n";
+            }
+            else {
+                std::cerr << "Failed to write capture: " << opt.capturePath << "\n";
+            }
+            break;
         }
-        glBindVertexArray(0);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    // Queued lots see the flag and skip their build, so this only waits for
+    // the ones already running.
+    streamStop = true;
+    streamPool.reset();
+
     glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteBuffers(1, &prefabTBO);
+    glDeleteTextures(1, &prefabTexture);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
     glDeleteProgram(shaderProgram);
     glDeleteProgram(shadowShaderProgram);
     glDeleteFramebuffers(1, &depthMapFBO);
     glDeleteTextures(1, &depthMapTexture);
+    glDeleteProgram(countShaderProgram);
+    glDeleteProgram(heatmapShaderProgram);
+    glDeleteFramebuffers(1, &countFBO);
+    glDeleteTextures(1, &countTexture);
+    glDeleteRenderbuffers(1, &countDepthRBO);
+    glDeleteVertexArrays(1, &fullscreenVAO);
+    glDeleteProgram(terrainProgram);
+    glDeleteProgram(terrainShadowProgram);
+    glDeleteProgram(terrainCountProgram);
+    glDeleteVertexArrays(1, &terrainVAO);
+    glDeleteBuffers(1, &terrainVBO);
+    glDeleteBuffers(1, &terrainEBO);
+    glDeleteBuffers(1, &terrainInstanceVBO);
+    glDeleteProgram(grassProgram);
+    glDeleteProgram(grassCountProgram);
+    glDeleteVertexArrays(1, &grassVAO);
+    glDeleteBuffers(1, &grassVBO);
+    glDeleteBuffers(1, &grassInstanceVBO);
+    glDeleteTextures(1, &tileStyleTexture);
+    if (scatterVBO) glDeleteBuffers(1, &scatterVBO);
+    glDeleteBuffers(1, &dynamicVBO);
+    if (impostorProgram) {
+        glDeleteProgram(impostorProgram);
+        glDeleteTextures(1, &impostorColorTex);
+        glDeleteTextures(1, &impostorDepthTex);
+        glDeleteVertexArrays(1, &impostorVAO);
+        glDeleteBuffers(1, &impostorQuadVBO);
+        glDeleteBuffers(1, &impostorInstanceVBO);
+    }
 
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+// Checks the closed-form and batch transform builders (TransformUtils.h)
+// against the glm translate * rotate * scale chain they replace. Needs only
+// glm and the headers in include/, no GL:
+//
+//   g++ -std=c++17 -O2 -Iinclude tests/TransformUtilsTest.cpp -o transform_test
+//   g++ -std=c++17 -O2 -mavx2 -Iinclude tests/TransformUtilsTest.cpp -o transform_test_avx2
+//
+// Returns non-zero when a check fails.
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "TransformUtils.h"
+#include "Random.h"
+
+namespace {
+
+int failures = 0;
+
+void Check(bool ok, const char* what) {
+    std::printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+    if (!ok) ++failures;
+}
+
+glm::mat4 Reference(glm::vec3 pos, const glm::vec3& rot, const glm::vec3& scl, TransformPivot pivot) {
+    if (pivot == TransformPivot::Bottom) pos.y += scl.y * 0.5f;
+    glm::mat4 m = glm::translate(glm::mat4(1.0f), pos);
+    m = glm::rotate(m, rot.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    m = glm::rotate(m, rot.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    m = glm::rotate(m, rot.x, glm::vec3(1.0f, 0.0f, 0.0f));
+    return glm::scale(m, scl);
+}
+
+glm::mat4 Scalar(const glm::vec3& pos, const glm::vec3& rot, const glm::vec3& scl, TransformPivot pivot) {
+    return pivot == TransformPivot::Bottom ? MakeModel_BottomPivot(pos, rot, scl) : MakeModel_CenterPivot(pos, rot, scl);
+}
+
+// Largest element difference, relative to the largest element of `ref`.
+float Diff(const glm::mat4& a, const glm::mat4& ref) {
+    float mag = 1.0f, d = 0.0f;
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            mag = std::max(mag, std::fabs(ref[c][r]));
+            d = std::max(d, std::fabs(a[c][r] - ref[c][r]));
+        }
+    }
+    return d / mag;
+}
+
+// `count` random transforms; every other block of eight is unrotated, the
+// batch fast path.
+TransformBatch RandomBatch(int count, uint64_t seed) {
+    Pcg32 rng(seed, 0x5452u);
+    TransformBatch batch;
+    batch.Reserve((size_t)count);
+    for (int i = 0; i < count; ++i) {
+        glm::vec3 pos(rng.Uniform(-200.0f, 200.0f), rng.Uniform(-200.0f, 200.0f), rng.Uniform(-200.0f, 200.0f));
+        glm::vec3 rot(0.0f);
+        if ((i / 8) % 2) rot = glm::vec3(rng.Uniform(-7.0f, 7.0f), rng.Uniform(-7.0f, 7.0f), rng.Uniform(-7.0f, 7.0f));
+        glm::vec3 scl(rng.Uniform(0.05f, 20.0f), rng.Uniform(0.05f, 20.0f), rng.Uniform(0.05f, 20.0f));
+        batch.Add(pos, rot, scl);
+    }
+    return batch;
+}
+
+void TestAgainstGlm(TransformPivot pivot, const char* name) {
+    // Not a multiple of eight, so the SIMD build runs its scalar tail too.
+    const int count = 100003;
+    TransformBatch batch = RandomBatch(count, 20251221u);
+    std::vector<glm::mat4> batched((size_t)count);
+    MakeModels(batch.View(), pivot, batched.data());
+
+    float batchErr = 0.0f, scalarErr = 0.0f;
+    bool zeroExact = true;
+    for (int i = 0; i < count; ++i) {
+        glm::vec3 pos(batch.posX[i], batch.posY[i], batch.posZ[i]);
+        glm::vec3 rot(batch.rotX[i], batch.rotY[i], batch.rotZ[i]);
+        glm::vec3 scl(batch.sclX[i], batch.sclY[i], batch.sclZ[i]);
+        glm::mat4 ref = Reference(pos, rot, scl, pivot);
+        glm::mat4 scalar = Scalar(pos, rot, scl, pivot);
+        batchErr = std::max(batchErr, Diff(batched[i], ref));
+        scalarErr = std::max(scalarErr, Diff(scalar, ref));
+        if (rot == glm::vec3(0.0f) && std::memcmp(&scalar, &ref, sizeof(glm::mat4)) != 0) zeroExact = false;
+    }
+
+    char what[96];
+    std::printf("%s pivot: batch %.2e, scalar %.2e (relative to glm)\n", name, batchErr, scalarErr);
+    std::snprintf(what, sizeof(what), "%s: batch (%s) matches glm within 1e-5", name, TransformSimdName());
+    Check(batchErr <= 1e-5f, what);
+    std::snprintf(what, sizeof(what), "%s: scalar matches glm within 1e-5", name);
+    Check(scalarErr <= 1e-5f, what);
+    std::snprintf(what, sizeof(what), "%s: zero rotation is bit-exact", name);
+    Check(zeroExact, what);
+}
+
+// Short batches never fill a SIMD block and must match the scalar builder.
+void TestShortBatches() {
+    bool ok = true;
+    for (int count = 0; count < 8; ++count) {
+        TransformBatch batch = RandomBatch(count, 7u + (uint64_t)count);
+        std::vector<glm::mat4> batched((size_t)count + 1);
+        batched[(size_t)count] = glm::mat4(-1.0f);
+        MakeModels(batch.View(), TransformPivot::Center, batched.data());
+        for (int i = 0; i < count; ++i) {
+            glm::vec3 pos(batch.posX[i], batch.posY[i], batch.posZ[i]);
+            glm::vec3 rot(batch.rotX[i], batch.rotY[i], batch.rotZ[i]);
+            glm::vec3 scl(batch.sclX[i], batch.sclY[i], batch.sclZ[i]);
+            ok = ok && Diff(batched[i], Scalar(pos, rot, scl, TransformPivot::Center)) <= 1e-6f;
+        }
+        ok = ok && batched[(size_t)count] == glm::mat4(-1.0f);
+    }
+    Check(ok, "batches of 0-7 match scalar, nothing written past");
+}
+
+} // namespace
+
+int main() {
+    TestAgainstGlm(TransformPivot::Center, "center");
+    TestAgainstGlm(TransformPivot::Bottom, "bottom");
+    TestShortBatches();
+    if (failures) std::printf("%d check(s) FAILED\n", failures);
+    return failures ? 1 : 0;
+}